@@ -185,6 +185,37 @@ void normals_calc_corners(Span<float3> vert_positions,
                           CornerNormalSpaceArray *r_lnors_spacearr,
                           MutableSpan<float3> r_corner_normals);
 
+/**
+ * Find the smooth fans of face corners around each vertex, split by sharp edges and faces.
+ * The result only depends on topology and sharpness, so it can be reused to calculate corner
+ * normals for any deformation of the same mesh.
+ */
+void corner_normal_fans_calc(Span<int2> edges,
+                             OffsetIndices<int> faces,
+                             Span<int> corner_verts,
+                             Span<int> corner_edges,
+                             Span<int> corner_to_face_map,
+                             Span<bool> sharp_edges,
+                             Span<bool> sharp_faces,
+                             CornerNormalFanCache &r_fans);
+
+/**
+ * Same as above, but using smooth fans precalculated with #corner_normal_fans_calc,
+ * so that no topology has to be traversed.
+ */
+void normals_calc_corners(const CornerNormalFanCache &fans,
+                          Span<float3> vert_positions,
+                          Span<int2> edges,
+                          OffsetIndices<int> faces,
+                          Span<int> corner_verts,
+                          Span<int> corner_edges,
+                          Span<int> corner_to_face_map,
+                          Span<float3> vert_normals,
+                          Span<float3> face_normals,
+                          const short2 *clnors_data,
+                          CornerNormalSpaceArray *r_lnors_spacearr,
+                          MutableSpan<float3> r_corner_normals);
+
 /**
  * \param sharp_faces: Optional array used to mark specific faces for sharp shading.
  */
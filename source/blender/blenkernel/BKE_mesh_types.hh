@@ -94,6 +94,25 @@ struct LooseEdgeCache : public LooseGeomCache {};
  */
 struct LooseVertCache : public LooseGeomCache {};
 
+/**
+ * The smooth fans of face corners around each vertex, used to calculate face corner normals.
+ * Fans only depend on topology and sharp edge/face tags, so they are cached separately from the
+ * normals and reused when only positions change. See #Mesh::corner_normals().
+ */
+struct CornerNormalFanCache {
+  /** Corners with sharp edges on both sides, which just use their face's normal. */
+  Array<int> single_corners;
+  /** Offsets into #fan_corners for each smooth fan of corners. */
+  Array<int> fan_offsets;
+  /** The corners of every fan, in the order they are reached winding around their vertex. */
+  Array<int> fan_corners;
+  /**
+   * For each fan corner, the vertex at the other end of the edge between it and the next corner
+   * in the fan.
+   */
+  Array<int> fan_edge_verts;
+};
+
 struct MeshRuntime {
   /**
    * "Evaluated" mesh owned by this mesh. Used for objects which don't have effective modifiers, so
@@ -185,6 +204,8 @@ struct MeshRuntime {
   SharedCache<Vector<float3>> face_normals_cache;
   /** Lazily computed face corner normals (#Mesh::corner_normals()). */
   SharedCache<Vector<float3>> corner_normals_cache;
+  /** Lazily computed smooth corner fans, used to calculate #corner_normals_cache. */
+  SharedCache<CornerNormalFanCache> corner_normal_fans_cache;
 
   /**
    * Cache of offsets for vert to face/corner maps. The same offsets array is used to group
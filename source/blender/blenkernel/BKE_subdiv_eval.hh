@@ -8,11 +8,14 @@
 
 #pragma once
 
+#include "BLI_math_vector_types.hh"
+#include "BLI_span.hh"
 #include "BLI_sys_types.h"
 
 struct Mesh;
 struct OpenSubdiv_EvaluatorCache;
 struct OpenSubdiv_EvaluatorSettings;
+struct OpenSubdiv_PatchCoord;
 
 namespace blender::bke::subdiv {
 
@@ -59,6 +62,15 @@ void eval_limit_point_and_derivatives(Subdiv *subdiv,
 void eval_limit_point_and_normal(
     Subdiv *subdiv, int ptex_face_index, float u, float v, float r_P[3], float r_N[3]);
 
+/* Batched queries. */
+
+/* Evaluate points at a limit surface for all given patch coordinates at once.
+ * Gives the same result as #eval_limit_point for every coordinate, but avoids the per-point
+ * overhead of the evaluator. */
+void eval_limit_points(Subdiv *subdiv,
+                       Span<OpenSubdiv_PatchCoord> patch_coords,
+                       MutableSpan<float3> r_P);
+
 /* Evaluate smoothly interpolated vertex data (such as ORCO). */
 void eval_vertex_data(Subdiv *subdiv,
                       const int ptex_face_index,
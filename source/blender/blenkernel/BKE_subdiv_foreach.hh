@@ -104,10 +104,10 @@ struct ForeachContext {
    */
   ForeachVertexFromCornerCb vertex_every_corner;
   ForeachVertexFromEdgeCb vertex_every_edge;
-  /* Those callbacks are run once per subdivision vertex, ptex is undefined
-   * as in it will be whatever first ptex face happened to be traversed in
-   * the multi-threaded environment and which shares "emitting" vertex or
-   * edge.
+  /* Those callbacks are run once per subdivision vertex, from the ptex of the
+   * first coarse face which shares "emitting" vertex or edge. They are called
+   * from multiple threads, so they must only write data of the given
+   * subdivision vertex.
    */
   ForeachVertexFromCornerCb vertex_corner;
   ForeachVertexFromEdgeCb vertex_edge;
@@ -393,6 +393,13 @@ static void data_transfer_dtdata_type_postprocess(Mesh *me_dst,
     sharp_edges.finish();
     CustomData_free_layers(ldata_dst, CD_NORMAL, me_dst->corners_num);
   }
+  else if (ELEM(dtdata_type, DT_TYPE_SHARP_EDGE, DT_TYPE_SHARP_FACE)) {
+    if (!changed) {
+      return;
+    }
+    /* The layers are written directly, not through the attribute API which tags the mesh. */
+    me_dst->tag_sharpness_changed();
+  }
 }
 
 /* ********** */
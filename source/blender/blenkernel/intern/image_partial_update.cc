@@ -47,6 +47,7 @@
  * \endcode
  */
 
+#include <mutex>
 #include <optional>
 
 #include "BKE_image.h"
@@ -455,6 +456,14 @@ struct PartialUpdateRegisterImpl {
   }
 };
 
+/**
+ * \brief Guards the registers of all images.
+ *
+ * Changes are marked and collected from different threads, for example when the compositor job
+ * reads an image that is painted on the main thread.
+ */
+static std::mutex partial_update_mutex;
+
 static PartialUpdateRegister *image_partial_update_register_ensure(Image *image)
 {
   if (image->runtime.partial_update_register == nullptr) {
@@ -475,6 +484,7 @@ ePartialUpdateCollectResult BKE_image_partial_update_collect_changes(Image *imag
 
   user_impl->clear_updated_regions();
 
+  std::scoped_lock lock(partial_update_mutex);
   PartialUpdateRegisterImpl *partial_updater = unwrap(image_partial_update_register_ensure(image));
   partial_updater->ensure_empty_changeset();
 
@@ -565,6 +575,7 @@ void BKE_image_partial_update_free(PartialUpdateUser *user)
 
 void BKE_image_partial_update_register_free(Image *image)
 {
+  std::scoped_lock lock(partial_update_mutex);
   PartialUpdateRegisterImpl *partial_update_register = unwrap(
       image->runtime.partial_update_register);
   if (partial_update_register) {
@@ -578,6 +589,7 @@ void BKE_image_partial_update_mark_region(Image *image,
                                           const ImBuf *image_buffer,
                                           const rcti *updated_region)
 {
+  std::scoped_lock lock(partial_update_mutex);
   PartialUpdateRegisterImpl *partial_updater = unwrap(image_partial_update_register_ensure(image));
   partial_updater->update_resolution(image_tile, image_buffer);
   partial_updater->mark_region(image_tile, updated_region);
@@ -585,6 +597,7 @@ void BKE_image_partial_update_mark_region(Image *image,
 
 void BKE_image_partial_update_mark_full_update(Image *image)
 {
+  std::scoped_lock lock(partial_update_mutex);
   PartialUpdateRegisterImpl *partial_updater = unwrap(image_partial_update_register_ensure(image));
   partial_updater->mark_full_update();
 }
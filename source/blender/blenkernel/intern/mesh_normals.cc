@@ -290,7 +290,20 @@ blender::Span<blender::float3> Mesh::corner_normals() const
         const VArraySpan sharp_faces = *attributes.lookup<bool>("sharp_face", AttrDomain::Face);
         const short2 *custom_normals = static_cast<const short2 *>(
             CustomData_get_layer(&this->corner_data, CD_CUSTOMLOOPNORMAL));
-        mesh::normals_calc_corners(this->vert_positions(),
+        /* The smooth fans are only invalidated by topology or sharpness changes, so they are
+         * reused for every deformation of the mesh. */
+        this->runtime->corner_normal_fans_cache.ensure([&](CornerNormalFanCache &r_fans) {
+          mesh::corner_normal_fans_calc(this->edges(),
+                                        this->faces(),
+                                        this->corner_verts(),
+                                        this->corner_edges(),
+                                        this->corner_to_face_map(),
+                                        sharp_edges,
+                                        sharp_faces,
+                                        r_fans);
+        });
+        mesh::normals_calc_corners(this->runtime->corner_normal_fans_cache.data(),
+                                   this->vert_positions(),
                                    this->edges(),
                                    this->faces(),
                                    this->corner_verts(),
@@ -298,8 +311,6 @@ blender::Span<blender::float3> Mesh::corner_normals() const
                                    this->corner_to_face_map(),
                                    this->vert_normals(),
                                    this->face_normals(),
-                                   sharp_edges,
-                                   sharp_faces,
                                    custom_normals,
                                    nullptr,
                                    r_data);
@@ -634,7 +645,6 @@ struct CornerSplitTaskDataCommon {
   Span<int> corner_verts;
   Span<int> corner_edges;
   OffsetIndices<int> faces;
-  Span<int2> edge_to_corners;
   Span<int> corner_to_face;
   Span<float3> face_normals;
   Span<float3> vert_normals;
@@ -876,8 +886,63 @@ static void lnor_space_for_single_fan(CornerSplitTaskDataCommon *common_data,
   }
 }
 
+/**
+ * Walk around the vertex of \a corner until the other non-smooth edge is found (or a full turn is
+ * done around a smooth vertex), calling \a fn with every corner in the fan and the vertex at the
+ * other end of the edge leading to the next corner.
+ */
+template<typename Fn>
+static void foreach_corner_in_fan(const Span<int2> edges,
+                                  const OffsetIndices<int> faces,
+                                  const Span<int> corner_verts,
+                                  const Span<int> corner_edges,
+                                  const Span<int2> edge_to_corners,
+                                  const Span<int> corner_to_face,
+                                  const int corner,
+                                  const Fn &fn)
+{
+  const int face_index = corner_to_face[corner];
+  const int corner_prev = face_corner_prev(faces[face_index], corner);
+
+  /* The vertex we are "fanning" around! */
+  const int vert_pivot = corner_verts[corner];
+
+  /* `corner` would be `corner_prev` if we needed that one. */
+  const int2 &edge_orig = edges[corner_edges[corner]];
+
+  /* `vert_corner` the corner of our current edge might not be the corner of our current
+   * vertex!
+   */
+  int fan_corner = corner_prev;
+  int vert_corner = corner;
+
+  BLI_assert(fan_corner >= 0);
+  BLI_assert(vert_corner >= 0);
+
+  while (true) {
+    const int2 &edge = edges[corner_edges[fan_corner]];
+    fn(vert_corner, edge_other_vert(edge, vert_pivot));
+
+    if (IS_EDGE_SHARP(edge_to_corners[corner_edges[fan_corner]]) || (edge == edge_orig)) {
+      /* Current edge is sharp and we have finished with this fan of faces around this vert,
+       * or this vert is smooth, and we have completed a full turn around it. */
+      break;
+    }
+
+    /* Find next corner of the smooth fan. */
+    corner_manifold_fan_around_vert_next(corner_verts,
+                                         faces,
+                                         corner_to_face,
+                                         edge_to_corners[corner_edges[fan_corner]],
+                                         vert_pivot,
+                                         &fan_corner,
+                                         &vert_corner);
+  }
+}
+
 static void split_corner_normal_fan_do(CornerSplitTaskDataCommon *common_data,
-                                       const int corner,
+                                       const Span<int> fan_corners,
+                                       const Span<int> fan_edge_verts,
                                        const int space_index,
                                        Vector<float3, 16> *edge_vectors)
 {
@@ -886,105 +951,56 @@ static void split_corner_normal_fan_do(CornerSplitTaskDataCommon *common_data,
 
   const Span<float3> positions = common_data->positions;
   const Span<int2> edges = common_data->edges;
-  const OffsetIndices faces = common_data->faces;
   const Span<int> corner_verts = common_data->corner_verts;
   const Span<int> corner_edges = common_data->corner_edges;
-  const Span<int2> edge_to_corners = common_data->edge_to_corners;
   const Span<int> corner_to_face = common_data->corner_to_face;
   const Span<float3> face_normals = common_data->face_normals;
   const Span<short2> clnors_data = common_data->clnors_data;
 
-  const int face_index = corner_to_face[corner];
-  const int corner_prev = face_corner_prev(faces[face_index], corner);
-
-  /* Sigh! we have to fan around current vertex, until we find the other non-smooth edge,
-   * and accumulate face normals into the vertex!
+  /* Accumulate the face normals of the fan into the vertex. All topology was gathered beforehand
+   * by #foreach_corner_in_fan, so this is a flat loop over the fan's corners.
    * Note in case this vertex has only one sharp edges, this is a waste because the normal is the
    * same as the vertex normal, but I do not see any easy way to detect that (would need to count
    * number of sharp edges per vertex, I doubt the additional memory usage would be worth it,
    * especially as it should not be a common case in real-life meshes anyway). */
+  const int corner = fan_corners.first();
   const int vert_pivot = corner_verts[corner]; /* The vertex we are "fanning" around! */
+  const float3 &pivot_position = positions[vert_pivot];
+  const int vert_orig = edge_other_vert(edges[corner_edges[corner]], vert_pivot);
 
-  /* `corner` would be `corner_prev` if we needed that one. */
-  const int2 &edge_orig = edges[corner_edges[corner]];
-
-  float3 vec_curr;
-  float3 vec_prev;
-  float3 vec_org;
+  /* Only need to compute previous edge's vector once, then we can just reuse old current one! */
+  const float3 vec_org = math::normalize(positions[vert_orig] - pivot_position);
+  float3 vec_prev = vec_org;
+  float3 vec_curr = vec_org;
   float3 lnor(0.0f);
 
   int2 clnors_avg(0);
 
-  Vector<int, 32> processed_corners;
-
-  /* `vert_corner` the corner of our current edge might not be the corner of our current
-   * vertex!
-   */
-  int fan_corner = corner_prev;
-  int vert_corner = corner;
-
-  BLI_assert(fan_corner >= 0);
-  BLI_assert(vert_corner >= 0);
-
-  /* Only need to compute previous edge's vector once, then we can just reuse old current one! */
-  {
-    const int vert_2 = edge_other_vert(edge_orig, vert_pivot);
-    vec_org = math::normalize(positions[vert_2] - positions[vert_pivot]);
-    vec_prev = vec_org;
-
-    if (lnors_spacearr) {
-      edge_vectors->append(vec_org);
-    }
+  if (lnors_spacearr) {
+    edge_vectors->append(vec_org);
   }
 
-  while (true) {
-    const int2 &edge = edges[corner_edges[fan_corner]];
-    /* Compute edge vectors.
-     * NOTE: We could pre-compute those into an array, in the first iteration, instead of computing
-     *       them twice (or more) here. However, time gained is not worth memory and time lost,
-     *       given the fact that this code should not be called that much in real-life meshes.
-     */
-    {
-      const int vert_2 = edge_other_vert(edge, vert_pivot);
-      vec_curr = math::normalize(positions[vert_2] - positions[vert_pivot]);
-    }
+  for (const int i : fan_corners.index_range()) {
+    const int vert_corner = fan_corners[i];
+    vec_curr = math::normalize(positions[fan_edge_verts[i]] - pivot_position);
 
     /* Code similar to accumulate_vertex_normals_poly_v3. */
     /* Calculate angle between the two face edges incident on this vertex. */
-    lnor += face_normals[corner_to_face[fan_corner]] *
+    lnor += face_normals[corner_to_face[vert_corner]] *
             math::safe_acos_approx(math::dot(vec_curr, vec_prev));
 
-    processed_corners.append(vert_corner);
-
     if (lnors_spacearr) {
-      if (edge != edge_orig) {
+      /* The last edge of a cyclic fan is the original edge, which was already stored. */
+      if (i < fan_corners.size() - 1 || fan_edge_verts[i] != vert_orig) {
         /* We store here all edges-normalized vectors processed. */
         edge_vectors->append(vec_curr);
       }
-      if (!lnors_spacearr->corners_by_space.is_empty()) {
-        lnors_spacearr->corners_by_space[space_index] = processed_corners.as_span();
-      }
       if (!clnors_data.is_empty()) {
         clnors_avg += int2(clnors_data[vert_corner]);
       }
     }
 
-    if (IS_EDGE_SHARP(edge_to_corners[corner_edges[fan_corner]]) || (edge == edge_orig)) {
-      /* Current edge is sharp and we have finished with this fan of faces around this vert,
-       * or this vert is smooth, and we have completed a full turn around it. */
-      break;
-    }
-
     vec_prev = vec_curr;
-
-    /* Find next corner of the smooth fan. */
-    corner_manifold_fan_around_vert_next(corner_verts,
-                                         faces,
-                                         corner_to_face,
-                                         edge_to_corners[corner_edges[fan_corner]],
-                                         vert_pivot,
-                                         &fan_corner,
-                                         &vert_corner);
   }
 
   float length;
@@ -996,18 +1012,20 @@ static void split_corner_normal_fan_do(CornerSplitTaskDataCommon *common_data,
   if (lnors_spacearr) {
     if (UNLIKELY(length == 0.0f)) {
       /* Use vertex normal as fallback! */
-      lnor = corner_normals[vert_corner];
+      lnor = corner_normals[fan_corners.last()];
       length = 1.0f;
     }
 
     CornerNormalSpace &lnor_space = lnors_spacearr->spaces[space_index];
     lnor_space = corner_fan_space_define(lnor, vec_org, vec_curr, *edge_vectors);
-    lnors_spacearr->corner_space_indices.as_mutable_span().fill_indices(
-        processed_corners.as_span(), space_index);
+    lnors_spacearr->corner_space_indices.as_mutable_span().fill_indices(fan_corners, space_index);
+    if (!lnors_spacearr->corners_by_space.is_empty()) {
+      lnors_spacearr->corners_by_space[space_index] = fan_corners;
+    }
     edge_vectors->clear();
 
     if (!clnors_data.is_empty()) {
-      clnors_avg /= processed_corners.size();
+      clnors_avg /= fan_corners.size();
       lnor = corner_space_custom_data_to_normal(lnor_space, short2(clnors_avg));
     }
   }
@@ -1015,7 +1033,7 @@ static void split_corner_normal_fan_do(CornerSplitTaskDataCommon *common_data,
   /* In case we get a zero normal here, just use vertex normal already set! */
   if (LIKELY(length != 0.0f)) {
     /* Copy back the final computed normal into all related corner-normals. */
-    corner_normals.fill_indices(processed_corners.as_span(), lnor);
+    corner_normals.fill_indices(fan_corners, lnor);
   }
 }
 
@@ -1082,16 +1100,14 @@ static bool corner_split_generator_check_cyclic_smooth_fan(const Span<int> corne
   }
 }
 
-static void corner_split_generator(CornerSplitTaskDataCommon *common_data,
+static void corner_split_generator(const OffsetIndices<int> faces,
+                                   const Span<int> corner_verts,
+                                   const Span<int> corner_edges,
+                                   const Span<int> corner_to_face,
+                                   const Span<int2> edge_to_corners,
                                    Vector<int, 32> &r_single_corners,
                                    Vector<int, 32> &r_fan_corners)
 {
-  const Span<int> corner_verts = common_data->corner_verts;
-  const Span<int> corner_edges = common_data->corner_edges;
-  const OffsetIndices faces = common_data->faces;
-  const Span<int> corner_to_face = common_data->corner_to_face;
-  const Span<int2> edge_to_corners = common_data->edge_to_corners;
-
   BitVector<> skip_corners(corner_verts.size(), false);
 
 #ifdef DEBUG_TIME
@@ -1163,19 +1179,14 @@ static void corner_split_generator(CornerSplitTaskDataCommon *common_data,
   }
 }
 
-void normals_calc_corners(const Span<float3> vert_positions,
-                          const Span<int2> edges,
-                          const OffsetIndices<int> faces,
-                          const Span<int> corner_verts,
-                          const Span<int> corner_edges,
-                          const Span<int> corner_to_face_map,
-                          const Span<float3> vert_normals,
-                          const Span<float3> face_normals,
-                          const Span<bool> sharp_edges,
-                          const Span<bool> sharp_faces,
-                          const short2 *clnors_data,
-                          CornerNormalSpaceArray *r_lnors_spacearr,
-                          MutableSpan<float3> r_corner_normals)
+void corner_normal_fans_calc(const Span<int2> edges,
+                             const OffsetIndices<int> faces,
+                             const Span<int> corner_verts,
+                             const Span<int> corner_edges,
+                             const Span<int> corner_to_face_map,
+                             const Span<bool> sharp_edges,
+                             const Span<bool> sharp_faces,
+                             CornerNormalFanCache &r_fans)
 {
   /**
    * Mapping edge -> corners.
@@ -1193,6 +1204,87 @@ void normals_calc_corners(const Span<float3> vert_positions,
    * Note also that loose edges always have both values set to 0! */
   Array<int2> edge_to_corners(edges.size(), int2(0));
 
+#ifdef DEBUG_TIME
+  SCOPED_TIMER_AVERAGED(__func__);
+#endif
+
+  /* This first corner check which edges are actually smooth, and compute edge vectors. */
+  build_edge_to_corner_map_with_flip_and_sharp(
+      faces, corner_verts, corner_edges, sharp_faces, sharp_edges, edge_to_corners);
+
+  Vector<int, 32> single_corners;
+  Vector<int, 32> fan_start_corners;
+  corner_split_generator(faces,
+                         corner_verts,
+                         corner_edges,
+                         corner_to_face_map,
+                         edge_to_corners,
+                         single_corners,
+                         fan_start_corners);
+
+  r_fans.single_corners = single_corners.as_span();
+
+  /* Walk every fan twice, first to count its corners, then to store them in flat arrays. */
+  r_fans.fan_offsets.reinitialize(fan_start_corners.size() + 1);
+  MutableSpan<int> fan_sizes = r_fans.fan_offsets.as_mutable_span().drop_back(1);
+  threading::parallel_for(fan_start_corners.index_range(), 1024, [&](const IndexRange range) {
+    for (const int i : range) {
+      int size = 0;
+      foreach_corner_in_fan(edges,
+                            faces,
+                            corner_verts,
+                            corner_edges,
+                            edge_to_corners,
+                            corner_to_face_map,
+                            fan_start_corners[i],
+                            [&](const int /*corner*/, const int /*vert*/) { size++; });
+      fan_sizes[i] = size;
+    }
+  });
+  const OffsetIndices fans = offset_indices::accumulate_counts_to_offsets(r_fans.fan_offsets);
+
+  r_fans.fan_corners.reinitialize(fans.total_size());
+  r_fans.fan_edge_verts.reinitialize(fans.total_size());
+  threading::parallel_for(fan_start_corners.index_range(), 1024, [&](const IndexRange range) {
+    for (const int i : range) {
+      int index = fans[i].start();
+      foreach_corner_in_fan(edges,
+                            faces,
+                            corner_verts,
+                            corner_edges,
+                            edge_to_corners,
+                            corner_to_face_map,
+                            fan_start_corners[i],
+                            [&](const int corner, const int vert) {
+                              r_fans.fan_corners[index] = corner;
+                              r_fans.fan_edge_verts[index] = vert;
+                              index++;
+                            });
+    }
+  });
+}
+
+/**
+ * Compute the normals of all single corners and smooth fans. \a fan_fn is called with the index of
+ * every fan, its space index and a thread local buffer, and must call
+ * #split_corner_normal_fan_do with the corners of the fan.
+ */
+template<typename FanFn>
+static void normals_calc_corners_impl(const Span<float3> vert_positions,
+                                      const Span<int2> edges,
+                                      const OffsetIndices<int> faces,
+                                      const Span<int> corner_verts,
+                                      const Span<int> corner_edges,
+                                      const Span<int> corner_to_face_map,
+                                      const Span<float3> vert_normals,
+                                      const Span<float3> face_normals,
+                                      const short2 *clnors_data,
+                                      const Span<int> single_corners,
+                                      const int fans_num,
+                                      CornerNormalSpaceArray *r_lnors_spacearr,
+                                      MutableSpan<float3> r_corner_normals,
+                                      const FanFn &fan_fn)
+{
   CornerNormalSpaceArray _lnors_spacearr;
 
 #ifdef DEBUG_TIME
@@ -1214,7 +1306,6 @@ void normals_calc_corners(const Span<float3> vert_positions,
   common_data.faces = faces;
   common_data.corner_verts = corner_verts;
   common_data.corner_edges = corner_edges;
-  common_data.edge_to_corners = edge_to_corners;
   common_data.corner_to_face = corner_to_face_map;
   common_data.face_normals = face_normals;
   common_data.vert_normals = vert_normals;
@@ -1223,16 +1314,8 @@ void normals_calc_corners(const Span<float3> vert_positions,
    * This way we don't have to compute those later! */
   array_utils::gather(vert_normals, corner_verts, r_corner_normals, 1024);
 
-  /* This first corner check which edges are actually smooth, and compute edge vectors. */
-  build_edge_to_corner_map_with_flip_and_sharp(
-      faces, corner_verts, corner_edges, sharp_faces, sharp_edges, edge_to_corners);
-
-  Vector<int, 32> single_corners;
-  Vector<int, 32> fan_corners;
-  corner_split_generator(&common_data, single_corners, fan_corners);
-
   if (r_lnors_spacearr) {
-    r_lnors_spacearr->spaces.reinitialize(single_corners.size() + fan_corners.size());
+    r_lnors_spacearr->spaces.reinitialize(single_corners.size() + fans_num);
     r_lnors_spacearr->corner_space_indices = Array<int>(corner_verts.size(), -1);
     if (r_lnors_spacearr->create_corners_by_space) {
       r_lnors_spacearr->corners_by_space.reinitialize(r_lnors_spacearr->spaces.size());
@@ -1246,16 +1329,122 @@ void normals_calc_corners(const Span<float3> vert_positions,
     }
   });
 
-  threading::parallel_for(fan_corners.index_range(), 1024, [&](const IndexRange range) {
+  threading::parallel_for(IndexRange(fans_num), 1024, [&](const IndexRange range) {
     Vector<float3, 16> edge_vectors;
     for (const int i : range) {
-      const int corner = fan_corners[i];
-      const int space_index = single_corners.size() + i;
-      split_corner_normal_fan_do(&common_data, corner, space_index, &edge_vectors);
+      fan_fn(&common_data, i, single_corners.size() + i, &edge_vectors);
     }
   });
 }
 
+void normals_calc_corners(const CornerNormalFanCache &fans,
+                          const Span<float3> vert_positions,
+                          const Span<int2> edges,
+                          const OffsetIndices<int> faces,
+                          const Span<int> corner_verts,
+                          const Span<int> corner_edges,
+                          const Span<int> corner_to_face_map,
+                          const Span<float3> vert_normals,
+                          const Span<float3> face_normals,
+                          const short2 *clnors_data,
+                          CornerNormalSpaceArray *r_lnors_spacearr,
+                          MutableSpan<float3> r_corner_normals)
+{
+  const OffsetIndices<int> fan_offsets = fans.fan_offsets.as_span();
+  normals_calc_corners_impl(
+      vert_positions,
+      edges,
+      faces,
+      corner_verts,
+      corner_edges,
+      corner_to_face_map,
+      vert_normals,
+      face_normals,
+      clnors_data,
+      fans.single_corners,
+      fan_offsets.size(),
+      r_lnors_spacearr,
+      r_corner_normals,
+      [&](CornerSplitTaskDataCommon *common_data,
+          const int fan,
+          const int space_index,
+          Vector<float3, 16> *edge_vectors) {
+        split_corner_normal_fan_do(common_data,
+                                   fans.fan_corners.as_span().slice(fan_offsets[fan]),
+                                   fans.fan_edge_verts.as_span().slice(fan_offsets[fan]),
+                                   space_index,
+                                   edge_vectors);
+      });
+}
+
+void normals_calc_corners(const Span<float3> vert_positions,
+                          const Span<int2> edges,
+                          const OffsetIndices<int> faces,
+                          const Span<int> corner_verts,
+                          const Span<int> corner_edges,
+                          const Span<int> corner_to_face_map,
+                          const Span<float3> vert_normals,
+                          const Span<float3> face_normals,
+                          const Span<bool> sharp_edges,
+                          const Span<bool> sharp_faces,
+                          const short2 *clnors_data,
+                          CornerNormalSpaceArray *r_lnors_spacearr,
+                          MutableSpan<float3> r_corner_normals)
+{
+  /* Mapping edge -> corners. See #corner_normal_fans_calc for details. */
+  Array<int2> edge_to_corners(edges.size(), int2(0));
+
+  /* This first corner check which edges are actually smooth, and compute edge vectors. */
+  build_edge_to_corner_map_with_flip_and_sharp(
+      faces, corner_verts, corner_edges, sharp_faces, sharp_edges, edge_to_corners);
+
+  Vector<int, 32> single_corners;
+  Vector<int, 32> fan_start_corners;
+  corner_split_generator(faces,
+                         corner_verts,
+                         corner_edges,
+                         corner_to_face_map,
+                         edge_to_corners,
+                         single_corners,
+                         fan_start_corners);
+
+  /* Without a cache, every fan is walked once, directly before its normal is computed. */
+  normals_calc_corners_impl(
+      vert_positions,
+      edges,
+      faces,
+      corner_verts,
+      corner_edges,
+      corner_to_face_map,
+      vert_normals,
+      face_normals,
+      clnors_data,
+      single_corners,
+      fan_start_corners.size(),
+      r_lnors_spacearr,
+      r_corner_normals,
+      [&](CornerSplitTaskDataCommon *common_data,
+          const int fan,
+          const int space_index,
+          Vector<float3, 16> *edge_vectors) {
+        Vector<int, 32> fan_corners;
+        Vector<int, 32> fan_edge_verts;
+        foreach_corner_in_fan(edges,
+                              faces,
+                              corner_verts,
+                              corner_edges,
+                              edge_to_corners,
+                              corner_to_face_map,
+                              fan_start_corners[fan],
+                              [&](const int corner, const int vert) {
+                                fan_corners.append(corner);
+                                fan_edge_verts.append(vert);
+                              });
+        split_corner_normal_fan_do(
+            common_data, fan_corners, fan_edge_verts, space_index, edge_vectors);
+      });
+}
+
 #undef INDEX_UNSET
 #undef INDEX_INVALID
 #undef IS_EDGE_SHARP
@@ -0,0 +1,148 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include "DNA_mesh_types.h"
+
+#include "BKE_attribute.hh"
+#include "BKE_customdata.hh"
+#include "BKE_idtype.hh"
+#include "BKE_lib_id.hh"
+#include "BKE_mesh.h"
+#include "BKE_mesh.hh"
+#include "BKE_mesh_mapping.hh"
+
+namespace blender::bke::tests {
+
+class MeshNormalsTest : public ::testing::Test {
+ public:
+  static void SetUpTestSuite()
+  {
+    BKE_idtype_init();
+  }
+};
+
+/** A unit cube with outward facing quads. */
+static Mesh *create_cube_mesh()
+{
+  Mesh *mesh = BKE_mesh_new_nomain(8, 0, 6, 24);
+  MutableSpan<float3> positions = mesh->vert_positions_for_write();
+  for (const int z : IndexRange(2)) {
+    positions[z * 4 + 0] = float3(0, 0, z);
+    positions[z * 4 + 1] = float3(1, 0, z);
+    positions[z * 4 + 2] = float3(1, 1, z);
+    positions[z * 4 + 3] = float3(0, 1, z);
+  }
+  offset_indices::fill_constant_group_size(4, 0, mesh->face_offsets_for_write());
+  mesh->corner_verts_for_write().copy_from({0, 3, 2, 1, 4, 5, 6, 7, 0, 1, 5, 4,
+                                            1, 2, 6, 5, 2, 3, 7, 6, 3, 0, 4, 7});
+  mesh_calc_edges(*mesh, false, false);
+  return mesh;
+}
+
+/** Calculate the corner normals without using the mesh's caches. */
+static Array<float3> calc_corner_normals_uncached(const Mesh &mesh,
+                                                  mesh::CornerNormalSpaceArray *r_spaces)
+{
+  const AttributeAccessor attributes = mesh.attributes();
+  const VArraySpan sharp_edges = *attributes.lookup<bool>("sharp_edge", AttrDomain::Edge);
+  const VArraySpan sharp_faces = *attributes.lookup<bool>("sharp_face", AttrDomain::Face);
+  const Array<int> corner_to_face = mesh::build_corner_to_face_map(mesh.faces());
+  Array<float3> face_normals(mesh.faces_num);
+  mesh::normals_calc_faces(mesh.vert_positions(), mesh.faces(), mesh.corner_verts(), face_normals);
+  Array<float3> corner_normals(mesh.corners_num);
+  mesh::normals_calc_corners(mesh.vert_positions(),
+                             mesh.edges(),
+                             mesh.faces(),
+                             mesh.corner_verts(),
+                             mesh.corner_edges(),
+                             corner_to_face,
+                             mesh.vert_normals(),
+                             face_normals,
+                             sharp_edges,
+                             sharp_faces,
+                             nullptr,
+                             r_spaces,
+                             corner_normals);
+  return corner_normals;
+}
+
+static void expect_normals_near(const Span<float3> a, const Span<float3> b)
+{
+  ASSERT_EQ(a.size(), b.size());
+  for (const int i : a.index_range()) {
+    EXPECT_NEAR(a[i].x, b[i].x, 1e-5f);
+    EXPECT_NEAR(a[i].y, b[i].y, 1e-5f);
+    EXPECT_NEAR(a[i].z, b[i].z, 1e-5f);
+  }
+}
+
+TEST_F(MeshNormalsTest, CachedFansMatchUncached)
+{
+  Mesh *mesh = create_cube_mesh();
+  MutableAttributeAccessor attributes = mesh->attributes_for_write();
+  SpanAttributeWriter sharp_edges = attributes.lookup_or_add_for_write_span<bool>(
+      "sharp_edge", AttrDomain::Edge);
+  sharp_edges.span[0] = true;
+  sharp_edges.span[5] = true;
+  sharp_edges.finish();
+
+  mesh::CornerNormalSpaceArray spaces;
+  spaces.create_corners_by_space = true;
+  expect_normals_near(mesh->corner_normals(), calc_corner_normals_uncached(*mesh, &spaces));
+
+  /* The same fans are used for the cached normals of a deformed mesh. */
+  mesh->vert_positions_for_write()[6] += float3(0.5f, 0.2f, 0.7f);
+  mesh->tag_positions_changed();
+  expect_normals_near(mesh->corner_normals(), calc_corner_normals_uncached(*mesh, nullptr));
+
+  /* The fans stored in the cache are the ones walked by the uncached calculation. */
+  const VArraySpan sharp_edges_span = *attributes.lookup<bool>("sharp_edge", AttrDomain::Edge);
+  CornerNormalFanCache fans;
+  mesh::corner_normal_fans_calc(mesh->edges(),
+                                mesh->faces(),
+                                mesh->corner_verts(),
+                                mesh->corner_edges(),
+                                mesh->corner_to_face_map(),
+                                sharp_edges_span,
+                                {},
+                                fans);
+  const OffsetIndices<int> fan_offsets = fans.fan_offsets.as_span();
+  ASSERT_EQ(spaces.corners_by_space.size(), fans.single_corners.size() + fan_offsets.size());
+  for (const int i : fans.single_corners.index_range()) {
+    EXPECT_EQ(spaces.corners_by_space[i].as_span(), Span<int>({fans.single_corners[i]}));
+  }
+  for (const int i : fan_offsets.index_range()) {
+    EXPECT_EQ(spaces.corners_by_space[fans.single_corners.size() + i].as_span(),
+              fans.fan_corners.as_span().slice(fan_offsets[i]));
+  }
+
+  BKE_id_free(nullptr, mesh);
+}
+
+TEST_F(MeshNormalsTest, DirectSharpnessWriteInvalidatesFans)
+{
+  Mesh *mesh = create_cube_mesh();
+  bool *sharp_faces = static_cast<bool *>(CustomData_add_layer_named(
+      &mesh->face_data, CD_PROP_BOOL, CD_SET_DEFAULT, mesh->faces_num, "sharp_face"));
+  sharp_faces[0] = true;
+  mesh->tag_sharpness_changed();
+  expect_normals_near(mesh->corner_normals(), calc_corner_normals_uncached(*mesh, nullptr));
+
+  /* A copy shares the cached fans until its own sharpness changes. */
+  Mesh *mesh_copy = BKE_mesh_copy_for_eval(*mesh);
+  bool *sharp_edges = static_cast<bool *>(CustomData_add_layer_named(
+      &mesh_copy->edge_data, CD_PROP_BOOL, CD_SET_DEFAULT, mesh_copy->edges_num, "sharp_edge"));
+  sharp_edges[3] = true;
+  mesh_copy->tag_sharpness_changed();
+  expect_normals_near(mesh_copy->corner_normals(),
+                      calc_corner_normals_uncached(*mesh_copy, nullptr));
+  expect_normals_near(mesh->corner_normals(), calc_corner_normals_uncached(*mesh, nullptr));
+
+  BKE_id_free(nullptr, mesh_copy);
+  BKE_id_free(nullptr, mesh);
+}
+
+}  // namespace blender::bke::tests
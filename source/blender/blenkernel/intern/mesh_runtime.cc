@@ -293,6 +293,7 @@ void BKE_mesh_runtime_clear_geometry(Mesh *mesh)
   mesh->runtime->vert_normals_cache.tag_dirty();
   mesh->runtime->face_normals_cache.tag_dirty();
   mesh->runtime->corner_normals_cache.tag_dirty();
+  mesh->runtime->corner_normal_fans_cache.tag_dirty();
   mesh->runtime->loose_edges_cache.tag_dirty();
   mesh->runtime->loose_verts_cache.tag_dirty();
   mesh->runtime->verts_no_face_cache.tag_dirty();
@@ -309,6 +310,7 @@ void Mesh::tag_edges_split()
   /* Triangulation didn't change because vertex positions and loop vertex indices didn't change. */
   free_bvh_cache(*this->runtime);
   this->runtime->vert_normals_cache.tag_dirty();
+  this->runtime->corner_normal_fans_cache.tag_dirty();
   this->runtime->subdiv_ccg.reset();
   this->runtime->vert_to_face_offset_cache.tag_dirty();
   this->runtime->vert_to_face_map_cache.tag_dirty();
@@ -336,6 +338,7 @@ void Mesh::tag_edges_split()
 void Mesh::tag_sharpness_changed()
 {
   this->runtime->corner_normals_cache.tag_dirty();
+  this->runtime->corner_normal_fans_cache.tag_dirty();
 }
 
 void Mesh::tag_custom_normals_changed()
@@ -348,6 +351,7 @@ void Mesh::tag_face_winding_changed()
   this->runtime->vert_normals_cache.tag_dirty();
   this->runtime->face_normals_cache.tag_dirty();
   this->runtime->corner_normals_cache.tag_dirty();
+  this->runtime->corner_normal_fans_cache.tag_dirty();
   this->runtime->vert_to_corner_map_cache.tag_dirty();
   this->runtime->shrinkwrap_boundary_cache.tag_dirty();
 }
@@ -364,7 +368,11 @@ void Mesh::tag_positions_changed()
 void Mesh::tag_positions_changed_no_normals()
 {
   free_bvh_cache(*this->runtime);
-  this->runtime->corner_tris_cache.tag_dirty();
+  /* The triangulation of a mesh made only of triangles doesn't depend on positions. Quads are
+   * split depending on their shape, so any other face type requires recalculation. */
+  if (this->corners_num != this->faces_num * 3) {
+    this->runtime->corner_tris_cache.tag_dirty();
+  }
   this->runtime->bounds_cache.tag_dirty();
   this->runtime->shrinkwrap_boundary_cache.tag_dirty();
 }
@@ -18,6 +18,7 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "opensubdiv_capi_type.hh"
 #include "opensubdiv_evaluator_capi.hh"
 #include "opensubdiv_topology_refiner_capi.hh"
 
@@ -332,6 +333,22 @@ void eval_limit_point_and_normal(Subdiv *subdiv,
   normalize_v3(r_N);
 }
 
+void eval_limit_points(Subdiv *subdiv,
+                       const Span<OpenSubdiv_PatchCoord> patch_coords,
+                       MutableSpan<float3> r_P)
+{
+  BLI_assert(patch_coords.size() == r_P.size());
+  if (patch_coords.is_empty()) {
+    return;
+  }
+  subdiv->evaluator->evaluatePatchesLimit(subdiv->evaluator,
+                                          patch_coords.data(),
+                                          patch_coords.size(),
+                                          reinterpret_cast<float *>(r_P.data()),
+                                          nullptr,
+                                          nullptr);
+}
+
 void eval_vertex_data(
     Subdiv *subdiv, const int ptex_face_index, const float u, const float v, float r_vertex_data[])
 {
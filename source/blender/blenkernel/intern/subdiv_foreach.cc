@@ -8,10 +8,9 @@
 
 #include "BKE_subdiv_foreach.hh"
 
-#include "atomic_ops.h"
-
 #include "BLI_bitmap.h"
 #include "BLI_task.h"
+#include "BLI_task.hh"
 
 #include "BKE_customdata.hh"
 #include "BKE_mesh.hh"
@@ -108,6 +107,13 @@ struct ForeachTaskContext {
    *   were already evaluated.
    */
   BLI_bitmap *coarse_edges_used_map;
+  /* Indexed by coarse vertex and edge index respectively, the first coarse face which uses the
+   * element. Only that face runs the callbacks for the subdivided vertices it shares with other
+   * faces, so they can be traversed from multiple threads with the same result as a serial
+   * traversal. Only allocated when the corresponding callbacks are used.
+   */
+  int *coarse_vertex_owner_face;
+  int *coarse_edge_owner_face;
 };
 
 /** \} */
@@ -144,56 +150,6 @@ static void subdiv_foreach_tls_free(ForeachTaskContext *ctx, void *tls)
 /** \name Initialization
  * \{ */
 
-/* NOTE: Expects edge map to be zeroed. */
-static void subdiv_foreach_ctx_count(ForeachTaskContext *ctx)
-{
-  /* Reset counters. */
-  ctx->num_subdiv_vertices = 0;
-  ctx->num_subdiv_edges = 0;
-  ctx->num_subdiv_loops = 0;
-  ctx->num_subdiv_faces = 0;
-  /* Static geometry counters. */
-  const int resolution = ctx->settings->resolution;
-  const int no_quad_patch_resolution = ((resolution >> 1) + 1);
-  const int num_subdiv_vertices_per_coarse_edge = resolution - 2;
-  const int num_inner_vertices_per_quad = (resolution - 2) * (resolution - 2);
-  const int num_inner_vertices_per_noquad_patch = (no_quad_patch_resolution - 2) *
-                                                  (no_quad_patch_resolution - 2);
-  const Mesh *coarse_mesh = ctx->coarse_mesh;
-  ctx->num_subdiv_vertices = coarse_mesh->verts_num;
-  ctx->num_subdiv_edges = coarse_mesh->edges_num * (num_subdiv_vertices_per_coarse_edge + 1);
-  /* Calculate extra vertices and edges created by non-loose geometry. */
-  for (int face_index = 0; face_index < coarse_mesh->faces_num; face_index++) {
-    const IndexRange coarse_face = ctx->coarse_faces[face_index];
-    const int num_ptex_faces_per_face = num_ptex_faces_per_face_get(coarse_face);
-    /* Inner vertices of face. */
-    if (num_ptex_faces_per_face == 1) {
-      ctx->num_subdiv_vertices += num_inner_vertices_per_quad;
-      ctx->num_subdiv_edges += num_edges_per_ptex_face_get(resolution - 2) +
-                               4 * num_subdiv_vertices_per_coarse_edge;
-      ctx->num_subdiv_faces += num_faces_per_ptex_get(resolution);
-    }
-    else {
-      ctx->num_subdiv_vertices += 1 + num_ptex_faces_per_face * (no_quad_patch_resolution - 2) +
-                                  num_ptex_faces_per_face * num_inner_vertices_per_noquad_patch;
-      ctx->num_subdiv_edges += num_ptex_faces_per_face *
-                               (num_inner_edges_per_ptex_face_get(no_quad_patch_resolution - 1) +
-                                (no_quad_patch_resolution - 2) +
-                                num_subdiv_vertices_per_coarse_edge);
-      if (no_quad_patch_resolution >= 3) {
-        ctx->num_subdiv_edges += coarse_face.size();
-      }
-      ctx->num_subdiv_faces += num_ptex_faces_per_face *
-                               num_faces_per_ptex_get(no_quad_patch_resolution);
-    }
-  }
-
-  /* Add vertices used by outer edges on subdivided faces and loose edges. */
-  ctx->num_subdiv_vertices += num_subdiv_vertices_per_coarse_edge * coarse_mesh->edges_num;
-
-  ctx->num_subdiv_loops = ctx->num_subdiv_faces * 4;
-}
-
 static void subdiv_foreach_ctx_init_offsets(ForeachTaskContext *ctx)
 {
   const Mesh *coarse_mesh = ctx->coarse_mesh;
@@ -213,33 +169,57 @@ static void subdiv_foreach_ctx_init_offsets(ForeachTaskContext *ctx)
   ctx->edge_boundary_offset = 0;
   ctx->edge_inner_offset = ctx->edge_boundary_offset +
                            coarse_mesh->edges_num * num_subdiv_edges_per_coarse_edge;
-  /* "Indexed" offsets. */
-  int vertex_offset = 0;
-  int edge_offset = 0;
-  int face_offset = 0;
-  for (int face_index = 0; face_index < coarse_mesh->faces_num; face_index++) {
-    const IndexRange coarse_face = ctx->coarse_faces[face_index];
-    const int num_ptex_faces_per_face = num_ptex_faces_per_face_get(coarse_face);
-    ctx->subdiv_vertex_offset[face_index] = vertex_offset;
-    ctx->subdiv_edge_offset[face_index] = edge_offset;
-    ctx->subdiv_face_offset[face_index] = face_offset;
-    if (num_ptex_faces_per_face == 1) {
-      vertex_offset += resolution_2_squared;
-      edge_offset += num_edges_per_ptex_face_get(resolution - 2) +
-                     4 * num_subdiv_vertices_per_coarse_edge;
-      face_offset += num_faces_per_ptex_get(resolution);
-    }
-    else {
-      vertex_offset += 1 + num_ptex_faces_per_face * num_irregular_vertices_per_patch;
-      edge_offset += num_ptex_faces_per_face *
-                     (num_inner_edges_per_ptex_face_get(no_quad_patch_resolution - 1) +
-                      (no_quad_patch_resolution - 2) + num_subdiv_vertices_per_coarse_edge);
-      if (no_quad_patch_resolution >= 3) {
-        edge_offset += coarse_face.size();
+  /* "Indexed" offsets. The amount of geometry created by every coarse face is calculated in
+   * parallel, and converted to offsets afterwards. */
+  MutableSpan<int> vertex_offsets(ctx->subdiv_vertex_offset, coarse_mesh->faces_num + 1);
+  MutableSpan<int> edge_offsets(ctx->subdiv_edge_offset, coarse_mesh->faces_num + 1);
+  MutableSpan<int> face_offsets(ctx->subdiv_face_offset, coarse_mesh->faces_num + 1);
+  threading::parallel_for(ctx->coarse_faces.index_range(), 4096, [&](const IndexRange range) {
+    for (const int face_index : range) {
+      const IndexRange coarse_face = ctx->coarse_faces[face_index];
+      const int num_ptex_faces_per_face = num_ptex_faces_per_face_get(coarse_face);
+      if (num_ptex_faces_per_face == 1) {
+        vertex_offsets[face_index] = resolution_2_squared;
+        edge_offsets[face_index] = num_edges_per_ptex_face_get(resolution - 2) +
+                                   4 * num_subdiv_vertices_per_coarse_edge;
+        face_offsets[face_index] = num_faces_per_ptex_get(resolution);
+      }
+      else {
+        vertex_offsets[face_index] = 1 + num_ptex_faces_per_face *
+                                             num_irregular_vertices_per_patch;
+        edge_offsets[face_index] = num_ptex_faces_per_face *
+                                   (num_inner_edges_per_ptex_face_get(no_quad_patch_resolution -
+                                                                      1) +
+                                    (no_quad_patch_resolution - 2) +
+                                    num_subdiv_vertices_per_coarse_edge);
+        if (no_quad_patch_resolution >= 3) {
+          edge_offsets[face_index] += coarse_face.size();
+        }
+        face_offsets[face_index] = num_ptex_faces_per_face *
+                                   num_faces_per_ptex_get(no_quad_patch_resolution);
       }
-      face_offset += num_ptex_faces_per_face * num_faces_per_ptex_get(no_quad_patch_resolution);
     }
-  }
+  });
+  offset_indices::accumulate_counts_to_offsets(vertex_offsets);
+  offset_indices::accumulate_counts_to_offsets(edge_offsets);
+  offset_indices::accumulate_counts_to_offsets(face_offsets);
+}
+
+static void subdiv_foreach_ctx_count(ForeachTaskContext *ctx)
+{
+  const int resolution = ctx->settings->resolution;
+  const int num_subdiv_vertices_per_coarse_edge = resolution - 2;
+  const Mesh *coarse_mesh = ctx->coarse_mesh;
+  /* The geometry created by faces is known from the last value of the offsets. */
+  ctx->num_subdiv_vertices = coarse_mesh->verts_num +
+                             ctx->subdiv_vertex_offset[coarse_mesh->faces_num];
+  ctx->num_subdiv_edges = coarse_mesh->edges_num * (num_subdiv_vertices_per_coarse_edge + 1) +
+                          ctx->subdiv_edge_offset[coarse_mesh->faces_num];
+  ctx->num_subdiv_faces = ctx->subdiv_face_offset[coarse_mesh->faces_num];
+  /* Add vertices used by outer edges on subdivided faces and loose edges. */
+  ctx->num_subdiv_vertices += num_subdiv_vertices_per_coarse_edge * coarse_mesh->edges_num;
+
+  ctx->num_subdiv_loops = ctx->num_subdiv_faces * 4;
 }
 
 static void subdiv_foreach_ctx_init(Subdiv *subdiv, ForeachTaskContext *ctx)
@@ -249,11 +229,11 @@ static void subdiv_foreach_ctx_init(Subdiv *subdiv, ForeachTaskContext *ctx)
   ctx->coarse_vertices_used_map = BLI_BITMAP_NEW(coarse_mesh->verts_num, "vertices used map");
   ctx->coarse_edges_used_map = BLI_BITMAP_NEW(coarse_mesh->edges_num, "edges used map");
   ctx->subdiv_vertex_offset = static_cast<int *>(MEM_malloc_arrayN(
-      coarse_mesh->faces_num, sizeof(*ctx->subdiv_vertex_offset), "vertex_offset"));
+      coarse_mesh->faces_num + 1, sizeof(*ctx->subdiv_vertex_offset), "vertex_offset"));
   ctx->subdiv_edge_offset = static_cast<int *>(MEM_malloc_arrayN(
-      coarse_mesh->faces_num, sizeof(*ctx->subdiv_edge_offset), "subdiv_edge_offset"));
+      coarse_mesh->faces_num + 1, sizeof(*ctx->subdiv_edge_offset), "subdiv_edge_offset"));
   ctx->subdiv_face_offset = static_cast<int *>(MEM_malloc_arrayN(
-      coarse_mesh->faces_num, sizeof(*ctx->subdiv_face_offset), "subdiv_edge_offset"));
+      coarse_mesh->faces_num + 1, sizeof(*ctx->subdiv_face_offset), "subdiv_edge_offset"));
   /* Initialize all offsets. */
   subdiv_foreach_ctx_init_offsets(ctx);
   /* Calculate number of geometry in the result subdivision mesh. */
@@ -268,6 +248,8 @@ static void subdiv_foreach_ctx_free(ForeachTaskContext *ctx)
   MEM_freeN(ctx->subdiv_vertex_offset);
   MEM_freeN(ctx->subdiv_edge_offset);
   MEM_freeN(ctx->subdiv_face_offset);
+  MEM_SAFE_FREE(ctx->coarse_vertex_owner_face);
+  MEM_SAFE_FREE(ctx->coarse_edge_owner_face);
 }
 
 /** \} */
@@ -289,8 +271,7 @@ static void subdiv_foreach_corner_vertices_regular_do(ForeachTaskContext *ctx,
   const int ptex_face_index = ctx->face_ptex_offset[coarse_face_index];
   for (int corner = 0; corner < coarse_face.size(); corner++) {
     const int coarse_vert = ctx->coarse_corner_verts[coarse_face[corner]];
-    if (check_usage && BLI_BITMAP_TEST_AND_SET_ATOMIC(ctx->coarse_vertices_used_map, coarse_vert))
-    {
+    if (check_usage && ctx->coarse_vertex_owner_face[coarse_vert] != coarse_face_index) {
       continue;
     }
     const int coarse_vertex_index = coarse_vert;
@@ -327,8 +308,7 @@ static void subdiv_foreach_corner_vertices_special_do(ForeachTaskContext *ctx,
   int ptex_face_index = ctx->face_ptex_offset[coarse_face_index];
   for (int corner = 0; corner < coarse_face.size(); corner++, ptex_face_index++) {
     const int coarse_vert = ctx->coarse_corner_verts[coarse_face[corner]];
-    if (check_usage && BLI_BITMAP_TEST_AND_SET_ATOMIC(ctx->coarse_vertices_used_map, coarse_vert))
-    {
+    if (check_usage && ctx->coarse_vertex_owner_face[coarse_vert] != coarse_face_index) {
       continue;
     }
     const int coarse_vertex_index = coarse_vert;
@@ -414,9 +394,7 @@ static void subdiv_foreach_edge_vertices_regular_do(ForeachTaskContext *ctx,
   for (int corner = 0; corner < coarse_face.size(); corner++) {
     const int coarse_vert = ctx->coarse_corner_verts[coarse_face[corner]];
     const int coarse_edge_index = ctx->coarse_corner_edges[coarse_face[corner]];
-    if (check_usage &&
-        BLI_BITMAP_TEST_AND_SET_ATOMIC(ctx->coarse_edges_used_map, coarse_edge_index))
-    {
+    if (check_usage && ctx->coarse_edge_owner_face[coarse_edge_index] != coarse_face_index) {
       continue;
     }
     const int2 &coarse_edge = ctx->coarse_edges[coarse_edge_index];
@@ -479,9 +457,7 @@ static void subdiv_foreach_edge_vertices_special_do(ForeachTaskContext *ctx,
   for (int corner = 0; corner < coarse_face.size(); corner++, ptex_face_index++) {
     const int coarse_vert = ctx->coarse_corner_verts[coarse_face[corner]];
     const int coarse_edge_index = ctx->coarse_corner_edges[coarse_face[corner]];
-    if (check_usage &&
-        BLI_BITMAP_TEST_AND_SET_ATOMIC(ctx->coarse_edges_used_map, coarse_edge_index))
-    {
+    if (check_usage && ctx->coarse_edge_owner_face[coarse_edge_index] != coarse_face_index) {
       continue;
     }
     const int2 &coarse_edge = ctx->coarse_edges[coarse_edge_index];
@@ -1713,15 +1689,34 @@ static void subdiv_foreach_vertices_of_loose_edges_task(void *__restrict userdat
 /** \name Subdivision process entry points
  * \{ */
 
-static void subdiv_foreach_single_geometry_vertices(ForeachTaskContext *ctx, void *tls)
+/**
+ * Find the face which runs the callbacks of the vertices created from every coarse vertex and
+ * edge, which is the first face using them. This is a cheap serial pass which allows the actual
+ * callbacks to be run in parallel, see #subdiv_foreach_single_geometry_vertices_task.
+ */
+static void subdiv_foreach_single_geometry_vertices_owners(ForeachTaskContext *ctx)
 {
   if (ctx->foreach_context->vertex_corner == nullptr) {
     return;
   }
   const Mesh *coarse_mesh = ctx->coarse_mesh;
-  for (int face_index = 0; face_index < coarse_mesh->faces_num; face_index++) {
-    subdiv_foreach_corner_vertices(ctx, tls, face_index);
-    subdiv_foreach_edge_vertices(ctx, tls, face_index);
+  ctx->coarse_vertex_owner_face = static_cast<int *>(MEM_malloc_arrayN(
+      coarse_mesh->verts_num, sizeof(*ctx->coarse_vertex_owner_face), "vertex owner face"));
+  ctx->coarse_edge_owner_face = static_cast<int *>(MEM_malloc_arrayN(
+      coarse_mesh->edges_num, sizeof(*ctx->coarse_edge_owner_face), "edge owner face"));
+  for (const int face_index : ctx->coarse_faces.index_range()) {
+    for (const int corner : ctx->coarse_faces[face_index]) {
+      const int coarse_vert = ctx->coarse_corner_verts[corner];
+      const int coarse_edge = ctx->coarse_corner_edges[corner];
+      if (!BLI_BITMAP_TEST_BOOL(ctx->coarse_vertices_used_map, coarse_vert)) {
+        BLI_BITMAP_ENABLE(ctx->coarse_vertices_used_map, coarse_vert);
+        ctx->coarse_vertex_owner_face[coarse_vert] = face_index;
+      }
+      if (!BLI_BITMAP_TEST_BOOL(ctx->coarse_edges_used_map, coarse_edge)) {
+        BLI_BITMAP_ENABLE(ctx->coarse_edges_used_map, coarse_edge);
+        ctx->coarse_edge_owner_face[coarse_edge] = face_index;
+      }
+    }
   }
 }
 
@@ -1745,9 +1740,9 @@ static void subdiv_foreach_single_thread_tasks(ForeachTaskContext *ctx)
    * and boundary edges. */
   subdiv_foreach_every_corner_vertices(ctx, tls);
   subdiv_foreach_every_edge_vertices(ctx, tls);
-  /* Run callbacks which are supposed to be run once per shared geometry. */
-  subdiv_foreach_single_geometry_vertices(ctx, tls);
   subdiv_foreach_tls_free(ctx, tls);
+  /* Prepare running callbacks which are supposed to be run once per shared geometry. */
+  subdiv_foreach_single_geometry_vertices_owners(ctx);
 
   const ForeachContext *foreach_context = ctx->foreach_context;
   const bool is_loose_geometry_tagged = (foreach_context->vertex_every_edge != nullptr &&
@@ -1759,6 +1754,15 @@ static void subdiv_foreach_single_thread_tasks(ForeachTaskContext *ctx)
   }
 }
 
+static void subdiv_foreach_single_geometry_vertices_task(void *__restrict userdata,
+                                                        const int face_index,
+                                                        const TaskParallelTLS *__restrict tls)
+{
+  ForeachTaskContext *ctx = static_cast<ForeachTaskContext *>(userdata);
+  subdiv_foreach_corner_vertices(ctx, tls->userdata_chunk, face_index);
+  subdiv_foreach_edge_vertices(ctx, tls->userdata_chunk, face_index);
+}
+
 static void subdiv_foreach_task(void *__restrict userdata,
                                 const int face_index,
                                 const TaskParallelTLS *__restrict tls)
@@ -1836,6 +1840,13 @@ bool foreach_subdiv_geometry(Subdiv *subdiv,
    * currently are relying on the fact that face/grid callbacks will tag non-
    * loose geometry. */
 
+  if (context->vertex_corner != nullptr) {
+    BLI_task_parallel_range(0,
+                            coarse_mesh->faces_num,
+                            &ctx,
+                            subdiv_foreach_single_geometry_vertices_task,
+                            &parallel_range_settings);
+  }
   BLI_task_parallel_range(
       0, coarse_mesh->faces_num, &ctx, subdiv_foreach_task, &parallel_range_settings);
   if (context->vertex_loose != nullptr) {
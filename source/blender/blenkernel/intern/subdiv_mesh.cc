@@ -29,6 +29,8 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "opensubdiv_capi_type.hh"
+
 namespace blender::bke::subdiv {
 
 /* -------------------------------------------------------------------- */
@@ -67,6 +69,12 @@ struct SubdivMeshContext {
   int *accumulated_counters;
   bool have_displacement;
 
+  /* Limit surface coordinates of subdivided vertices, stored during the traversal so that all
+   * positions can be evaluated in batches afterwards. Only used without displacement, and
+   * vertices which are not evaluated from the limit surface have a negative ptex face index. */
+  Array<OpenSubdiv_PatchCoord> vertex_patch_coords_data;
+  MutableSpan<OpenSubdiv_PatchCoord> vertex_patch_coords;
+
   /* Write optimal display edge tags into a boolean array rather than the final bit vector
    * to avoid race conditions when setting bits. */
   Array<bool> subdiv_display_edges;
@@ -483,6 +491,50 @@ static void subdiv_vertex_orco_evaluate(const SubdivMeshContext *ctx,
   }
 }
 
+/**
+ * Evaluate the limit surface position of a subdivided vertex. Without displacement the
+ * evaluation is deferred to #subdiv_mesh_eval_limit_positions.
+ */
+static void subdiv_vertex_limit_point_evaluate(const SubdivMeshContext *ctx,
+                                               const int ptex_face_index,
+                                               const float u,
+                                               const float v,
+                                               const int subdiv_vertex_index)
+{
+  if (!ctx->vertex_patch_coords.is_empty()) {
+    ctx->vertex_patch_coords[subdiv_vertex_index] = {ptex_face_index, u, v};
+    return;
+  }
+  eval_limit_point(ctx->subdiv, ptex_face_index, u, v, ctx->subdiv_positions[subdiv_vertex_index]);
+}
+
+/**
+ * Evaluate positions of all vertices whose evaluation was deferred during the traversal.
+ * Positions are evaluated in chunks, which is much cheaper than evaluating every vertex on
+ * its own.
+ */
+static void subdiv_mesh_eval_limit_positions(SubdivMeshContext *ctx)
+{
+  const Span<OpenSubdiv_PatchCoord> all_patch_coords = ctx->vertex_patch_coords;
+  threading::parallel_for(all_patch_coords.index_range(), 4096, [&](const IndexRange range) {
+    Vector<int, 0> indices;
+    Vector<OpenSubdiv_PatchCoord, 0> patch_coords;
+    indices.reserve(range.size());
+    patch_coords.reserve(range.size());
+    for (const int i : range) {
+      if (all_patch_coords[i].ptex_face >= 0) {
+        indices.append_unchecked(i);
+        patch_coords.append_unchecked(all_patch_coords[i]);
+      }
+    }
+    Array<float3, 0> positions(patch_coords.size());
+    eval_limit_points(ctx->subdiv, patch_coords, positions);
+    for (const int i : indices.index_range()) {
+      ctx->subdiv_positions[indices[i]] = positions[i];
+    }
+  });
+}
+
 /** \} */
 
 /* -------------------------------------------------------------------- */
@@ -533,6 +585,11 @@ static bool subdiv_mesh_topology_info(const ForeachContext *foreach_context,
       subdiv_context->coarse_mesh, num_vertices, num_edges, 0, num_faces, num_loops, mask);
   subdiv_mesh_ctx_cache_custom_data_layers(subdiv_context);
   subdiv_mesh_prepare_accumulator(subdiv_context, num_vertices);
+  if (!subdiv_context->have_displacement) {
+    subdiv_context->vertex_patch_coords_data.reinitialize(num_vertices);
+    subdiv_context->vertex_patch_coords_data.fill({-1, 0.0f, 0.0f});
+    subdiv_context->vertex_patch_coords = subdiv_context->vertex_patch_coords_data;
+  }
   subdiv_context->subdiv_mesh->runtime->subsurf_face_dot_tags.clear();
   subdiv_context->subdiv_mesh->runtime->subsurf_face_dot_tags.resize(num_vertices);
   if (subdiv_context->settings->use_optimal_display) {
@@ -596,13 +653,19 @@ static void evaluate_vertex_and_apply_displacement_copy(const SubdivMeshContext
   }
   /* Copy custom data and evaluate position. */
   subdiv_vertex_data_copy(ctx, coarse_vertex_index, subdiv_vertex_index);
-  eval_limit_point(ctx->subdiv, ptex_face_index, u, v, subdiv_position);
-  /* Apply displacement. */
-  subdiv_position += D;
+  subdiv_vertex_limit_point_evaluate(ctx, ptex_face_index, u, v, subdiv_vertex_index);
+  /* Apply displacement. Without displacement the position isn't evaluated yet. */
+  if (ctx->have_displacement) {
+    subdiv_position += D;
+  }
   /* Evaluate undeformed texture coordinate. */
   subdiv_vertex_orco_evaluate(ctx, ptex_face_index, u, v, subdiv_vertex_index);
-  /* Remove face-dot flag. This can happen if there is more than one subsurf modifier. */
-  ctx->subdiv_mesh->runtime->subsurf_face_dot_tags[subdiv_vertex_index].reset();
+  /* Remove face-dot flag. This can happen if there is more than one subsurf modifier.
+   * Only write when necessary, since other threads may access bits in the same integer. */
+  MutableBitSpan face_dot_tags = ctx->subdiv_mesh->runtime->subsurf_face_dot_tags;
+  if (face_dot_tags[subdiv_vertex_index]) {
+    face_dot_tags[subdiv_vertex_index].reset();
+  }
 }
 
 static void evaluate_vertex_and_apply_displacement_interpolate(
@@ -624,9 +687,11 @@ static void evaluate_vertex_and_apply_displacement_interpolate(
   }
   /* Interpolate custom data and evaluate position. */
   subdiv_vertex_data_interpolate(ctx, subdiv_vertex_index, vertex_interpolation, u, v);
-  eval_limit_point(ctx->subdiv, ptex_face_index, u, v, subdiv_position);
-  /* Apply displacement. */
-  add_v3_v3(subdiv_position, D);
+  subdiv_vertex_limit_point_evaluate(ctx, ptex_face_index, u, v, subdiv_vertex_index);
+  /* Apply displacement. Without displacement the position isn't evaluated yet. */
+  if (ctx->have_displacement) {
+    add_v3_v3(subdiv_position, D);
+  }
   /* Evaluate undeformed texture coordinate. */
   subdiv_vertex_orco_evaluate(ctx, ptex_face_index, u, v, subdiv_vertex_index);
 }
@@ -780,7 +845,12 @@ static void subdiv_mesh_vertex_inner(const ForeachContext *foreach_context,
   float3 &subdiv_position = ctx->subdiv_positions[subdiv_vertex_index];
   subdiv_mesh_ensure_vertex_interpolation(ctx, tls, coarse_face_index, coarse_corner);
   subdiv_vertex_data_interpolate(ctx, subdiv_vertex_index, &tls->vertex_interpolation, u, v);
-  eval_final_point(subdiv, ptex_face_index, u, v, subdiv_position);
+  if (ctx->have_displacement) {
+    eval_final_point(subdiv, ptex_face_index, u, v, subdiv_position);
+  }
+  else {
+    subdiv_vertex_limit_point_evaluate(ctx, ptex_face_index, u, v, subdiv_vertex_index);
+  }
   subdiv_mesh_tag_center_vertex(coarse_face, subdiv_vertex_index, u, v, subdiv_mesh);
   subdiv_vertex_orco_evaluate(ctx, ptex_face_index, u, v, subdiv_vertex_index);
 }
@@ -1060,7 +1130,11 @@ static void subdiv_mesh_vertex_of_loose_edge(const ForeachContext *foreach_conte
   if (!ELEM(u, 0.0, 1.0)) {
     subdiv_mesh_vertex_of_loose_edge_interpolate(ctx, coarse_edge, u, subdiv_vertex_index);
   }
-  /* Interpolate coordinate. */
+  /* Interpolate coordinate. End points shared with faces were given limit surface coordinates,
+   * don't let the deferred evaluation overwrite the position interpolated here. */
+  if (!ctx->vertex_patch_coords.is_empty()) {
+    ctx->vertex_patch_coords[subdiv_vertex_index].ptex_face = -1;
+  }
   ctx->subdiv_positions[subdiv_vertex_index] = mesh_interpolate_position_on_edge(
       ctx->coarse_positions,
       ctx->coarse_edges,
@@ -1149,6 +1223,7 @@ Mesh *subdiv_to_mesh(Subdiv *subdiv, const ToMeshSettings *settings, const Mesh
   foreach_context.user_data_tls_size = sizeof(SubdivMeshTLS);
   foreach_context.user_data_tls = &tls;
   foreach_subdiv_geometry(subdiv, &foreach_context, settings, coarse_mesh);
+  subdiv_mesh_eval_limit_positions(&subdiv_context);
   stats_end(&subdiv->stats, SUBDIV_STATS_SUBDIV_TO_MESH_GEOMETRY);
   Mesh *result = subdiv_context.subdiv_mesh;
 
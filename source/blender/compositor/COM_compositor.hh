@@ -113,5 +113,9 @@ void COM_deinitialize();
 /**
  * \brief Clear all compositor caches. (Compositor system will still remain available).
  * To deinitialize the compositor use the COM_deinitialize method.
+ *
+ * Called when loading a file, since cached results of its node trees can't be used anymore.
+ * The cached results use a memory budget of the size of the "Memory Cache Limit" preference,
+ * separate from the one of the sequencer cache.
  */
-// void COM_clear_caches(); // NOT YET WRITTEN
+void COM_clear_caches();
@@ -8,7 +8,12 @@
 
 #include "BLT_translation.hh"
 
+#include "CLG_log.h"
+
+#include "COM_ConstantOperation.h"
 #include "COM_Debug.h"
+#include "COM_FusedOperation.h"
+#include "COM_OperationCache.h"
 #include "COM_ViewerOperation.h"
 #include "COM_WorkScheduler.h"
 
@@ -22,12 +27,15 @@
 
 namespace blender::compositor {
 
+static CLG_LogRef LOG = {"compositor"};
+
 FullFrameExecutionModel::FullFrameExecutionModel(CompositorContext &context,
                                                  SharedOperationBuffers &shared_buffers,
                                                  Span<NodeOperation *> operations)
     : ExecutionModel(context, operations),
       active_buffers_(shared_buffers),
-      num_operations_finished_(0)
+      num_operations_finished_(0),
+      use_cache_(!context.is_rendering())
 {
   priorities_.append(eCompositorPriority::High);
   priorities_.append(eCompositorPriority::Medium);
@@ -42,8 +50,22 @@ void FullFrameExecutionModel::execute(ExecutionSystem &exec_system)
 
   DebugInfo::graphviz(&exec_system, "compositor_prior_rendering");
 
+  render();
+}
+
+void FullFrameExecutionModel::render()
+{
+  if (use_cache_) {
+    OperationCache::execution_started();
+  }
   determine_areas_to_render_and_reads();
+  determine_stripe_operations();
   render_operations();
+
+  CLOG_INFO(&LOG,
+            1,
+            "Peak memory of operation buffers: %.2fM",
+            double(active_buffers_.get_peak_memory()) / (1024.0 * 1024.0));
 }
 
 void FullFrameExecutionModel::determine_areas_to_render_and_reads()
@@ -64,9 +86,11 @@ void FullFrameExecutionModel::determine_areas_to_render_and_reads()
   }
 }
 
-Vector<MemoryBuffer *> FullFrameExecutionModel::get_input_buffers(NodeOperation *op,
-                                                                  const int output_x,
-                                                                  const int output_y)
+Vector<MemoryBuffer *> FullFrameExecutionModel::get_input_buffers(
+    NodeOperation *op,
+    const int output_x,
+    const int output_y,
+    const Map<NodeOperation *, std::unique_ptr<MemoryBuffer>> *stripe_buffers)
 {
   const int num_inputs = op->get_number_of_input_sockets();
   Vector<MemoryBuffer *> inputs_buffers(num_inputs);
@@ -74,7 +98,11 @@ Vector<MemoryBuffer *> FullFrameExecutionModel::get_input_buffers(NodeOperation
     NodeOperation *input = op->get_input_operation(i);
     const int offset_x = (input->get_canvas().xmin - op->get_canvas().xmin) + output_x;
     const int offset_y = (input->get_canvas().ymin - op->get_canvas().ymin) + output_y;
-    MemoryBuffer *buf = active_buffers_.get_rendered_buffer(input);
+    const std::unique_ptr<MemoryBuffer> *stripe_buf = stripe_buffers ?
+                                                          stripe_buffers->lookup_ptr(input) :
+                                                          nullptr;
+    MemoryBuffer *buf = stripe_buf ? stripe_buf->get() :
+                                     active_buffers_.get_rendered_buffer(input);
 
     rcti rect = buf->get_rect();
     BLI_rcti_translate(&rect, offset_x, offset_y);
@@ -94,7 +122,9 @@ MemoryBuffer *FullFrameExecutionModel::create_operation_buffer(NodeOperation *op
 
   const DataType data_type = op->get_output_socket(0)->get_data_type();
   const bool is_a_single_elem = op->get_flags().is_constant_operation;
-  return new MemoryBuffer(data_type, rect, is_a_single_elem);
+  MemoryBuffer *buf = new MemoryBuffer(data_type, rect, is_a_single_elem);
+  active_buffers_.add_memory_in_use(buf->get_memory_size());
+  return buf;
 }
 
 void FullFrameExecutionModel::render_operation(NodeOperation *op)
@@ -103,11 +133,23 @@ void FullFrameExecutionModel::render_operation(NodeOperation *op)
   constexpr int output_x = 0;
   constexpr int output_y = 0;
 
+  if (has_cached_result(op)) {
+    use_cached_result(op);
+    return;
+  }
+
   const timeit::TimePoint before_time = timeit::Clock::now();
 
   const bool has_outputs = op->get_number_of_output_sockets() > 0;
   MemoryBuffer *op_buf = has_outputs ? create_operation_buffer(op, output_x, output_y) : nullptr;
-  if (op->get_width() > 0 && op->get_height() > 0) {
+  /* Time spent rendering other operations in stripes, not accumulated to this operation. */
+  timeit::Nanoseconds stripe_dependencies_time = timeit::Nanoseconds::zero();
+  const Vector<NodeOperation *> stripe_dependencies = get_stripe_dependencies(op);
+  if (op->get_width() > 0 && op->get_height() > 0 && !stripe_dependencies.is_empty()) {
+    stripe_dependencies_time = render_operation_in_stripes(op, op_buf, stripe_dependencies);
+    DebugInfo::operation_rendered(op, op_buf);
+  }
+  else if (op->get_width() > 0 && op->get_height() > 0) {
     Vector<MemoryBuffer *> input_bufs = get_input_buffers(op, output_x, output_y);
     const int op_offset_x = output_x - op->get_canvas().xmin;
     const int op_offset_y = output_y - op->get_canvas().ymin;
@@ -119,19 +161,303 @@ void FullFrameExecutionModel::render_operation(NodeOperation *op)
       delete buf;
     }
   }
+  if (op_buf) {
+    op_buf = store_result(op, op_buf);
+  }
   /* Even if operation has no resolution set the empty buffer. It will be clipped with a
    * TranslateOperation from convert resolutions if linked to an operation with resolution. */
   active_buffers_.set_rendered_buffer(op, std::unique_ptr<MemoryBuffer>(op_buf));
 
+  for (NodeOperation *stripe_op : stripe_dependencies) {
+    operation_finished(stripe_op);
+  }
   operation_finished(op);
 
+  const timeit::TimePoint after_time = timeit::Clock::now();
+  add_evaluation_time(op, after_time - before_time - stripe_dependencies_time);
+}
+
+void FullFrameExecutionModel::add_evaluation_time(NodeOperation *op,
+                                                  const timeit::Nanoseconds time)
+{
+  if (const FusedOperation *fused_op = dynamic_cast<const FusedOperation *>(op)) {
+    fused_op->foreach_fused_evaluation_time(
+        time, [&](NodeOperation &operation, const timeit::Nanoseconds operation_time) {
+          add_evaluation_time(&operation, operation_time);
+        });
+    return;
+  }
   /* The operation may not come from any node. For example, it may have been added to convert data
    * type. Do not accumulate time from its execution. */
-  const timeit::TimePoint after_time = timeit::Clock::now();
   const bNodeInstanceKey node_instance_key = op->get_node_instance_key();
   if (context_.get_profiler() && node_instance_key != bke::NODE_INSTANCE_KEY_NONE) {
-    context_.get_profiler()->set_node_evaluation_time(node_instance_key, after_time - before_time);
+    context_.get_profiler()->set_node_evaluation_time(node_instance_key, time);
+  }
+}
+
+std::optional<uint64_t> FullFrameExecutionModel::get_result_hash(NodeOperation *op)
+{
+  if (const std::optional<uint64_t> *result_hash = result_hashes_.lookup_ptr(op)) {
+    return *result_hash;
   }
+
+  std::optional<uint64_t> result_hash;
+  if (std::optional<NodeOperationHash> op_hash = op->generate_hash()) {
+    /* Unlike #NodeOperationHash, which identifies inputs by operation id, inputs are identified
+     * by their own result hash so that the hash is the same in the next executions. */
+    result_hash = op_hash->get_params_hash();
+    for (int i = 0; i < op->get_number_of_input_sockets() && result_hash; i++) {
+      NodeOperation *input_op = op->get_input_operation(i);
+      if (input_op->get_flags().is_constant_operation) {
+        const float *elem = static_cast<ConstantOperation *>(input_op)->get_constant_elem();
+        const int num_channels = COM_data_type_num_channels(
+            input_op->get_output_socket()->get_data_type());
+        for (const int channel : IndexRange(num_channels)) {
+          result_hash = BLI_ghashutil_combine_hash(*result_hash, get_default_hash(elem[channel]));
+        }
+      }
+      else if (std::optional<uint64_t> input_hash = get_result_hash(input_op)) {
+        result_hash = BLI_ghashutil_combine_hash(*result_hash, *input_hash);
+      }
+      else {
+        result_hash = std::nullopt;
+      }
+    }
+  }
+
+  result_hashes_.add(op, result_hash);
+  return result_hash;
+}
+
+bool FullFrameExecutionModel::find_cached_result(NodeOperation *op)
+{
+  MemoryBuffer *cached_buf = cached_results_.lookup_or_add_cb(op, [&]() -> MemoryBuffer * {
+    if (!use_cache_ || op->get_number_of_output_sockets() == 0 ||
+        op->get_flags().is_constant_operation)
+    {
+      return nullptr;
+    }
+    const std::optional<uint64_t> result_hash = get_result_hash(op);
+    MemoryBuffer *buf = result_hash ? OperationCache::lookup(*result_hash) : nullptr;
+    /* Guard against hash collisions with results of another size or data type. */
+    const int num_channels = COM_data_type_num_channels(op->get_output_socket()->get_data_type());
+    if (buf == nullptr || buf->get_width() != op->get_width() ||
+        buf->get_height() != op->get_height() || buf->get_num_channels() != num_channels)
+    {
+      return nullptr;
+    }
+    return buf;
+  });
+  return cached_buf != nullptr;
+}
+
+void FullFrameExecutionModel::use_cached_result(NodeOperation *op)
+{
+  /* The cache keeps the result until the next execution, read it without copying. Its memory
+   * belongs to the cache, so it isn't counted as memory in use by this execution. */
+  MemoryBuffer *cached_buf = cached_results_.lookup(op);
+  MemoryBuffer *op_buf = new MemoryBuffer(
+      cached_buf->get_buffer(), cached_buf->get_num_channels(), cached_buf->get_rect());
+  active_buffers_.set_rendered_buffer(op, std::unique_ptr<MemoryBuffer>(op_buf));
+  DebugInfo::operation_rendered(op, op_buf);
+
+  /* Inputs of the operation were not rendered and have no reads to report. */
+  num_operations_finished_++;
+  update_progress_bar();
+}
+
+MemoryBuffer *FullFrameExecutionModel::store_result(NodeOperation *op, MemoryBuffer *op_buf)
+{
+  if (!use_cache_ || op->get_flags().is_constant_operation || op_buf->get_memory_size() == 0) {
+    return op_buf;
+  }
+  const std::optional<uint64_t> result_hash = get_result_hash(op);
+  if (!result_hash) {
+    return op_buf;
+  }
+
+  /* Results only rendered within borders are incomplete for other executions. */
+  const rcti &canvas = op->get_canvas();
+  const Vector<rcti> areas = active_buffers_.get_areas_to_render(op, 0, 0);
+  const bool is_complete = std::any_of(areas.begin(), areas.end(), [&](const rcti &area) {
+    return BLI_rcti_inside_rcti(&area, &canvas);
+  });
+  if (!is_complete || !OperationCache::reserve(op_buf->get_memory_size())) {
+    return op_buf;
+  }
+
+  /* From now on the memory belongs to the cache, like reused results. */
+  active_buffers_.add_memory_in_use(-op_buf->get_memory_size());
+  MemoryBuffer *result_buf = new MemoryBuffer(
+      op_buf->get_buffer(), op_buf->get_num_channels(), op_buf->get_rect());
+  OperationCache::add(*result_hash, std::unique_ptr<MemoryBuffer>(op_buf));
+  return result_buf;
+}
+
+void FullFrameExecutionModel::determine_stripe_operations()
+{
+  Map<NodeOperation *, Vector<NodeOperation *>> readers;
+  for (NodeOperation *op : operations_) {
+    for (int i = 0; i < op->get_number_of_input_sockets(); i++) {
+      readers.lookup_or_add_default(op->get_input_operation(i)).append(op);
+    }
+  }
+
+  for (NodeOperation *op : operations_) {
+    const Vector<NodeOperation *> *op_readers = readers.lookup_ptr(op);
+    /* Operations read by several operations or sockets are rendered fully once, instead of once
+     * for every reader. */
+    if (op_readers == nullptr || op_readers->size() != 1) {
+      continue;
+    }
+    const NodeOperation *reader = op_readers->first();
+    if (has_cached_result(op)) {
+      continue;
+    }
+    const bool has_size = op->get_width() > 0 && op->get_height() > 0;
+    if (has_size && op->get_number_of_output_sockets() > 0 &&
+        op->get_flags().is_per_pixel_operation && reader->get_flags().is_per_pixel_operation)
+    {
+      stripe_operations_.add(op);
+    }
+  }
+}
+
+Vector<NodeOperation *> FullFrameExecutionModel::get_stripe_dependencies(NodeOperation *op)
+{
+  /* Every stripe operation has a single reader, so dependencies form a tree and are only found
+   * once. Add them from outputs to inputs. */
+  Vector<NodeOperation *> dependencies;
+  Vector<NodeOperation *> stack;
+  stack.append(op);
+  while (!stack.is_empty()) {
+    NodeOperation *operation = stack.pop_last();
+    for (int i = 0; i < operation->get_number_of_input_sockets(); i++) {
+      NodeOperation *input_op = operation->get_input_operation(i);
+      if (stripe_operations_.contains(input_op)) {
+        dependencies.append(input_op);
+        stack.append(input_op);
+      }
+    }
+  }
+
+  /* Reverse to get dependencies from inputs to outputs. */
+  std::reverse(dependencies.begin(), dependencies.end());
+
+  return dependencies;
+}
+
+timeit::Nanoseconds FullFrameExecutionModel::render_operation_in_stripes(
+    NodeOperation *op, MemoryBuffer *op_buf, Span<NodeOperation *> stripe_dependencies)
+{
+  /* Number of pixels of a stripe, keeping stripe buffers of large images small. */
+  constexpr int stripe_pixels_num = 1 << 20;
+
+  timeit::Nanoseconds stripe_dependencies_time = timeit::Nanoseconds::zero();
+  const auto init_or_deinit_dependencies = [&](const bool init) {
+    for (NodeOperation *operation : stripe_dependencies) {
+      const timeit::TimePoint before_time = timeit::Clock::now();
+      if (init) {
+        operation->init_execution();
+      }
+      else {
+        operation->deinit_execution();
+      }
+      const timeit::Nanoseconds time = timeit::Clock::now() - before_time;
+      add_evaluation_time(operation, time);
+      stripe_dependencies_time += time;
+    }
+  };
+
+  op->init_execution();
+  init_or_deinit_dependencies(true);
+  for (const rcti &area : active_buffers_.get_areas_to_render(op, 0, 0)) {
+    if (BLI_rcti_is_empty(&area)) {
+      continue;
+    }
+    /* Keep enough rows to split the work of every stripe between all threads. */
+    const int stripe_height = std::max(WorkScheduler::get_num_cpu_threads(),
+                                       stripe_pixels_num / BLI_rcti_size_x(&area));
+    for (int y = area.ymin; y < area.ymax; y += stripe_height) {
+      rcti stripe_area = area;
+      stripe_area.ymin = y;
+      stripe_area.ymax = std::min(y + stripe_height, area.ymax);
+      stripe_dependencies_time += render_stripe(op, op_buf, stripe_area, stripe_dependencies);
+    }
+  }
+  init_or_deinit_dependencies(false);
+  op->deinit_execution();
+  return stripe_dependencies_time;
+}
+
+timeit::Nanoseconds FullFrameExecutionModel::render_stripe(
+    NodeOperation *op,
+    MemoryBuffer *op_buf,
+    const rcti &stripe_area,
+    Span<NodeOperation *> stripe_dependencies)
+{
+  /* Determine areas of interest of the stripe dependencies, from outputs to inputs. */
+  Map<NodeOperation *, rcti> areas;
+  areas.add_new(op, stripe_area);
+  for (int64_t i = stripe_dependencies.size(); i >= 0; i--) {
+    NodeOperation *operation = i == stripe_dependencies.size() ? op : stripe_dependencies[i];
+    const rcti &render_area = areas.lookup(operation);
+    for (int j = 0; j < operation->get_number_of_input_sockets(); j++) {
+      NodeOperation *input_op = operation->get_input_operation(j);
+      if (!stripe_operations_.contains(input_op)) {
+        continue;
+      }
+      rcti input_area;
+      operation->get_area_of_interest(input_op, render_area, input_area);
+      BLI_rcti_isect(&input_area, &input_op->get_canvas(), &input_area);
+      areas.add_new(input_op, input_area);
+    }
+  }
+
+  /* Render stripe dependencies into buffers only covering their area of interest. Operations are
+   * rendered without offset, see #render_operation. */
+  timeit::Nanoseconds stripe_dependencies_time = timeit::Nanoseconds::zero();
+  Map<NodeOperation *, std::unique_ptr<MemoryBuffer>> stripe_buffers;
+  for (NodeOperation *operation : stripe_dependencies) {
+    const timeit::TimePoint before_time = timeit::Clock::now();
+
+    rcti render_area = areas.lookup(operation);
+    BLI_rcti_translate(&render_area, -operation->get_canvas().xmin, -operation->get_canvas().ymin);
+    const DataType data_type = operation->get_output_socket(0)->get_data_type();
+    const bool is_empty = BLI_rcti_is_empty(&render_area);
+    std::unique_ptr<MemoryBuffer> buf = std::make_unique<MemoryBuffer>(
+        data_type, render_area, is_empty);
+    active_buffers_.add_memory_in_use(buf->get_memory_size());
+    if (is_empty) {
+      buf->clear();
+    }
+    else {
+      Vector<MemoryBuffer *> input_bufs = get_input_buffers(operation, 0, 0, &stripe_buffers);
+      operation->render_initialized(buf.get(), {render_area}, input_bufs);
+      for (MemoryBuffer *input_buf : input_bufs) {
+        delete input_buf;
+      }
+    }
+    stripe_buffers.add_new(operation, std::move(buf));
+
+    const timeit::Nanoseconds time = timeit::Clock::now() - before_time;
+    add_evaluation_time(operation, time);
+    stripe_dependencies_time += time;
+  }
+
+  rcti render_area = stripe_area;
+  BLI_rcti_translate(&render_area, -op->get_canvas().xmin, -op->get_canvas().ymin);
+  Vector<MemoryBuffer *> input_bufs = get_input_buffers(op, 0, 0, &stripe_buffers);
+  op->render_initialized(op_buf, {render_area}, input_bufs);
+  for (MemoryBuffer *input_buf : input_bufs) {
+    delete input_buf;
+  }
+
+  for (const std::unique_ptr<MemoryBuffer> &buf : stripe_buffers.values()) {
+    active_buffers_.add_memory_in_use(-buf->get_memory_size());
+  }
+
+  return stripe_dependencies_time;
 }
 
 void FullFrameExecutionModel::render_operations()
@@ -158,9 +484,10 @@ void FullFrameExecutionModel::render_operations()
 
 /**
  * Returns all dependencies from inputs to outputs. A dependency may be repeated when
- * several operations depend on it.
+ * several operations depend on it. Dependencies of operations with a cached result are skipped.
  */
-static Vector<NodeOperation *> get_operation_dependencies(NodeOperation *operation)
+static Vector<NodeOperation *> get_operation_dependencies(
+    NodeOperation *operation, const Map<NodeOperation *, MemoryBuffer *> &cached_results)
 {
   /* Get dependencies from outputs to inputs. */
   Vector<NodeOperation *> dependencies;
@@ -170,6 +497,9 @@ static Vector<NodeOperation *> get_operation_dependencies(NodeOperation *operati
     Vector<NodeOperation *> outputs(next_outputs);
     next_outputs.clear();
     for (NodeOperation *output : outputs) {
+      if (cached_results.lookup_default(output, nullptr)) {
+        continue;
+      }
       for (int i = 0; i < output->get_number_of_input_sockets(); i++) {
         next_outputs.append(output->get_input_operation(i));
       }
@@ -186,9 +516,10 @@ static Vector<NodeOperation *> get_operation_dependencies(NodeOperation *operati
 void FullFrameExecutionModel::render_output_dependencies(NodeOperation *output_op)
 {
   BLI_assert(output_op->is_output_operation(context_.is_rendering()));
-  Vector<NodeOperation *> dependencies = get_operation_dependencies(output_op);
+  Vector<NodeOperation *> dependencies = get_operation_dependencies(output_op, cached_results_);
   for (NodeOperation *op : dependencies) {
-    if (!active_buffers_.is_operation_rendered(op)) {
+    /* Stripe operations are rendered by the operation reading them. */
+    if (!stripe_operations_.contains(op) && !active_buffers_.is_operation_rendered(op)) {
       render_operation(op);
     }
   }
@@ -212,6 +543,9 @@ void FullFrameExecutionModel::determine_areas_to_render(NodeOperation *output_op
     }
 
     active_buffers_.register_area(operation, render_area);
+    if (find_cached_result(operation)) {
+      continue;
+    }
 
     const int num_inputs = operation->get_number_of_input_sockets();
     for (int i = 0; i < num_inputs; i++) {
@@ -235,6 +569,9 @@ void FullFrameExecutionModel::determine_reads(NodeOperation *output_op)
   stack.append(output_op);
   while (stack.size() > 0) {
     NodeOperation *operation = stack.pop_last();
+    if (has_cached_result(operation)) {
+      continue;
+    }
     const int num_inputs = operation->get_number_of_input_sockets();
     for (int i = 0; i < num_inputs; i++) {
       NodeOperation *input_op = operation->get_input_operation(i);
@@ -4,6 +4,11 @@
 
 #pragma once
 
+#include <optional>
+
+#include "BLI_map.hh"
+#include "BLI_set.hh"
+#include "BLI_timeit.hh"
 #include "BLI_vector.hh"
 
 #include "COM_Enums.h"
@@ -24,6 +29,14 @@ class SharedOperationBuffers;
 
 /**
  * Fully renders operations in order from inputs to outputs.
+ *
+ * Per pixel operations only read by another per pixel operation are the exception, they are
+ * rendered in stripes together with the operation reading them. Only the last operation of such
+ * a chain gets a full size buffer, which bounds the memory used by long chains of color and
+ * math operations on large images.
+ *
+ * When editing, results of operations are kept in the #OperationCache and reused by the next
+ * executions. Operations only needed to render a cached result are not rendered at all.
  */
 class FullFrameExecutionModel : public ExecutionModel {
  private:
@@ -43,12 +56,37 @@ class FullFrameExecutionModel : public ExecutionModel {
    */
   Vector<eCompositorPriority> priorities_;
 
+  /**
+   * Operations rendered in stripes by the operation reading them.
+   */
+  Set<NodeOperation *> stripe_operations_;
+
+  /**
+   * Whether operations results are read from and stored in the #OperationCache.
+   */
+  bool use_cache_;
+
+  /**
+   * Hashes identifying operations results across executions, none when an operation or one of
+   * its inputs doesn't implement #NodeOperation::hash_output_params.
+   */
+  Map<NodeOperation *, std::optional<uint64_t>> result_hashes_;
+
+  /**
+   * Results found in the cache, null for operations that must be rendered.
+   */
+  Map<NodeOperation *, MemoryBuffer *> cached_results_;
+
  public:
   FullFrameExecutionModel(CompositorContext &context,
                           SharedOperationBuffers &shared_buffers,
                           Span<NodeOperation *> operations);
 
   void execute(ExecutionSystem &exec_system) override;
+  /**
+   * Renders all output operations, #execute without the debug output of the execution system.
+   */
+  void render();
 
  private:
   void determine_areas_to_render_and_reads();
@@ -61,10 +99,52 @@ class FullFrameExecutionModel : public ExecutionModel {
    * Returns input buffers with an offset relative to given output coordinates.
    * Returned memory buffers must be deleted.
    */
-  Vector<MemoryBuffer *> get_input_buffers(NodeOperation *op, int output_x, int output_y);
+  Vector<MemoryBuffer *> get_input_buffers(
+      NodeOperation *op,
+      int output_x,
+      int output_y,
+      const Map<NodeOperation *, std::unique_ptr<MemoryBuffer>> *stripe_buffers = nullptr);
   MemoryBuffer *create_operation_buffer(NodeOperation *op, int output_x, int output_y);
   void render_operation(NodeOperation *op);
 
+  /**
+   * Determines operations that can be rendered in stripes, see #stripe_operations_.
+   */
+  void determine_stripe_operations();
+  /**
+   * Returns operations rendered in stripes by given operation, from inputs to outputs.
+   */
+  Vector<NodeOperation *> get_stripe_dependencies(NodeOperation *op);
+  /**
+   * Renders given operation areas in stripes, rendering the stripe dependencies for every stripe.
+   * The execution of all the operations is initialized once for all stripes.
+   * Returns time spent rendering the stripe dependencies.
+   */
+  timeit::Nanoseconds render_operation_in_stripes(NodeOperation *op,
+                                                  MemoryBuffer *op_buf,
+                                                  Span<NodeOperation *> stripe_dependencies);
+  timeit::Nanoseconds render_stripe(NodeOperation *op,
+                                    MemoryBuffer *op_buf,
+                                    const rcti &stripe_area,
+                                    Span<NodeOperation *> stripe_dependencies);
+  void add_evaluation_time(NodeOperation *op, timeit::Nanoseconds time);
+
+  std::optional<uint64_t> get_result_hash(NodeOperation *op);
+  /**
+   * Looks up given operation result in the cache, its inputs don't need to be rendered when found.
+   */
+  bool find_cached_result(NodeOperation *op);
+  bool has_cached_result(NodeOperation *op) const
+  {
+    return cached_results_.lookup_default(op, nullptr) != nullptr;
+  }
+  void use_cached_result(NodeOperation *op);
+  /**
+   * Stores given operation result in the cache when possible. Returns the buffer to read the
+   * result from during this execution, given buffer is owned by the cache when stored.
+   */
+  MemoryBuffer *store_result(NodeOperation *op, MemoryBuffer *op_buf);
+
   void operation_finished(NodeOperation *operation);
 
   /**
@@ -0,0 +1,188 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "atomic_ops.h"
+
+#include "COM_FusedOperation.h"
+
+namespace blender::compositor {
+
+FusedOperation::FusedOperation(Span<NodeOperation *> operations)
+{
+  BLI_assert(operations.size() > 1);
+  for (NodeOperation *operation : operations) {
+    BLI_assert(can_fuse(*operation));
+    operations_.append(static_cast<MultiThreadedOperation *>(operation));
+  }
+
+  for (MultiThreadedOperation *operation : operations_) {
+    Vector<FusedInput> inputs;
+    for (int i = 0; i < operation->get_number_of_input_sockets(); i++) {
+      NodeOperationInput *socket = operation->get_input_socket(i);
+      BLI_assert(socket->is_connected());
+      NodeOperation *input_op = &socket->get_link()->get_operation();
+      const int fused_index = operations_.first_index_of_try(
+          static_cast<MultiThreadedOperation *>(input_op));
+      if (fused_index != -1) {
+        BLI_assert(fused_index < operations_.size() - 1);
+        inputs.append({true, fused_index});
+      }
+      else {
+        inputs.append({false, int(external_links_.size())});
+        external_links_.append(socket->get_link());
+        add_input_socket(socket->get_data_type(), ResizeMode::None);
+      }
+    }
+    operation_inputs_.append(std::move(inputs));
+  }
+
+  evaluation_times_.reinitialize(operations_.size());
+  evaluation_times_.fill(0);
+
+  MultiThreadedOperation *output_op = operations_.last();
+  add_output_socket(output_op->get_output_socket()->get_data_type());
+  set_canvas(output_op->get_canvas());
+  flags_.is_per_pixel_operation = true;
+}
+
+FusedOperation::~FusedOperation()
+{
+  for (MultiThreadedOperation *operation : operations_) {
+    delete operation;
+  }
+}
+
+bool FusedOperation::can_fuse(const NodeOperation &operation)
+{
+  if (!operation.get_flags().is_per_pixel_operation ||
+      operation.get_number_of_output_sockets() != 1)
+  {
+    return false;
+  }
+  const MultiThreadedOperation *multi_threaded_op = dynamic_cast<const MultiThreadedOperation *>(
+      &operation);
+  return multi_threaded_op && multi_threaded_op->num_passes_ == 1 &&
+         !multi_threaded_op->uses_pass_hooks_;
+}
+
+void FusedOperation::init_data()
+{
+  for (MultiThreadedOperation *operation : operations_) {
+    operation->init_data();
+  }
+}
+
+void FusedOperation::foreach_fused_evaluation_time(
+    const timeit::Nanoseconds time,
+    const FunctionRef<void(NodeOperation &operation, timeit::Nanoseconds time)> fn) const
+{
+  int64_t total_time = 0;
+  for (const int64_t operation_time : evaluation_times_) {
+    total_time += operation_time;
+  }
+  /* The output operation gets the rounding remainder, so the split times add up to the time. It
+   * gets all of it when nothing was evaluated, e.g. for the time spent initializing. */
+  timeit::Nanoseconds remaining_time = time;
+  for (const int i : operations_.index_range().drop_back(1)) {
+    const double share = total_time == 0 ? 0.0 :
+                                            double(evaluation_times_[i]) / double(total_time);
+    const timeit::Nanoseconds operation_time(int64_t(double(time.count()) * share));
+    fn(*operations_[i], operation_time);
+    remaining_time -= operation_time;
+  }
+  fn(*operations_.last(), remaining_time);
+}
+
+void FusedOperation::init_execution()
+{
+  evaluation_times_.fill(0);
+  for (MultiThreadedOperation *operation : operations_) {
+    operation->init_execution();
+  }
+}
+
+void FusedOperation::deinit_execution()
+{
+  for (MultiThreadedOperation *operation : operations_) {
+    operation->deinit_execution();
+  }
+}
+
+std::unique_ptr<MetaData> FusedOperation::get_meta_data()
+{
+  return operations_.last()->get_meta_data();
+}
+
+void FusedOperation::hash_output_params()
+{
+  for (const int i : operations_.index_range()) {
+    const std::optional<NodeOperationHash> hash = operations_[i]->generate_hash();
+    if (!hash) {
+      MultiThreadedOperation::hash_output_params();
+      return;
+    }
+    hash_param(hash->get_params_hash());
+    for (const FusedInput &input : operation_inputs_[i]) {
+      hash_params(input.is_fused, input.index);
+    }
+  }
+}
+
+void FusedOperation::update_memory_buffer_partial(MemoryBuffer *output,
+                                                  const rcti &area,
+                                                  Span<MemoryBuffer *> inputs)
+{
+  const int width = BLI_rcti_size_x(&area);
+  const int height = BLI_rcti_size_y(&area);
+  if (width <= 0 || height <= 0) {
+    return;
+  }
+  const int block_rows = std::max(1, BLOCK_PIXELS / width);
+
+  /* Intermediate results of every fused operation but the output one, for a single block. */
+  const int num_intermediate = operations_.size() - 1;
+  Array<Array<float>> block_data(num_intermediate);
+  for (int i = 0; i < num_intermediate; i++) {
+    const int num_channels = COM_data_type_num_channels(
+        operations_[i]->get_output_socket()->get_data_type());
+    block_data[i].reinitialize(size_t(width) * block_rows * num_channels);
+  }
+
+  Vector<std::unique_ptr<MemoryBuffer>> block_buffers;
+  Vector<MemoryBuffer *> operation_inputs;
+  Array<int64_t> operation_times(operations_.size(), 0);
+  for (int ymin = area.ymin; ymin < area.ymax; ymin += block_rows) {
+    rcti block;
+    BLI_rcti_init(&block, area.xmin, area.xmax, ymin, std::min(ymin + block_rows, area.ymax));
+
+    block_buffers.clear();
+    for (int i = 0; i < num_intermediate; i++) {
+      const int num_channels = COM_data_type_num_channels(
+          operations_[i]->get_output_socket()->get_data_type());
+      block_buffers.append(
+          std::make_unique<MemoryBuffer>(block_data[i].data(), num_channels, block));
+    }
+
+    timeit::TimePoint start_time = timeit::Clock::now();
+    for (const int i : operations_.index_range()) {
+      operation_inputs.clear();
+      for (const FusedInput &input : operation_inputs_[i]) {
+        operation_inputs.append(input.is_fused ? block_buffers[input.index].get() :
+                                                 inputs[input.index]);
+      }
+      MemoryBuffer *operation_output = i < num_intermediate ? block_buffers[i].get() : output;
+      operations_[i]->update_memory_buffer_partial(operation_output, block, operation_inputs);
+
+      const timeit::TimePoint end_time = timeit::Clock::now();
+      operation_times[i] += timeit::Nanoseconds(end_time - start_time).count();
+      start_time = end_time;
+    }
+  }
+
+  for (const int i : operations_.index_range()) {
+    atomic_add_and_fetch_int64(&evaluation_times_[i], operation_times[i]);
+  }
+}
+
+}  // namespace blender::compositor
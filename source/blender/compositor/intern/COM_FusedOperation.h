@@ -0,0 +1,96 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#pragma once
+
+#include "BLI_array.hh"
+#include "BLI_function_ref.hh"
+#include "BLI_timeit.hh"
+
+#include "COM_MultiThreadedOperation.h"
+
+namespace blender::compositor {
+
+/**
+ * Evaluates a tree of per pixel operations at once. The fused operations are executed one after
+ * the other on small blocks of pixels, so intermediate results stay in the CPU cache instead of
+ * being written to and read back from full size buffers.
+ *
+ * The fused operations are owned by this operation. Inputs of the fused operations that aren't
+ * linked to another fused operation become inputs of this operation. The input sockets of the
+ * fused operations stay linked, so they can still access their input operations, for example
+ * using #NodeOperation::get_input_socket_reader in #init_execution.
+ */
+class FusedOperation : public MultiThreadedOperation {
+ private:
+  /** Number of pixels evaluated by every fused operation before going to the next one. */
+  static constexpr int BLOCK_PIXELS = 4096;
+
+  /** Where a fused operation input reads from. */
+  struct FusedInput {
+    /** Whether it reads the result of another fused operation instead of an external input. */
+    bool is_fused;
+    /** Index in #operations_ or in the inputs of this operation. */
+    int index;
+  };
+
+  /** Fused operations ordered from inputs to outputs, the last one is the output. */
+  Vector<MultiThreadedOperation *> operations_;
+  /** Input sources of every fused operation, same order as #operations_. */
+  Vector<Vector<FusedInput>> operation_inputs_;
+  /** Outputs linked to the inputs of this operation, until linked by the builder. */
+  Vector<NodeOperationOutput *> external_links_;
+  /**
+   * Time spent in every fused operation since the execution was initialized, summed over all
+   * threads, in nanoseconds. Used to split the evaluation time between their nodes.
+   */
+  Array<int64_t> evaluation_times_;
+
+ public:
+  /**
+   * \param operations: Operations to fuse, ordered from inputs to outputs. The last one is the
+   * output, every other one must only be read by operations after it in the list.
+   */
+  FusedOperation(Span<NodeOperation *> operations);
+  ~FusedOperation();
+
+  /**
+   * Whether the operation can be part of a fused operation: it must only read input pixels at
+   * the coordinates it writes and be evaluated in a single pass, without pass hooks.
+   */
+  static bool can_fuse(const NodeOperation &operation);
+
+  /** Outputs that must be linked to the inputs of this operation, in socket order. */
+  Span<NodeOperationOutput *> get_external_links() const
+  {
+    return external_links_;
+  }
+
+  int get_num_fused_operations() const
+  {
+    return operations_.size();
+  }
+
+  /**
+   * Split the time spent evaluating this operation between the fused operations, in proportion
+   * to the time spent in each of them since the execution was initialized. So the profiler still
+   * shows the time of every fused node instead of adding it all to the output node.
+   */
+  void foreach_fused_evaluation_time(
+      timeit::Nanoseconds time,
+      FunctionRef<void(NodeOperation &operation, timeit::Nanoseconds time)> fn) const;
+
+  void init_data() override;
+  void init_execution() override;
+  void deinit_execution() override;
+  std::unique_ptr<MetaData> get_meta_data() override;
+
+ protected:
+  void hash_output_params() override;
+  void update_memory_buffer_partial(MemoryBuffer *output,
+                                    const rcti &area,
+                                    Span<MemoryBuffer *> inputs) override;
+};
+
+}  // namespace blender::compositor
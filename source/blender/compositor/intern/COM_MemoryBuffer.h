@@ -133,6 +133,14 @@ class MemoryBuffer {
     return is_a_single_elem_;
   }
 
+  /**
+   * Whether the buffer memory is freed with the buffer, instead of being owned by someone else.
+   */
+  bool owns_data() const
+  {
+    return owns_data_;
+  }
+
   float &operator[](int index)
   {
     BLI_assert(is_a_single_elem_ ? index < num_channels_ :
@@ -680,6 +688,14 @@ class MemoryBuffer {
   float get_max_value() const;
   float get_max_value(const rcti &rect) const;
 
+  /**
+   * Size of the buffer elements in bytes.
+   */
+  int64_t get_memory_size() const
+  {
+    return buffer_len() * num_channels_ * sizeof(float);
+  }
+
  private:
   void set_strides();
   const int64_t buffer_len() const
@@ -11,6 +11,7 @@ MultiThreadedOperation::MultiThreadedOperation()
 {
   num_passes_ = 1;
   current_pass_ = 0;
+  uses_pass_hooks_ = false;
 }
 
 void MultiThreadedOperation::update_memory_buffer(MemoryBuffer *output,
@@ -9,6 +9,9 @@
 namespace blender::compositor {
 
 class MultiThreadedOperation : public NodeOperation {
+  /* Evaluates the fused operations partial updates directly. */
+  friend class FusedOperation;
+
  protected:
   /**
    * Number of execution passes.
@@ -18,6 +21,11 @@ class MultiThreadedOperation : public NodeOperation {
    * Current execution pass.
    */
   int current_pass_;
+  /**
+   * Whether #update_memory_buffer_started or #update_memory_buffer_finished are overridden.
+   * They need the full output and input buffers, so such operations can't be fused.
+   */
+  bool uses_pass_hooks_;
 
  protected:
   MultiThreadedOperation();
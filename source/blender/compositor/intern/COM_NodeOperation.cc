@@ -228,10 +228,17 @@ void NodeOperation::render_full_frame(MemoryBuffer *output_buf,
                                       Span<MemoryBuffer *> inputs_bufs)
 {
   init_execution();
+  render_initialized(output_buf, areas, inputs_bufs);
+  deinit_execution();
+}
+
+void NodeOperation::render_initialized(MemoryBuffer *output_buf,
+                                       Span<rcti> areas,
+                                       Span<MemoryBuffer *> inputs_bufs)
+{
   for (const rcti &area : areas) {
     update_memory_buffer(output_buf, area, inputs_bufs);
   }
-  deinit_execution();
 }
 
 /** \} */
@@ -206,6 +206,12 @@ struct NodeOperationFlags {
    */
   bool can_be_constant : 1;
 
+  /**
+   * Whether every output pixel only depends on the input pixels at the same coordinates. Such
+   * operations can be rendered in stripes, so their inputs don't need full size buffers.
+   */
+  bool is_per_pixel_operation : 1;
+
   NodeOperationFlags()
   {
     use_render_border = false;
@@ -217,6 +223,7 @@ struct NodeOperationFlags {
     use_datatype_conversion = true;
     is_constant_operation = false;
     can_be_constant = false;
+    is_per_pixel_operation = false;
   }
 };
 
@@ -236,6 +243,12 @@ struct NodeOperationHash {
     return operation_;
   }
 
+  /** Hash of the operation type and parameters, independent of its inputs. */
+  size_t get_params_hash() const
+  {
+    return BLI_ghashutil_combine_hash(type_hash_, params_hash_);
+  }
+
   bool operator==(const NodeOperationHash &other) const
   {
     return type_hash_ == other.type_hash_ && parents_hash_ == other.parents_hash_ &&
@@ -492,6 +505,13 @@ class NodeOperation {
    * \param inputs_bufs: Inputs operations buffers.
    */
   void render(MemoryBuffer *output_buf, Span<rcti> areas, Span<MemoryBuffer *> inputs_bufs);
+  /**
+   * Same as #render for an operation whose execution is already initialized, so that it can be
+   * rendered in several parts between a single #init_execution and #deinit_execution call.
+   */
+  void render_initialized(MemoryBuffer *output_buf,
+                          Span<rcti> areas,
+                          Span<MemoryBuffer *> inputs_bufs);
 
   /**
    * Executes operation updating output memory buffer. Single-threaded calls.
@@ -10,6 +10,7 @@
 
 #include "COM_Converter.h"
 #include "COM_Debug.h"
+#include "COM_FusedOperation.h"
 
 #include "COM_PreviewOperation.h"
 #include "COM_SetColorOperation.h"
@@ -90,6 +91,8 @@ void NodeOperationBuilder::convert_to_operations(ExecutionSystem *system)
   save_graphviz("compositor_prior_merging");
   merge_equal_operations();
 
+  fuse_per_pixel_operations();
+
   /* links not available from here on */
   /* XXX make links_ a local variable to avoid confusion! */
   links_.clear();
@@ -493,6 +496,79 @@ void NodeOperationBuilder::merge_equal_operations(NodeOperation *from, NodeOpera
   delete from;
 }
 
+void NodeOperationBuilder::fuse_per_pixel_operations()
+{
+  MultiValueMap<NodeOperation *, NodeOperationInput *> readers;
+  for (const Link &link : links_) {
+    readers.add(&link.from()->get_operation(), link.to());
+  }
+
+  /* An operation is fused into its reader when nothing else reads it and both have the same
+   * canvas, so its result is only needed at the pixels the reader writes. */
+  auto is_fused_into_reader = [&](NodeOperation *op) {
+    const Span<NodeOperationInput *> op_readers = readers.lookup(op);
+    if (op_readers.size() != 1 || !FusedOperation::can_fuse(*op)) {
+      return false;
+    }
+    const NodeOperation &reader = op_readers.first()->get_operation();
+    return FusedOperation::can_fuse(reader) &&
+           BLI_rcti_compare(&op->get_canvas(), &reader.get_canvas());
+  };
+
+  const Vector<NodeOperation *> operations = operations_;
+  for (NodeOperation *op : operations) {
+    if (!FusedOperation::can_fuse(*op) || is_fused_into_reader(op)) {
+      continue;
+    }
+
+    /* Gather the operations fused into this one, every operation is added after its reader. */
+    Vector<NodeOperation *> fused_ops = {op};
+    for (int i = 0; i < fused_ops.size(); i++) {
+      NodeOperation *fused_op = fused_ops[i];
+      for (int j = 0; j < fused_op->get_number_of_input_sockets(); j++) {
+        NodeOperation *input_op = fused_op->get_input_operation(j);
+        if (input_op && is_fused_into_reader(input_op)) {
+          fused_ops.append(input_op);
+        }
+      }
+    }
+    if (fused_ops.size() == 1) {
+      continue;
+    }
+
+    for (NodeOperation *fused_op : fused_ops) {
+      fused_op->set_bnodetree(context_->get_bnodetree());
+    }
+    std::reverse(fused_ops.begin(), fused_ops.end());
+    FusedOperation *fused = new FusedOperation(fused_ops);
+    std::reverse(fused_ops.begin(), fused_ops.end());
+
+    add_operation(fused);
+    fused->set_name(op->get_name());
+    /* The profiler splits the time of the fused operation between the fused nodes. */
+    fused->set_node_instance_key(op->get_node_instance_key());
+    /* Links to the fused operations are only removed from the graph, their input sockets stay
+     * linked so they can still access their input operations. Only the output operation is read
+     * outside of the fused operation. */
+    links_.remove_if(
+        [&](const Link &link) { return fused_ops.contains(&link.to()->get_operation()); });
+    for (Link &link : links_) {
+      if (&link.from()->get_operation() == op) {
+        link.to()->set_link(fused->get_output_socket());
+        link = Link(fused->get_output_socket(), link.to());
+      }
+    }
+    for (NodeOperation *fused_op : fused_ops) {
+      operations_.remove_first_occurrence_and_reorder(fused_op);
+    }
+
+    const Span<NodeOperationOutput *> external_links = fused->get_external_links();
+    for (const int i : external_links.index_range()) {
+      add_link(external_links[i], fused->get_input_socket(i));
+    }
+  }
+}
+
 Vector<NodeOperationInput *> NodeOperationBuilder::cache_output_links(
     NodeOperationOutput *output) const
 {
@@ -142,6 +142,8 @@ class NodeOperationBuilder {
   void unlink_inputs_and_relink_outputs(NodeOperation *unlinked_op, NodeOperation *linked_op);
   /** Merge operations with same type, inputs and parameters that produce the same result. */
   void merge_equal_operations();
+  /** Replace trees of per pixel operations by operations evaluating them at once. */
+  void fuse_per_pixel_operations();
   void merge_equal_operations(NodeOperation *from, NodeOperation *into);
   void save_graphviz(StringRefNull name = "");
 #ifdef WITH_CXX_GUARDEDALLOC
@@ -0,0 +1,131 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "BLI_map.hh"
+
+#include "DNA_image_types.h"
+#include "DNA_userdef_types.h"
+
+#include "BKE_image.h"
+#include "BKE_image_partial_update.hh"
+
+#include "COM_MemoryBuffer.h"
+#include "COM_OperationCache.h"
+
+namespace blender::compositor {
+
+struct CachedResult {
+  std::unique_ptr<MemoryBuffer> buffer;
+  /** Last execution using the result. */
+  int64_t last_used_execution;
+};
+
+struct ImageVersion {
+  PartialUpdateUser *partial_update_user;
+  int version;
+  /** Last execution reading the image. */
+  int64_t last_used_execution;
+};
+
+static struct {
+  Map<uint64_t, CachedResult> results;
+  /** Size of all cached results in bytes. */
+  int64_t memory_size = 0;
+  int64_t execution = 0;
+  /** Versions of images by session UID, since images may be freed between executions. */
+  Map<uint, ImageVersion> image_versions;
+  /** Last version given to an image, versions are unique among all images. */
+  int last_image_version = 0;
+} g_operation_cache;
+
+void OperationCache::execution_started()
+{
+  /* Stop tracking images not read by the last execution, they may have been deleted. An image
+   * read again gets a new version, so no result of its previous pixels is reused. */
+  g_operation_cache.image_versions.remove_if([](const auto item) {
+    if (item.value.last_used_execution < g_operation_cache.execution) {
+      BKE_image_partial_update_free(item.value.partial_update_user);
+      return true;
+    }
+    return false;
+  });
+  g_operation_cache.execution++;
+  /* Free results over a memory cache limit lowered since the last execution. */
+  reserve(0);
+}
+
+MemoryBuffer *OperationCache::lookup(const uint64_t hash)
+{
+  CachedResult *result = g_operation_cache.results.lookup_ptr(hash);
+  if (result == nullptr) {
+    return nullptr;
+  }
+  result->last_used_execution = g_operation_cache.execution;
+  return result->buffer.get();
+}
+
+bool OperationCache::reserve(const int64_t size)
+{
+  const int64_t memory_limit = int64_t(U.memcachelimit) * 1024 * 1024;
+  if (size > memory_limit) {
+    return false;
+  }
+  while (g_operation_cache.memory_size + size > memory_limit) {
+    /* Free the least recently used result, results used by the current execution are still read
+     * by its operations. */
+    std::optional<uint64_t> lru_hash;
+    int64_t lru_execution = g_operation_cache.execution;
+    for (const auto item : g_operation_cache.results.items()) {
+      if (item.value.last_used_execution < lru_execution) {
+        lru_hash = item.key;
+        lru_execution = item.value.last_used_execution;
+      }
+    }
+    if (!lru_hash) {
+      return false;
+    }
+    const CachedResult result = g_operation_cache.results.pop(*lru_hash);
+    g_operation_cache.memory_size -= result.buffer->get_memory_size();
+  }
+  return true;
+}
+
+void OperationCache::add(const uint64_t hash, std::unique_ptr<MemoryBuffer> buffer)
+{
+  g_operation_cache.memory_size += buffer->get_memory_size();
+  CachedResult result = {std::move(buffer), g_operation_cache.execution};
+  if (std::optional<CachedResult> replaced_result = g_operation_cache.results.pop_try(hash)) {
+    g_operation_cache.memory_size -= replaced_result->buffer->get_memory_size();
+  }
+  g_operation_cache.results.add_new(hash, std::move(result));
+}
+
+int OperationCache::get_image_version(Image *image)
+{
+  using namespace bke::image::partial_update;
+  ImageVersion &image_version = g_operation_cache.image_versions.lookup_or_add_cb(
+      image->id.session_uid, [&]() {
+        return ImageVersion{BKE_image_partial_update_create(image), 0, 0};
+      });
+  image_version.last_used_execution = g_operation_cache.execution;
+  /* The first collection of a user always detects changes. */
+  if (BKE_image_partial_update_collect_changes(image, image_version.partial_update_user) !=
+      ePartialUpdateCollectResult::NoChangesDetected)
+  {
+    image_version.version = ++g_operation_cache.last_image_version;
+  }
+  return image_version.version;
+}
+
+void OperationCache::clear()
+{
+  g_operation_cache.results.clear();
+  g_operation_cache.memory_size = 0;
+  for (ImageVersion &image_version : g_operation_cache.image_versions.values()) {
+    BKE_image_partial_update_free(image_version.partial_update_user);
+  }
+  g_operation_cache.image_versions.clear();
+}
+
+}  // namespace blender::compositor
@@ -0,0 +1,65 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#pragma once
+
+#include <memory>
+
+#include "BLI_sys_types.h"
+
+struct Image;
+
+namespace blender::compositor {
+
+class MemoryBuffer;
+
+/**
+ * \brief Keeps operations results between executions.
+ *
+ * Results are identified by a hash of the operation parameters and of its inputs hashes, so
+ * changing a node only evaluates the operations depending on it. Once the memory cache limit of
+ * the preferences is reached, the least recently used results are freed. Results used by the
+ * current execution are never freed before the next execution.
+ *
+ * The limit is a budget of its own, not shared with the sequencer and movie clip caches using the
+ * same preference, so all of them together may use up to twice the limit. The cache is cleared
+ * when loading a file, see #COM_clear_caches.
+ */
+struct OperationCache {
+  /**
+   * \brief Start a new execution, all results can be freed again.
+   * Results over the memory cache limit are freed, in case it was lowered.
+   */
+  static void execution_started();
+
+  /**
+   * \brief Get the result cached for given hash, null if there is none.
+   * The result is kept until the next execution.
+   */
+  static MemoryBuffer *lookup(uint64_t hash);
+
+  /**
+   * \brief Free results not used by the current execution until a result of given size fits.
+   * \return Whether a result of given size can be added.
+   */
+  static bool reserve(int64_t size);
+
+  /**
+   * \brief Add the result of an operation, #reserve must have been called before.
+   */
+  static void add(uint64_t hash, std::unique_ptr<MemoryBuffer> buffer);
+
+  /**
+   * \brief Get a number that changes every time the image pixels change, for operations reading
+   * images to include in their hash.
+   */
+  static int get_image_version(Image *image);
+
+  /**
+   * \brief Free all cached results.
+   */
+  static void clear();
+};
+
+}  // namespace blender::compositor
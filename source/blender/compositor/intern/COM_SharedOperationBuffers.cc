@@ -2,6 +2,8 @@
  *
  * SPDX-License-Identifier: GPL-2.0-or-later */
 
+#include <algorithm>
+
 #include "COM_SharedOperationBuffers.h"
 #include "COM_NodeOperation.h"
 
@@ -87,8 +89,17 @@ void SharedOperationBuffers::read_finished(NodeOperation *read_op)
   BLI_assert(buf_data.received_reads > 0 && buf_data.received_reads <= buf_data.registered_reads);
   if (buf_data.received_reads == buf_data.registered_reads) {
     /* Dispose buffer. */
+    if (buf_data.buffer && buf_data.buffer->owns_data()) {
+      add_memory_in_use(-buf_data.buffer->get_memory_size());
+    }
     buf_data.buffer = nullptr;
   }
 }
 
+void SharedOperationBuffers::add_memory_in_use(const int64_t size)
+{
+  memory_in_use_ += size;
+  peak_memory_ = std::max(peak_memory_, memory_in_use_);
+}
+
 }  // namespace blender::compositor
@@ -35,6 +35,10 @@ class SharedOperationBuffers {
   } BufferData;
   blender::Map<NodeOperation *, BufferData> buffers_;
 
+  /** Size of the buffers alive during execution in bytes. */
+  int64_t memory_in_use_ = 0;
+  int64_t peak_memory_ = 0;
+
  public:
   /**
    * Whether given operation area to render is already registered.
@@ -78,6 +82,20 @@ class SharedOperationBuffers {
    */
   void read_finished(NodeOperation *read_op);
 
+  /**
+   * Account for a buffer created to render an operation. Stored buffers owning their data are
+   * removed from the count when disposed, other buffers must be removed using a negative size
+   * once freed.
+   */
+  void add_memory_in_use(int64_t size);
+  /**
+   * Highest size of all buffers alive at the same time, in bytes.
+   */
+  int64_t get_peak_memory() const
+  {
+    return peak_memory_;
+  }
+
  private:
   BufferData &get_buffer_data(NodeOperation *op);
 
@@ -33,6 +33,12 @@ static float compute_rotation(float angle, int sides)
   return angle - offset;
 }
 
+void BokehImageOperation::hash_output_params()
+{
+  hash_params(data_->flaps, data_->angle, data_->rounding);
+  hash_params(data_->catadioptric, data_->lensshift, resolution_);
+}
+
 void BokehImageOperation::init_execution()
 {
   exterior_angle_ = compute_exterior_angle(data_->flaps);
@@ -29,6 +29,9 @@ class BokehImageOperation : public MultiThreadedOperation {
   float2 closest_point_on_line(float2 point, float2 line_start, float2 line_end);
   float bokeh(float2 point, float circumradius);
 
+ protected:
+  void hash_output_params() override;
+
  public:
   BokehImageOperation();
 
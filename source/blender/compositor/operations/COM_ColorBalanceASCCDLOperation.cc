@@ -25,6 +25,7 @@ ColorBalanceASCCDLOperation::ColorBalanceASCCDLOperation()
   this->add_output_socket(DataType::Color);
   this->set_canvas_input_index(1);
   flags_.can_be_constant = true;
+  flags_.is_per_pixel_operation = true;
 }
 
 void ColorBalanceASCCDLOperation::update_memory_buffer_row(PixelCursor &p)
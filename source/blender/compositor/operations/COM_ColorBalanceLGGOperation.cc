@@ -32,6 +32,7 @@ ColorBalanceLGGOperation::ColorBalanceLGGOperation()
   this->add_output_socket(DataType::Color);
   this->set_canvas_input_index(1);
   flags_.can_be_constant = true;
+  flags_.is_per_pixel_operation = true;
 }
 
 void ColorBalanceLGGOperation::update_memory_buffer_row(PixelCursor &p)
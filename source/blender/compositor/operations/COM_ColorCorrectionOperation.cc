@@ -17,6 +17,7 @@ ColorCorrectionOperation::ColorCorrectionOperation()
   green_channel_enabled_ = true;
   blue_channel_enabled_ = true;
   flags_.can_be_constant = true;
+  flags_.is_per_pixel_operation = true;
 }
 
 /* Calculate x^y if the function is defined. Otherwise return the given fallback value. */
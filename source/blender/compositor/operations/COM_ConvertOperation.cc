@@ -13,6 +13,7 @@ namespace blender::compositor {
 ConvertBaseOperation::ConvertBaseOperation()
 {
   flags_.can_be_constant = true;
+  flags_.is_per_pixel_operation = true;
 }
 
 void ConvertBaseOperation::hash_output_params() {}
@@ -362,6 +363,7 @@ SeparateChannelOperation::SeparateChannelOperation()
   this->add_input_socket(DataType::Color);
   this->add_output_socket(DataType::Value);
   flags_.can_be_constant = true;
+  flags_.is_per_pixel_operation = true;
 }
 
 void SeparateChannelOperation::update_memory_buffer_partial(MemoryBuffer *output,
@@ -385,6 +387,7 @@ CombineChannelsOperation::CombineChannelsOperation()
   this->set_canvas_input_index(0);
 
   flags_.can_be_constant = true;
+  flags_.is_per_pixel_operation = true;
 }
 
 void CombineChannelsOperation::update_memory_buffer_partial(MemoryBuffer *output,
@@ -14,6 +14,7 @@ DisplaceOperation::DisplaceOperation()
   this->add_input_socket(DataType::Value);
   this->add_output_socket(DataType::Color);
   flags_.can_be_constant = true;
+  uses_pass_hooks_ = true;
 }
 
 void DisplaceOperation::init_execution()
@@ -12,6 +12,7 @@ FastGaussianBlurOperation::FastGaussianBlurOperation() : BlurBaseOperation(DataT
 {
   iirgaus_ = nullptr;
   data_.filtertype = R_FILTER_FAST_GAUSS;
+  uses_pass_hooks_ = true;
 }
 
 void FastGaussianBlurOperation::init_data()
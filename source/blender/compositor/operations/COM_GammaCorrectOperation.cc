@@ -13,6 +13,8 @@ GammaCorrectOperation::GammaCorrectOperation()
   flags_.can_be_constant = true;
 }
 
+void GammaCorrectOperation::hash_output_params() {}
+
 void GammaCorrectOperation::update_memory_buffer_partial(MemoryBuffer *output,
                                                          const rcti &area,
                                                          Span<MemoryBuffer *> inputs)
@@ -48,6 +50,8 @@ GammaUncorrectOperation::GammaUncorrectOperation()
   flags_.can_be_constant = true;
 }
 
+void GammaUncorrectOperation::hash_output_params() {}
+
 void GammaUncorrectOperation::update_memory_buffer_partial(MemoryBuffer *output,
                                                            const rcti &area,
                                                            Span<MemoryBuffer *> inputs)
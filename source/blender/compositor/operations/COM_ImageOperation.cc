@@ -3,6 +3,7 @@
  * SPDX-License-Identifier: GPL-2.0-or-later */
 
 #include "COM_ImageOperation.h"
+#include "COM_OperationCache.h"
 
 #include "BKE_scene.hh"
 
@@ -22,6 +23,7 @@ BaseImageOperation::BaseImageOperation()
   number_of_channels_ = 0;
   rd_ = nullptr;
   view_name_ = nullptr;
+  flags_.is_per_pixel_operation = true;
 }
 ImageOperation::ImageOperation() : BaseImageOperation()
 {
@@ -76,6 +78,26 @@ void BaseImageOperation::determine_canvas(const rcti & /*preferred_area*/, rcti
   BKE_image_release_ibuf(image_, stackbuf, nullptr);
 }
 
+void BaseImageOperation::hash_output_params()
+{
+  /* Images generated by Blender like the render result or the viewer image are changed without
+   * tagging updates, so the operation result can't be identified by the image. */
+  if (image_ == nullptr || !ELEM(image_->type, IMA_TYPE_IMAGE, IMA_TYPE_MULTILAYER)) {
+    MultiThreadedOperation::hash_output_params();
+    return;
+  }
+
+  hash_params(image_->id.session_uid, OperationCache::get_image_version(image_));
+  /* Changing how the image is read frees its buffers without tagging a partial update. */
+  hash_params(
+      StringRef(image_->colorspace_settings.name), int(image_->alpha_mode), image_->source);
+  hash_param(image_->flag & (IMA_HIGH_BITDEPTH | IMA_DEINTERLACE | IMA_USE_VIEWS |
+                              IMA_VIEW_AS_RENDER));
+  hash_params(image_user_.framenr, image_user_.layer, image_user_.pass);
+  hash_params(image_user_.view, image_user_.multi_index, image_user_.tile);
+  hash_params(framenumber_, StringRef(view_name_ ? view_name_ : ""));
+}
+
 void ImageOperation::update_memory_buffer_partial(MemoryBuffer *output,
                                                   const rcti &area,
                                                   Span<MemoryBuffer *> /*inputs*/)
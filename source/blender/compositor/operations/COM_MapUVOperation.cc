@@ -15,6 +15,7 @@ MapUVOperation::MapUVOperation()
   nearest_neighbour_ = false;
   flags_.can_be_constant = true;
   set_canvas_input_index(UV_INPUT_INDEX);
+  uses_pass_hooks_ = true;
 }
 
 void MapUVOperation::init_data()
@@ -19,6 +19,8 @@ class MathBaseOperation : public MultiThreadedOperation {
  protected:
   MathBaseOperation();
 
+  void hash_output_params() override;
+
   float clamp_when_enabled(float value)
   {
     if (use_clamp_) {
@@ -19,6 +19,7 @@ MixBaseOperation::MixBaseOperation()
   this->set_use_value_alpha_multiply(false);
   this->set_use_clamp(false);
   flags_.can_be_constant = true;
+  flags_.is_per_pixel_operation = true;
 }
 
 void MixBaseOperation::determine_canvas(const rcti &preferred_area, rcti &r_area)
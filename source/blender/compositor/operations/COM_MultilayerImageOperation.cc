@@ -10,6 +10,12 @@
 
 namespace blender::compositor {
 
+void MultilayerBaseOperation::hash_output_params()
+{
+  BaseImageOperation::hash_output_params();
+  hash_param(pass_name_);
+}
+
 ImBuf *MultilayerBaseOperation::get_im_buf()
 {
   if (rd_ == nullptr || image_ == nullptr) {
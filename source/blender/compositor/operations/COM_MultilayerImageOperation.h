@@ -18,6 +18,7 @@ class MultilayerBaseOperation : public BaseImageOperation {
   std::string pass_name_;
 
   ImBuf *get_im_buf() override;
+  void hash_output_params() override;
 
  public:
   MultilayerBaseOperation() = default;
@@ -12,6 +12,7 @@ NormalizeOperation::NormalizeOperation()
   this->add_output_socket(DataType::Value);
   cached_instance_ = nullptr;
   flags_.can_be_constant = true;
+  uses_pass_hooks_ = true;
 }
 
 void NormalizeOperation::deinit_execution()
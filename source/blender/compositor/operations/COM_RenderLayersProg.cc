@@ -23,6 +23,7 @@ RenderLayersProg::RenderLayersProg(const char *pass_name, DataType type, int ele
   layer_buffer_ = nullptr;
 
   this->add_output_socket(type);
+  flags_.is_per_pixel_operation = true;
 }
 
 void RenderLayersProg::init_execution()
@@ -90,6 +91,25 @@ void RenderLayersProg::determine_canvas(const rcti & /*preferred_area*/, rcti &r
   }
 }
 
+void RenderLayersProg::hash_output_params()
+{
+  Scene *scene = this->get_scene();
+  Render *re = (scene) ? RE_GetSceneRender(scene) : nullptr;
+  if (re == nullptr) {
+    MultiThreadedOperation::hash_output_params();
+    return;
+  }
+
+  hash_params(scene->id.session_uid, get_layer_id(), pass_name_);
+  hash_params(StringRef(view_name_ ? view_name_ : ""), elementsize_);
+
+  /* Memory of a render result may be reused by the next render, so also identify the render by
+   * its start time. */
+  RenderResult *rr = RE_AcquireResultRead(re);
+  hash_params(uintptr_t(rr), RE_GetStats(re)->starttime);
+  RE_ReleaseResult(re);
+}
+
 std::unique_ptr<MetaData> RenderLayersProg::get_meta_data()
 {
   Scene *scene = this->get_scene();
@@ -17,6 +17,7 @@ TonemapOperation::TonemapOperation()
   data_ = nullptr;
   cached_instance_ = nullptr;
   flags_.can_be_constant = true;
+  uses_pass_hooks_ = true;
 }
 
 void TonemapOperation::get_area_of_interest(const int input_idx,
@@ -21,6 +21,7 @@ TranslateOperation::TranslateOperation(DataType data_type, ResizeMode resize_mod
   this->sampler_ = PixelSampler::Nearest;
 
   this->flags_.can_be_constant = true;
+  this->uses_pass_hooks_ = true;
 }
 
 void TranslateOperation::set_wrapping(int wrapping_type)
@@ -35,6 +35,11 @@ struct VariableSizeBokehBlurTileData {
   int max_blur_scalar;
 };
 
+void VariableSizeBokehBlurOperation::hash_output_params()
+{
+  hash_params(max_blur_, threshold_, do_size_scale_);
+}
+
 void VariableSizeBokehBlurOperation::get_area_of_interest(const int input_idx,
                                                           const rcti &output_area,
                                                           rcti &r_input_area)
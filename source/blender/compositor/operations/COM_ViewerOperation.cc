@@ -30,6 +30,7 @@ ViewerOperation::ViewerOperation()
   view_name_ = nullptr;
   flags_.use_viewer_border = true;
   flags_.is_viewer_operation = true;
+  uses_pass_hooks_ = true;
 }
 
 void ViewerOperation::init_execution()
@@ -0,0 +1,381 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include "DNA_userdef_types.h"
+
+#include "BKE_idtype.hh"
+#include "BKE_lib_id.hh"
+#include "BKE_node_runtime.hh"
+
+#include "COM_CompositorContext.h"
+#include "COM_FullFrameExecutionModel.h"
+#include "COM_MemoryBuffer.h"
+#include "COM_NodeOperation.h"
+#include "COM_OperationCache.h"
+#include "COM_SharedOperationBuffers.h"
+
+namespace blender::compositor::tests {
+
+/** Counts how often operations initialize their execution and are rendered. */
+class CountingOperation : public NodeOperation {
+ public:
+  int init_execution_count = 0;
+  int render_count = 0;
+
+  CountingOperation(const int width, const int height, const bool is_per_pixel)
+  {
+    add_output_socket(DataType::Value);
+    set_canvas({0, width, 0, height});
+    flags_.is_per_pixel_operation = is_per_pixel;
+  }
+
+  void init_execution() override
+  {
+    init_execution_count++;
+  }
+};
+
+static float gradient_value(const int x, const int y, const float offset)
+{
+  return float(x % 97) * 0.25f + float(y % 89) + offset;
+}
+
+/** Writes a value that depends on the pixel coordinates. */
+class GradientOperation : public CountingOperation {
+ public:
+  float offset;
+
+  GradientOperation(const int width,
+                    const int height,
+                    const bool is_per_pixel,
+                    const float offset = 0.0f)
+      : CountingOperation(width, height, is_per_pixel), offset(offset)
+  {
+  }
+
+  void update_memory_buffer(MemoryBuffer *output,
+                            const rcti &area,
+                            Span<MemoryBuffer *> /*inputs*/) override
+  {
+    render_count++;
+    for (BuffersIterator<float> it = output->iterate_with({}, area); !it.is_end(); ++it) {
+      *it.out = gradient_value(it.x, it.y, offset);
+    }
+  }
+
+ protected:
+  void hash_output_params() override
+  {
+    hash_param(offset);
+  }
+};
+
+/** Combines its two inputs at the same pixel. */
+class MultiplyAddOperation : public CountingOperation {
+ public:
+  float factor = 0.5f;
+
+  MultiplyAddOperation(NodeOperation &input_a,
+                       NodeOperation &input_b,
+                       const int width,
+                       const int height,
+                       const bool is_per_pixel)
+      : CountingOperation(width, height, is_per_pixel)
+  {
+    add_input_socket(DataType::Value);
+    add_input_socket(DataType::Value);
+    get_input_socket(0)->set_link(input_a.get_output_socket());
+    get_input_socket(1)->set_link(input_b.get_output_socket());
+  }
+
+  void update_memory_buffer(MemoryBuffer *output,
+                            const rcti &area,
+                            Span<MemoryBuffer *> inputs) override
+  {
+    render_count++;
+    for (BuffersIterator<float> it = output->iterate_with(inputs, area); !it.is_end(); ++it) {
+      *it.out = *it.in(0) * factor + *it.in(1);
+    }
+  }
+
+ protected:
+  void hash_output_params() override
+  {
+    hash_param(factor);
+  }
+};
+
+/**
+ * Output operation copying its input, so the rendered result can be compared. Only the input
+ * area is read, like a viewer with a border would.
+ */
+class ResultOperation : public NodeOperation {
+ public:
+  std::unique_ptr<MemoryBuffer> result;
+  rcti input_area;
+
+  ResultOperation(NodeOperation &input)
+  {
+    add_input_socket(DataType::Value);
+    get_input_socket(0)->set_link(input.get_output_socket());
+    set_canvas(input.get_canvas());
+    input_area = input.get_canvas();
+  }
+
+  bool is_output_operation(bool /*rendering*/) const override
+  {
+    return true;
+  }
+
+  void get_area_of_interest(const int /*input_idx*/,
+                            const rcti & /*output_area*/,
+                            rcti &r_input_area) override
+  {
+    r_input_area = input_area;
+  }
+
+  void update_memory_buffer(MemoryBuffer * /*output*/,
+                            const rcti & /*area*/,
+                            Span<MemoryBuffer *> inputs) override
+  {
+    result = std::make_unique<MemoryBuffer>(DataType::Value, input_area);
+    result->copy_from(inputs[0], input_area);
+  }
+};
+
+static void stats_draw_noop(void * /*data*/, const char * /*str*/) {}
+static void progress_noop(void * /*data*/, float /*progress*/) {}
+
+/** Renders the operations like the compositor does, without building them from a node tree. */
+class ExecutionModelTest : public testing::Test {
+ protected:
+  bNodeTree *node_tree_ = nullptr;
+  RenderData render_data_ = {};
+  CompositorContext context_;
+  /* Peak memory of the operation buffers of the last execution. */
+  int64_t peak_memory_ = 0;
+
+  static void SetUpTestSuite()
+  {
+    BKE_idtype_init();
+  }
+
+  void SetUp() override
+  {
+    node_tree_ = static_cast<bNodeTree *>(BKE_id_new_nomain(ID_NT, "Test"));
+    node_tree_->runtime->stats_draw = stats_draw_noop;
+    node_tree_->runtime->progress = progress_noop;
+    context_.set_bnodetree(node_tree_);
+    context_.set_render_data(&render_data_);
+    /* Results aren't cached when rendering. */
+    context_.set_rendering(true);
+  }
+
+  void TearDown() override
+  {
+    BKE_id_free(nullptr, node_tree_);
+  }
+
+  void render(Span<NodeOperation *> operations)
+  {
+    SharedOperationBuffers buffers;
+    FullFrameExecutionModel execution_model(context_, buffers, operations);
+    for (NodeOperation *operation : operations) {
+      operation->init_data();
+    }
+    execution_model.render();
+    peak_memory_ = buffers.get_peak_memory();
+  }
+
+  /**
+   * Render `(gradient * 0.5 + gradient) * 0.5 + gradient`, where all operations but the output
+   * are per pixel operations when \a is_per_pixel is set.
+   */
+  std::unique_ptr<MemoryBuffer> render_tree(const int width,
+                                            const int height,
+                                            const bool is_per_pixel,
+                                            Vector<int> &r_init_execution_counts)
+  {
+    GradientOperation gradient_a(width, height, is_per_pixel);
+    GradientOperation gradient_b(width, height, is_per_pixel);
+    GradientOperation gradient_c(width, height, is_per_pixel);
+    MultiplyAddOperation mix_a(gradient_a, gradient_b, width, height, is_per_pixel);
+    MultiplyAddOperation mix_b(mix_a, gradient_c, width, height, is_per_pixel);
+    ResultOperation result(mix_b);
+    render({&gradient_a, &gradient_b, &mix_a, &gradient_c, &mix_b, &result});
+
+    r_init_execution_counts.clear();
+    for (const CountingOperation *operation :
+         {static_cast<CountingOperation *>(&gradient_a),
+          static_cast<CountingOperation *>(&gradient_b),
+          static_cast<CountingOperation *>(&gradient_c),
+          static_cast<CountingOperation *>(&mix_a),
+          static_cast<CountingOperation *>(&mix_b)})
+    {
+      r_init_execution_counts.append(operation->init_execution_count);
+    }
+    return std::move(result.result);
+  }
+};
+
+TEST_F(ExecutionModelTest, StripesMatchFullFrame)
+{
+  /* Tall enough to be rendered in several stripes, the last one smaller than the others. */
+  const int width = 1024;
+  const int height = 2100;
+
+  Vector<int> stripes_init_counts;
+  std::unique_ptr<MemoryBuffer> stripes_result = render_tree(
+      width, height, true, stripes_init_counts);
+  Vector<int> full_frame_init_counts;
+  std::unique_ptr<MemoryBuffer> full_frame_result = render_tree(
+      width, height, false, full_frame_init_counts);
+
+  ASSERT_NE(stripes_result, nullptr);
+  ASSERT_NE(full_frame_result, nullptr);
+  ASSERT_EQ(stripes_result->get_width(), width);
+  ASSERT_EQ(stripes_result->get_height(), height);
+  ASSERT_EQ(full_frame_result->get_width(), width);
+  ASSERT_EQ(full_frame_result->get_height(), height);
+  int64_t mismatches_num = 0;
+  for (const int y : IndexRange(height)) {
+    for (const int x : IndexRange(width)) {
+      if (stripes_result->get_value(x, y, 0) != full_frame_result->get_value(x, y, 0)) {
+        mismatches_num++;
+      }
+    }
+  }
+  EXPECT_EQ(mismatches_num, 0);
+
+  /* Every operation is initialized once, not once per stripe. */
+  EXPECT_EQ(stripes_init_counts, Vector<int>({1, 1, 1, 1, 1}));
+  EXPECT_EQ(full_frame_init_counts, Vector<int>({1, 1, 1, 1, 1}));
+}
+
+/** Renders like the viewer, keeping operation results between executions. */
+class OperationCacheTest : public ExecutionModelTest {
+ protected:
+  int memcachelimit_;
+
+  void SetUp() override
+  {
+    ExecutionModelTest::SetUp();
+    context_.set_rendering(false);
+    memcachelimit_ = U.memcachelimit;
+    U.memcachelimit = 64;
+    OperationCache::clear();
+  }
+
+  void TearDown() override
+  {
+    OperationCache::clear();
+    U.memcachelimit = memcachelimit_;
+    ExecutionModelTest::TearDown();
+  }
+
+  /**
+   * Render `(gradient_a * 0.5 + gradient_b) * factor + gradient_c` with newly built operations,
+   * like every execution of the compositor does. Only \a read_area of the result is rendered.
+   */
+  std::unique_ptr<MemoryBuffer> render_cached_tree(const float factor,
+                                                   const rcti &read_area,
+                                                   Vector<int> &r_render_counts)
+  {
+    GradientOperation gradient_a(width, height, false, 1.0f);
+    GradientOperation gradient_b(width, height, false, 2.0f);
+    GradientOperation gradient_c(width, height, false, 3.0f);
+    MultiplyAddOperation mix_a(gradient_a, gradient_b, width, height, false);
+    MultiplyAddOperation mix_b(mix_a, gradient_c, width, height, false);
+    mix_b.factor = factor;
+    ResultOperation result(mix_b);
+    result.input_area = read_area;
+    render({&gradient_a, &gradient_b, &mix_a, &gradient_c, &mix_b, &result});
+
+    r_render_counts = {gradient_a.render_count,
+                       gradient_b.render_count,
+                       gradient_c.render_count,
+                       mix_a.render_count,
+                       mix_b.render_count};
+    return std::move(result.result);
+  }
+
+  /** Number of pixels of \a result not matching the tree rendered with \a factor. */
+  static int64_t count_mismatches(const MemoryBuffer &result, const float factor)
+  {
+    int64_t mismatches_num = 0;
+    const rcti &rect = result.get_rect();
+    for (int y = rect.ymin; y < rect.ymax; y++) {
+      for (int x = rect.xmin; x < rect.xmax; x++) {
+        const float mix_a = gradient_value(x, y, 1.0f) * 0.5f + gradient_value(x, y, 2.0f);
+        const float expected = mix_a * factor + gradient_value(x, y, 3.0f);
+        if (std::abs(result.get_value(x, y, 0) - expected) > 1e-5f) {
+          mismatches_num++;
+        }
+      }
+    }
+    return mismatches_num;
+  }
+
+  static constexpr int width = 64;
+  static constexpr int height = 48;
+  static constexpr rcti canvas = {0, width, 0, height};
+};
+
+TEST_F(OperationCacheTest, ResultReused)
+{
+  Vector<int> render_counts;
+  std::unique_ptr<MemoryBuffer> result = render_cached_tree(0.5f, canvas, render_counts);
+  ASSERT_NE(result, nullptr);
+  EXPECT_EQ(count_mismatches(*result, 0.5f), 0);
+  EXPECT_EQ(render_counts, Vector<int>({1, 1, 1, 1, 1}));
+  EXPECT_GT(peak_memory_, 0);
+
+  /* The cached result of the last operation is read, nothing before it is rendered again. */
+  result = render_cached_tree(0.5f, canvas, render_counts);
+  ASSERT_NE(result, nullptr);
+  EXPECT_EQ(count_mismatches(*result, 0.5f), 0);
+  EXPECT_EQ(render_counts, Vector<int>({0, 0, 0, 0, 0}));
+  /* The read result belongs to the cache, no operation buffer was allocated. */
+  EXPECT_EQ(peak_memory_, 0);
+}
+
+TEST_F(OperationCacheTest, ParameterChangeInvalidatesResult)
+{
+  Vector<int> render_counts;
+  render_cached_tree(0.5f, canvas, render_counts);
+
+  /* Only the changed operation is rendered again, reading the cached result of its input. */
+  std::unique_ptr<MemoryBuffer> result = render_cached_tree(0.25f, canvas, render_counts);
+  ASSERT_NE(result, nullptr);
+  EXPECT_EQ(count_mismatches(*result, 0.25f), 0);
+  EXPECT_EQ(render_counts, Vector<int>({0, 0, 0, 0, 1}));
+
+  /* Results of both parameters are kept. */
+  result = render_cached_tree(0.5f, canvas, render_counts);
+  ASSERT_NE(result, nullptr);
+  EXPECT_EQ(count_mismatches(*result, 0.5f), 0);
+  EXPECT_EQ(render_counts, Vector<int>({0, 0, 0, 0, 0}));
+}
+
+TEST_F(OperationCacheTest, PartialResultNotCached)
+{
+  /* Only part of the operations is rendered, which other executions can't use. */
+  const rcti border = {10, 40, 5, 30};
+  Vector<int> render_counts;
+  std::unique_ptr<MemoryBuffer> result = render_cached_tree(0.5f, border, render_counts);
+  ASSERT_NE(result, nullptr);
+  EXPECT_EQ(count_mismatches(*result, 0.5f), 0);
+  EXPECT_EQ(render_counts, Vector<int>({1, 1, 1, 1, 1}));
+
+  result = render_cached_tree(0.5f, canvas, render_counts);
+  ASSERT_NE(result, nullptr);
+  EXPECT_EQ(result->get_width(), width);
+  EXPECT_EQ(result->get_height(), height);
+  EXPECT_EQ(count_mismatches(*result, 0.5f), 0);
+  EXPECT_EQ(render_counts, Vector<int>({1, 1, 1, 1, 1}));
+}
+
+}  // namespace blender::compositor::tests
@@ -0,0 +1,265 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include "BLI_map.hh"
+
+#include "COM_FusedOperation.h"
+#include "COM_MemoryBuffer.h"
+
+namespace blender::compositor::tests {
+
+/** Operation whose result is given instead of rendered, read by the fused operations. */
+class InputOperation : public NodeOperation {
+ public:
+  InputOperation(const rcti &canvas)
+  {
+    add_output_socket(DataType::Value);
+    set_canvas(canvas);
+  }
+};
+
+/** Per pixel operation that can evaluate an area without an execution system. */
+class TestOperation : public MultiThreadedOperation {
+ public:
+  TestOperation(const rcti &canvas)
+  {
+    set_canvas(canvas);
+    flags_.is_per_pixel_operation = true;
+  }
+
+  void evaluate(MemoryBuffer *output, const rcti &area, Span<MemoryBuffer *> inputs)
+  {
+    update_memory_buffer_partial(output, area, inputs);
+  }
+};
+
+/** Combines its two inputs at the same pixel. */
+class MultiplyAddOperation : public TestOperation {
+ public:
+  MultiplyAddOperation(NodeOperation &input_a, NodeOperation &input_b, const rcti &canvas)
+      : TestOperation(canvas)
+  {
+    add_input_socket(DataType::Value);
+    add_input_socket(DataType::Value);
+    add_output_socket(DataType::Value);
+    get_input_socket(0)->set_link(input_a.get_output_socket());
+    get_input_socket(1)->set_link(input_b.get_output_socket());
+  }
+
+ protected:
+  void update_memory_buffer_partial(MemoryBuffer *output,
+                                    const rcti &area,
+                                    Span<MemoryBuffer *> inputs) override
+  {
+    for (BuffersIterator<float> it = output->iterate_with(inputs, area); !it.is_end(); ++it) {
+      *it.out = *it.in(0) * 0.5f + *it.in(1);
+    }
+  }
+};
+
+/** Converts its input to a color, so the fused output has more channels than its inputs. */
+class ValueToColorOperation : public TestOperation {
+ public:
+  ValueToColorOperation(NodeOperation &input, const rcti &canvas) : TestOperation(canvas)
+  {
+    add_input_socket(DataType::Value);
+    add_output_socket(DataType::Color);
+    get_input_socket(0)->set_link(input.get_output_socket());
+  }
+
+ protected:
+  void update_memory_buffer_partial(MemoryBuffer *output,
+                                    const rcti &area,
+                                    Span<MemoryBuffer *> inputs) override
+  {
+    for (BuffersIterator<float> it = output->iterate_with(inputs, area); !it.is_end(); ++it) {
+      const float value = *it.in(0);
+      it.out[0] = value;
+      it.out[1] = value * 2.0f;
+      it.out[2] = value - 1.0f;
+      it.out[3] = 1.0f;
+    }
+  }
+};
+
+/** Has a pass hook, like operations computing a value from the whole input before evaluating. */
+class PassHookOperation : public ValueToColorOperation {
+ public:
+  PassHookOperation(NodeOperation &input, const rcti &canvas)
+      : ValueToColorOperation(input, canvas)
+  {
+    uses_pass_hooks_ = true;
+  }
+
+ protected:
+  void update_memory_buffer_started(MemoryBuffer * /*output*/,
+                                    const rcti & /*area*/,
+                                    Span<MemoryBuffer *> /*inputs*/) override
+  {
+  }
+};
+
+/** Evaluated in two passes over the whole output. */
+class TwoPassOperation : public ValueToColorOperation {
+ public:
+  TwoPassOperation(NodeOperation &input, const rcti &canvas) : ValueToColorOperation(input, canvas)
+  {
+    num_passes_ = 2;
+  }
+};
+
+/** Evaluates the partial update directly, it is multi-threaded by the execution system. */
+class TestFusedOperation : public FusedOperation {
+ public:
+  using FusedOperation::FusedOperation;
+  using FusedOperation::update_memory_buffer_partial;
+};
+
+static std::unique_ptr<MemoryBuffer> create_input(const rcti &canvas, const int seed)
+{
+  std::unique_ptr<MemoryBuffer> buffer = std::make_unique<MemoryBuffer>(DataType::Value, canvas);
+  for (BuffersIterator<float> it = buffer->iterate_with({}); !it.is_end(); ++it) {
+    *it.out = float((it.x * 7 + seed) % 97) * 0.25f + float((it.y + seed) % 89);
+  }
+  return buffer;
+}
+
+/**
+ * Evaluate \a operations one after the other on full buffers, like the compositor does when they
+ * aren't fused.
+ */
+static std::unique_ptr<MemoryBuffer> evaluate_unfused(
+    Span<TestOperation *> operations,
+    const Map<NodeOperation *, MemoryBuffer *> &input_buffers,
+    const rcti &area)
+{
+  Map<NodeOperation *, std::unique_ptr<MemoryBuffer>> results;
+  for (TestOperation *operation : operations) {
+    Vector<MemoryBuffer *> inputs;
+    for (int i = 0; i < operation->get_number_of_input_sockets(); i++) {
+      NodeOperation *input_op = operation->get_input_operation(i);
+      inputs.append(input_buffers.lookup_default(input_op, nullptr));
+      if (inputs.last() == nullptr) {
+        inputs.last() = results.lookup(input_op).get();
+      }
+    }
+    std::unique_ptr<MemoryBuffer> result = std::make_unique<MemoryBuffer>(
+        operation->get_output_socket()->get_data_type(), area);
+    operation->evaluate(result.get(), area, inputs);
+    results.add_new(operation, std::move(result));
+  }
+  return results.pop(operations.last());
+}
+
+/** Fuse \a operations and check that the fused result matches the unfused one in \a area. */
+static void expect_fused_matches_unfused(Span<TestOperation *> operations,
+                                         const Map<NodeOperation *, MemoryBuffer *> &input_buffers,
+                                         const rcti &area)
+{
+  std::unique_ptr<MemoryBuffer> expected = evaluate_unfused(operations, input_buffers, area);
+
+  TestFusedOperation fused(Vector<NodeOperation *>(operations.begin(), operations.end()));
+  Vector<MemoryBuffer *> inputs;
+  for (NodeOperationOutput *link : fused.get_external_links()) {
+    inputs.append(input_buffers.lookup(&link->get_operation()));
+  }
+  fused.init_execution();
+  MemoryBuffer result(fused.get_output_socket()->get_data_type(), area);
+  fused.update_memory_buffer_partial(&result, area, inputs);
+  fused.deinit_execution();
+
+  ASSERT_EQ(result.get_num_channels(), expected->get_num_channels());
+  int64_t mismatches_num = 0;
+  for (int y = area.ymin; y < area.ymax; y++) {
+    for (int x = area.xmin; x < area.xmax; x++) {
+      for (const int channel : IndexRange(result.get_num_channels())) {
+        if (result.get_value(x, y, channel) != expected->get_value(x, y, channel)) {
+          mismatches_num++;
+        }
+      }
+    }
+  }
+  EXPECT_EQ(mismatches_num, 0);
+
+  /* The evaluation time is split between all fused operations without losing any of it. */
+  Vector<NodeOperation *> timed_operations;
+  timeit::Nanoseconds split_time = timeit::Nanoseconds::zero();
+  fused.foreach_fused_evaluation_time(
+      timeit::Nanoseconds(1000003),
+      [&](NodeOperation &operation, const timeit::Nanoseconds time) {
+        EXPECT_GE(time.count(), 0);
+        timed_operations.append(&operation);
+        split_time += time;
+      });
+  EXPECT_EQ(split_time.count(), 1000003);
+  EXPECT_EQ(timed_operations.size(), operations.size());
+}
+
+/* Large enough to be evaluated in several blocks, the last one smaller than the others. */
+static const rcti canvas = {0, 150, 0, 100};
+/* Area not starting at the origin, with rows shorter than the canvas. */
+static const rcti sub_area = {7, 143, 3, 95};
+
+TEST(FusedOperation, CanFuse)
+{
+  InputOperation input(canvas);
+  ValueToColorOperation per_pixel(input, canvas);
+  PassHookOperation pass_hook(input, canvas);
+  TwoPassOperation two_pass(input, canvas);
+  EXPECT_TRUE(FusedOperation::can_fuse(per_pixel));
+  /* Pass hooks and passes need the full input and output buffers. */
+  EXPECT_FALSE(FusedOperation::can_fuse(pass_hook));
+  EXPECT_FALSE(FusedOperation::can_fuse(two_pass));
+  /* Operations that don't read input pixels at the same coordinates. */
+  EXPECT_FALSE(FusedOperation::can_fuse(input));
+}
+
+TEST(FusedOperation, ChainMatchesUnfused)
+{
+  for (const rcti &area : {canvas, sub_area}) {
+    InputOperation input_a(canvas);
+    InputOperation input_b(canvas);
+    InputOperation input_c(canvas);
+    std::unique_ptr<MemoryBuffer> buffer_a = create_input(canvas, 1);
+    std::unique_ptr<MemoryBuffer> buffer_b = create_input(canvas, 2);
+    std::unique_ptr<MemoryBuffer> buffer_c = create_input(canvas, 3);
+    Map<NodeOperation *, MemoryBuffer *> input_buffers;
+    input_buffers.add_new(&input_a, buffer_a.get());
+    input_buffers.add_new(&input_b, buffer_b.get());
+    input_buffers.add_new(&input_c, buffer_c.get());
+
+    /* `to_color((a * 0.5 + b) * 0.5 + c)`, the fused operation owns the operations. */
+    TestOperation *mix_a = new MultiplyAddOperation(input_a, input_b, canvas);
+    TestOperation *mix_b = new MultiplyAddOperation(*mix_a, input_c, canvas);
+    TestOperation *to_color = new ValueToColorOperation(*mix_b, canvas);
+    expect_fused_matches_unfused({mix_a, mix_b, to_color}, input_buffers, area);
+  }
+}
+
+TEST(FusedOperation, TreeMatchesUnfused)
+{
+  for (const rcti &area : {canvas, sub_area}) {
+    InputOperation input_a(canvas);
+    InputOperation input_b(canvas);
+    InputOperation input_c(canvas);
+    std::unique_ptr<MemoryBuffer> buffer_a = create_input(canvas, 4);
+    std::unique_ptr<MemoryBuffer> buffer_b = create_input(canvas, 5);
+    std::unique_ptr<MemoryBuffer> buffer_c = create_input(canvas, 6);
+    Map<NodeOperation *, MemoryBuffer *> input_buffers;
+    input_buffers.add_new(&input_a, buffer_a.get());
+    input_buffers.add_new(&input_b, buffer_b.get());
+    input_buffers.add_new(&input_c, buffer_c.get());
+
+    /* `to_color((a * 0.5 + b) * 0.5 + (c * 0.5 + a))`, input `a` is read by two operations. */
+    TestOperation *mix_ab = new MultiplyAddOperation(input_a, input_b, canvas);
+    TestOperation *mix_ca = new MultiplyAddOperation(input_c, input_a, canvas);
+    TestOperation *mix = new MultiplyAddOperation(*mix_ab, *mix_ca, canvas);
+    TestOperation *to_color = new ValueToColorOperation(*mix, canvas);
+    expect_fused_matches_unfused({mix_ab, mix_ca, mix, to_color}, input_buffers, area);
+  }
+}
+
+}  // namespace blender::compositor::tests
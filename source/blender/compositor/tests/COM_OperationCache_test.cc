@@ -0,0 +1,83 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include "DNA_image_types.h"
+#include "DNA_userdef_types.h"
+
+#include "BKE_image.h"
+#include "BKE_image_partial_update.hh"
+
+#include "COM_MemoryBuffer.h"
+#include "COM_OperationCache.h"
+
+namespace blender::compositor::tests {
+
+/* Half of a mega byte, so two results fit in the smallest memory cache limit. */
+static std::unique_ptr<MemoryBuffer> create_result()
+{
+  return std::make_unique<MemoryBuffer>(DataType::Color, 256, 128);
+}
+
+TEST(OperationCache, LeastRecentlyUsed)
+{
+  const int memcachelimit = U.memcachelimit;
+  U.memcachelimit = 1;
+  const int64_t result_size = create_result()->get_memory_size();
+
+  OperationCache::execution_started();
+  EXPECT_EQ(OperationCache::lookup(1), nullptr);
+  EXPECT_TRUE(OperationCache::reserve(result_size));
+  OperationCache::add(1, create_result());
+  EXPECT_TRUE(OperationCache::reserve(result_size));
+  OperationCache::add(2, create_result());
+  /* Results used by the current execution are kept. */
+  EXPECT_FALSE(OperationCache::reserve(result_size));
+
+  OperationCache::execution_started();
+  EXPECT_NE(OperationCache::lookup(2), nullptr);
+  EXPECT_TRUE(OperationCache::reserve(result_size));
+  OperationCache::add(3, create_result());
+  EXPECT_EQ(OperationCache::lookup(1), nullptr);
+  EXPECT_NE(OperationCache::lookup(2), nullptr);
+  EXPECT_NE(OperationCache::lookup(3), nullptr);
+
+  /* Results larger than the limit are never cached. */
+  OperationCache::execution_started();
+  EXPECT_FALSE(OperationCache::reserve(result_size * 3));
+
+  OperationCache::clear();
+  EXPECT_EQ(OperationCache::lookup(2), nullptr);
+  U.memcachelimit = memcachelimit;
+}
+
+TEST(OperationCache, ImageVersion)
+{
+  Image image = {};
+  image.id.session_uid = 1;
+
+  OperationCache::execution_started();
+  const int first_version = OperationCache::get_image_version(&image);
+  EXPECT_EQ(OperationCache::get_image_version(&image), first_version);
+  BKE_image_partial_update_mark_full_update(&image);
+  const int changed_version = OperationCache::get_image_version(&image);
+  EXPECT_NE(changed_version, first_version);
+
+  OperationCache::execution_started();
+  EXPECT_EQ(OperationCache::get_image_version(&image), changed_version);
+
+  /* Images not read by the last execution aren't tracked anymore, their pixels may have changed
+   * in between. */
+  OperationCache::execution_started();
+  OperationCache::execution_started();
+  const int new_version = OperationCache::get_image_version(&image);
+  EXPECT_NE(new_version, first_version);
+  EXPECT_NE(new_version, changed_version);
+
+  OperationCache::clear();
+  BKE_image_partial_update_register_free(&image);
+}
+
+}  // namespace blender::compositor::tests
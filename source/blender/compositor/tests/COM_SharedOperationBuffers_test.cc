@@ -0,0 +1,62 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include "COM_MemoryBuffer.h"
+#include "COM_NodeOperation.h"
+#include "COM_SharedOperationBuffers.h"
+
+namespace blender::compositor::tests {
+
+class ColorOperation : public NodeOperation {
+ public:
+  ColorOperation(int width, int height)
+  {
+    add_output_socket(DataType::Color);
+    set_canvas({0, width, 0, height});
+  }
+};
+
+static std::unique_ptr<MemoryBuffer> create_buffer(SharedOperationBuffers &buffers,
+                                                   NodeOperation &op)
+{
+  std::unique_ptr<MemoryBuffer> buf = std::make_unique<MemoryBuffer>(
+      DataType::Color, op.get_canvas());
+  buffers.add_memory_in_use(buf->get_memory_size());
+  return buf;
+}
+
+TEST(SharedOperationBuffers, PeakMemory)
+{
+  const int64_t color_size = sizeof(float[4]);
+  ColorOperation op_a(4, 4);
+  ColorOperation op_b(2, 2);
+  ColorOperation op_c(8, 2);
+
+  SharedOperationBuffers buffers;
+  buffers.register_read(&op_a);
+  buffers.register_read(&op_b);
+  EXPECT_EQ(buffers.get_peak_memory(), 0);
+
+  buffers.set_rendered_buffer(&op_a, create_buffer(buffers, op_a));
+  buffers.set_rendered_buffer(&op_b, create_buffer(buffers, op_b));
+  EXPECT_EQ(buffers.get_peak_memory(), (16 + 4) * color_size);
+
+  /* Disposed buffers don't count anymore. */
+  buffers.read_finished(&op_a);
+  std::unique_ptr<MemoryBuffer> buf_c = create_buffer(buffers, op_c);
+  EXPECT_EQ(buffers.get_peak_memory(), (16 + 4) * color_size);
+
+  /* Temporary buffers are removed from the count by the caller. */
+  std::unique_ptr<MemoryBuffer> buf_d = create_buffer(buffers, op_c);
+  EXPECT_EQ(buffers.get_peak_memory(), (4 + 16 + 16) * color_size);
+  buffers.add_memory_in_use(-buf_c->get_memory_size());
+  buffers.add_memory_in_use(-buf_d->get_memory_size());
+  buffers.read_finished(&op_b);
+  buffers.set_rendered_buffer(&op_c, create_buffer(buffers, op_c));
+  EXPECT_EQ(buffers.get_peak_memory(), (4 + 16 + 16) * color_size);
+}
+
+}  // namespace blender::compositor::tests
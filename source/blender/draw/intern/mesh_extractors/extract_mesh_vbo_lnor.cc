@@ -199,52 +199,50 @@ static void extract_normals_bm(const MeshRenderData &mr, MutableSpan<GPUType> no
   }
 }
 
-void extract_normals(const MeshRenderData &mr, const bool use_hq, gpu::VertBuf &vbo)
+template<typename GPUType>
+static MutableSpan<GPUType> init_normals_vbo(const MeshRenderData &mr, gpu::VertBuf &vbo)
 {
   const int size = mr.corners_num + mr.loose_indices_num;
-  if (use_hq) {
-    static GPUVertFormat format = {0};
-    if (format.attr_len == 0) {
+  static GPUVertFormat format = {0};
+  if (format.attr_len == 0) {
+    if constexpr (std::is_same_v<GPUType, short4>) {
       GPU_vertformat_attr_add(&format, "nor", GPU_COMP_I16, 4, GPU_FETCH_INT_TO_FLOAT_UNIT);
-      GPU_vertformat_alias_add(&format, "lnor");
-    }
-    GPU_vertbuf_init_with_format(vbo, format);
-    GPU_vertbuf_data_alloc(vbo, size);
-    MutableSpan vbo_data(static_cast<short4 *>(GPU_vertbuf_get_data(vbo)), size);
-    MutableSpan corners_data = vbo_data.take_front(mr.corners_num);
-    MutableSpan loose_data = vbo_data.take_back(mr.loose_indices_num);
-
-    if (mr.extract_type == MR_EXTRACT_MESH) {
-      extract_normals_mesh(mr, corners_data);
-      extract_paint_overlay_flags(mr, corners_data);
     }
     else {
-      extract_normals_bm(mr, corners_data);
+      GPU_vertformat_attr_add(&format, "nor", GPU_COMP_I10, 4, GPU_FETCH_INT_TO_FLOAT_UNIT);
     }
+    GPU_vertformat_alias_add(&format, "lnor");
+  }
+  GPU_vertbuf_init_with_format(vbo, format);
+  GPU_vertbuf_data_alloc(vbo, size);
+  return MutableSpan(static_cast<GPUType *>(GPU_vertbuf_get_data(vbo)), size);
+}
+
+template<typename GPUType>
+static void extract_normals_impl(const MeshRenderData &mr, gpu::VertBuf &vbo)
+{
+  MutableSpan vbo_data = init_normals_vbo<GPUType>(mr, vbo);
+  MutableSpan corners_data = vbo_data.take_front(mr.corners_num);
+  MutableSpan loose_data = vbo_data.take_back(mr.loose_indices_num);
 
-    loose_data.fill(short4(0));
+  if (mr.extract_type == MR_EXTRACT_MESH) {
+    extract_normals_mesh(mr, corners_data);
+    extract_paint_overlay_flags(mr, corners_data);
   }
   else {
-    static GPUVertFormat format = {0};
-    if (format.attr_len == 0) {
-      GPU_vertformat_attr_add(&format, "nor", GPU_COMP_I10, 4, GPU_FETCH_INT_TO_FLOAT_UNIT);
-      GPU_vertformat_alias_add(&format, "lnor");
-    }
-    GPU_vertbuf_init_with_format(vbo, format);
-    GPU_vertbuf_data_alloc(vbo, size);
-    MutableSpan vbo_data(static_cast<GPUPackedNormal *>(GPU_vertbuf_get_data(vbo)), size);
-    MutableSpan corners_data = vbo_data.take_front(mr.corners_num);
-    MutableSpan loose_data = vbo_data.take_back(mr.loose_indices_num);
+    extract_normals_bm(mr, corners_data);
+  }
 
-    if (mr.extract_type == MR_EXTRACT_MESH) {
-      extract_normals_mesh(mr, corners_data);
-      extract_paint_overlay_flags(mr, corners_data);
-    }
-    else {
-      extract_normals_bm(mr, corners_data);
-    }
+  loose_data.fill(GPUType{});
+}
 
-    loose_data.fill(GPUPackedNormal{});
+void extract_normals(const MeshRenderData &mr, const bool use_hq, gpu::VertBuf &vbo)
+{
+  if (use_hq) {
+    extract_normals_impl<short4>(mr, vbo);
+  }
+  else {
+    extract_normals_impl<GPUPackedNormal>(mr, vbo);
   }
 }
 
@@ -30,6 +30,8 @@ namespace blender::ed::sculpt_paint {
 inline namespace draw_cc {
 
 struct LocalData {
+  Vector<float3> positions;
+  Vector<float3> normals;
   Vector<float> factors;
   Vector<float> distances;
   Vector<float3> translations;
@@ -55,21 +57,28 @@ static void calc_faces(const Sculpt &sd,
   const MutableSpan<float> factors = tls.factors;
   fill_factor_from_hide_and_mask(mesh, verts, factors);
 
+  tls.positions.reinitialize(verts.size());
+  const MutableSpan<float3> positions = tls.positions;
+  gather_data_mesh(positions_eval, verts, positions);
+
   if (brush.flag & BRUSH_FRONTFACE) {
-    calc_front_face(cache.view_normal, vert_normals, verts, factors);
+    tls.normals.reinitialize(verts.size());
+    const MutableSpan<float3> normals = tls.normals;
+    gather_data_mesh(vert_normals, verts, normals);
+    calc_front_face(cache.view_normal, normals, factors);
   }
 
   tls.distances.reinitialize(verts.size());
   const MutableSpan<float> distances = tls.distances;
   calc_distance_falloff(
-      ss, positions_eval, verts, eBrushFalloffShape(brush.falloff_shape), distances, factors);
+      ss, positions, eBrushFalloffShape(brush.falloff_shape), distances, factors);
   calc_brush_strength_factors(ss, brush, verts, distances, factors);
 
   if (ss.cache->automasking) {
     auto_mask::calc_vert_factors(object, *ss.cache->automasking, node, verts, factors);
   }
 
-  calc_brush_texture_factors(ss, brush, positions_eval, verts, factors);
+  calc_brush_texture_factors(ss, brush, positions, factors);
 
   tls.translations.reinitialize(verts.size());
   const MutableSpan<float3> translations = tls.translations;
@@ -77,7 +86,7 @@ static void calc_faces(const Sculpt &sd,
     translations[i] = offset * factors[i];
   }
 
-  clip_and_lock_translations(sd, ss, positions_eval, verts, translations);
+  clip_and_lock_translations(sd, ss, positions, translations);
 
   if (!ss.deform_imats.is_empty()) {
     apply_crazyspace_to_translations(ss.deform_imats, verts, translations);
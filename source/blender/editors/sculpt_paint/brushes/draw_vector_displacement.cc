@@ -29,6 +29,8 @@ namespace blender::ed::sculpt_paint {
 inline namespace draw_vector_displacement_cc {
 
 struct LocalData {
+  Vector<float3> positions;
+  Vector<float3> normals;
   Vector<float> factors;
   Vector<float> distances;
   Vector<float4> colors;
@@ -37,21 +39,19 @@ struct LocalData {
 
 static void calc_brush_texture_colors(SculptSession &ss,
                                       const Brush &brush,
-                                      const Span<float3> vert_positions,
-                                      const Span<int> verts,
+                                      const Span<float3> positions,
                                       const Span<float> factors,
                                       const MutableSpan<float4> r_colors)
 {
-  BLI_assert(verts.size() == r_colors.size());
+  BLI_assert(positions.size() == r_colors.size());
 
   const int thread_id = BLI_task_parallel_thread_id(nullptr);
 
-  for (const int i : verts.index_range()) {
+  for (const int i : positions.index_range()) {
     float texture_value;
     float4 texture_rgba;
     /* NOTE: This is not a thread-safe call. */
-    sculpt_apply_texture(
-        ss, brush, vert_positions[verts[i]], thread_id, &texture_value, texture_rgba);
+    sculpt_apply_texture(ss, brush, positions[i], thread_id, &texture_value, texture_rgba);
 
     r_colors[i] = texture_rgba * factors[i];
   }
@@ -76,14 +76,21 @@ static void calc_faces(const Sculpt &sd,
   const MutableSpan<float> factors = tls.factors;
   fill_factor_from_hide_and_mask(mesh, verts, factors);
 
+  tls.positions.reinitialize(verts.size());
+  const MutableSpan<float3> positions = tls.positions;
+  gather_data_mesh(positions_eval, verts, positions);
+
   if (brush.flag & BRUSH_FRONTFACE) {
-    calc_front_face(cache.view_normal, vert_normals, verts, factors);
+    tls.normals.reinitialize(verts.size());
+    const MutableSpan<float3> normals = tls.normals;
+    gather_data_mesh(vert_normals, verts, normals);
+    calc_front_face(cache.view_normal, normals, factors);
   }
 
   tls.distances.reinitialize(verts.size());
   const MutableSpan<float> distances = tls.distances;
   calc_distance_falloff(
-      ss, positions_eval, verts, eBrushFalloffShape(brush.falloff_shape), distances, factors);
+      ss, positions, eBrushFalloffShape(brush.falloff_shape), distances, factors);
   calc_brush_strength_factors(ss, brush, verts, distances, factors);
 
   if (ss.cache->automasking) {
@@ -92,7 +99,7 @@ static void calc_faces(const Sculpt &sd,
 
   tls.colors.reinitialize(verts.size());
   const MutableSpan<float4> colors = tls.colors;
-  calc_brush_texture_colors(ss, brush, positions_eval, verts, factors, colors);
+  calc_brush_texture_colors(ss, brush, positions, factors, colors);
 
   tls.translations.reinitialize(verts.size());
   const MutableSpan<float3> translations = tls.translations;
@@ -100,7 +107,7 @@ static void calc_faces(const Sculpt &sd,
     SCULPT_calc_vertex_displacement(ss, brush, colors[i], translations[i]);
   }
 
-  clip_and_lock_translations(sd, ss, positions_eval, verts, translations);
+  clip_and_lock_translations(sd, ss, positions, translations);
 
   if (!ss.deform_imats.is_empty()) {
     apply_crazyspace_to_translations(ss.deform_imats, verts, translations);
@@ -47,6 +47,20 @@ struct Cache;
  *   are built for these values, then applied to `positions_orig`.
  */
 
+/**
+ * Copy the values for a node's vertices into a contiguous node-local array. Brushes gather the
+ * positions and normals they read more than once, so the following calculations can run over
+ * densely packed data instead of going through the vertex indices every time.
+ */
+template<typename T>
+void gather_data_mesh(const Span<T> src, const Span<int> indices, const MutableSpan<T> dst)
+{
+  BLI_assert(indices.size() == dst.size());
+  for (const int i : indices.index_range()) {
+    dst[i] = src[indices[i]];
+  }
+}
+
 /**
  * Calculate initial influence factors based on vertex visibility and masking.
  */
@@ -61,6 +75,8 @@ void calc_front_face(const float3 &view_normal,
                      Span<float3> vert_normals,
                      Span<int> vert_indices,
                      MutableSpan<float> factors);
+/** Same as above, with normals that were already gathered for the node's vertices. */
+void calc_front_face(const float3 &view_normal, Span<float3> normals, MutableSpan<float> factors);
 
 /**
  * Modify influence factors based on the distance from the brush cursor and various other settings.
@@ -72,6 +88,12 @@ void calc_distance_falloff(SculptSession &ss,
                            eBrushFalloffShape falloff_shape,
                            MutableSpan<float> r_distances,
                            MutableSpan<float> factors);
+/** Same as above, with positions that were already gathered for the node's vertices. */
+void calc_distance_falloff(SculptSession &ss,
+                           Span<float3> positions,
+                           eBrushFalloffShape falloff_shape,
+                           MutableSpan<float> r_distances,
+                           MutableSpan<float> factors);
 
 /**
  * Modify the factors based on distances to the brush cursor, using various brush settings.
@@ -90,6 +112,11 @@ void calc_brush_texture_factors(SculptSession &ss,
                                 Span<float3> vert_positions,
                                 Span<int> vert_indices,
                                 MutableSpan<float> factors);
+/** Same as above, with positions that were already gathered for the node's vertices. */
+void calc_brush_texture_factors(SculptSession &ss,
+                                const Brush &brush,
+                                Span<float3> positions,
+                                MutableSpan<float> factors);
 
 namespace auto_mask {
 
@@ -131,6 +158,11 @@ void clip_and_lock_translations(const Sculpt &sd,
                                 Span<float3> positions,
                                 Span<int> verts,
                                 MutableSpan<float3> translations);
+/** Same as above, with positions that were already gathered for the node's vertices. */
+void clip_and_lock_translations(const Sculpt &sd,
+                                const SculptSession &ss,
+                                Span<float3> positions,
+                                MutableSpan<float3> translations);
 
 /**
  * Applying final positions to shape keys is non-trivial because the mesh positions and the active
@@ -6525,39 +6525,61 @@ void fill_factor_from_hide_and_mask(const Mesh &mesh,
   }
 }
 
+/**
+ * \param get_normal: Returns the normal of the vertex at an index in the factors array.
+ */
+template<typename GetNormalFn>
+static void calc_front_face_impl(const float3 &view_normal,
+                                 const GetNormalFn get_normal,
+                                 const MutableSpan<float> factors)
+{
+  for (const int i : factors.index_range()) {
+    const float dot = math::dot(view_normal, get_normal(i));
+    factors[i] *= dot > 0.0f ? dot : 0.0f;
+  }
+}
+
 void calc_front_face(const float3 &view_normal,
                      const Span<float3> vert_normals,
                      const Span<int> verts,
                      const MutableSpan<float> factors)
 {
   BLI_assert(verts.size() == factors.size());
+  calc_front_face_impl(
+      view_normal, [&](const int i) -> const float3 & { return vert_normals[verts[i]]; }, factors);
+}
 
-  for (const int i : verts.index_range()) {
-    const float dot = math::dot(view_normal, vert_normals[verts[i]]);
-    factors[i] *= dot > 0.0f ? dot : 0.0f;
-  }
+void calc_front_face(const float3 &view_normal,
+                     const Span<float3> normals,
+                     const MutableSpan<float> factors)
+{
+  BLI_assert(normals.size() == factors.size());
+  calc_front_face_impl(
+      view_normal, [&](const int i) -> const float3 & { return normals[i]; }, factors);
 }
 
-void calc_distance_falloff(SculptSession &ss,
-                           const Span<float3> positions,
-                           const Span<int> verts,
-                           const eBrushFalloffShape falloff_shape,
-                           const MutableSpan<float> r_distances,
-                           const MutableSpan<float> factors)
+/**
+ * \param get_position: Returns the position of the vertex at an index in the factors array.
+ */
+template<typename GetPositionFn>
+static void calc_distance_falloff_impl(SculptSession &ss,
+                                       const GetPositionFn get_position,
+                                       const eBrushFalloffShape falloff_shape,
+                                       const MutableSpan<float> r_distances,
+                                       const MutableSpan<float> factors)
 {
-  BLI_assert(verts.size() == factors.size());
-  BLI_assert(verts.size() == r_distances.size());
+  BLI_assert(factors.size() == r_distances.size());
 
   SculptBrushTest test;
   const SculptBrushTestFn sculpt_brush_test_sq_fn = SCULPT_brush_test_init_with_falloff_shape(
       ss, test, falloff_shape);
 
-  for (const int i : verts.index_range()) {
+  for (const int i : factors.index_range()) {
     if (factors[i] == 0.0f) {
       r_distances[i] = FLT_MAX;
       continue;
     }
-    if (!sculpt_brush_test_sq_fn(test, positions[verts[i]])) {
+    if (!sculpt_brush_test_sq_fn(test, get_position(i))) {
       factors[i] = 0.0f;
       r_distances[i] = FLT_MAX;
       continue;
@@ -6566,6 +6588,37 @@ void calc_distance_falloff(SculptSession &ss,
   }
 }
 
+void calc_distance_falloff(SculptSession &ss,
+                           const Span<float3> positions,
+                           const Span<int> verts,
+                           const eBrushFalloffShape falloff_shape,
+                           const MutableSpan<float> r_distances,
+                           const MutableSpan<float> factors)
+{
+  BLI_assert(verts.size() == factors.size());
+  calc_distance_falloff_impl(
+      ss,
+      [&](const int i) -> const float3 & { return positions[verts[i]]; },
+      falloff_shape,
+      r_distances,
+      factors);
+}
+
+void calc_distance_falloff(SculptSession &ss,
+                           const Span<float3> positions,
+                           const eBrushFalloffShape falloff_shape,
+                           const MutableSpan<float> r_distances,
+                           const MutableSpan<float> factors)
+{
+  BLI_assert(positions.size() == factors.size());
+  calc_distance_falloff_impl(
+      ss,
+      [&](const int i) -> const float3 & { return positions[i]; },
+      falloff_shape,
+      r_distances,
+      factors);
+}
+
 void calc_brush_strength_factors(const SculptSession &ss,
                                  const Brush &brush,
                                  const Span<int> verts,
@@ -6592,31 +6645,55 @@ void calc_brush_strength_factors(const SculptSession &ss,
   }
 }
 
-void calc_brush_texture_factors(SculptSession &ss,
-                                const Brush &brush,
-                                const Span<float3> vert_positions,
-                                const Span<int> verts,
-                                const MutableSpan<float> factors)
+/**
+ * \param get_position: Returns the position of the vertex at an index in the factors array.
+ */
+template<typename GetPositionFn>
+static void calc_brush_texture_factors_impl(SculptSession &ss,
+                                            const Brush &brush,
+                                            const GetPositionFn get_position,
+                                            const MutableSpan<float> factors)
 {
-  BLI_assert(verts.size() == factors.size());
-
   const int thread_id = BLI_task_parallel_thread_id(nullptr);
   const MTex *mtex = BKE_brush_mask_texture_get(&brush, OB_MODE_SCULPT);
   if (!mtex->tex) {
     return;
   }
 
-  for (const int i : verts.index_range()) {
+  for (const int i : factors.index_range()) {
     float texture_value;
     float4 texture_rgba;
     /* NOTE: This is not a thread-safe call. */
-    sculpt_apply_texture(
-        ss, brush, vert_positions[verts[i]], thread_id, &texture_value, texture_rgba);
+    sculpt_apply_texture(ss, brush, get_position(i), thread_id, &texture_value, texture_rgba);
 
     factors[i] *= texture_value;
   }
 }
 
+void calc_brush_texture_factors(SculptSession &ss,
+                                const Brush &brush,
+                                const Span<float3> vert_positions,
+                                const Span<int> verts,
+                                const MutableSpan<float> factors)
+{
+  BLI_assert(verts.size() == factors.size());
+  calc_brush_texture_factors_impl(
+      ss,
+      brush,
+      [&](const int i) -> const float3 & { return vert_positions[verts[i]]; },
+      factors);
+}
+
+void calc_brush_texture_factors(SculptSession &ss,
+                                const Brush &brush,
+                                const Span<float3> positions,
+                                const MutableSpan<float> factors)
+{
+  BLI_assert(positions.size() == factors.size());
+  calc_brush_texture_factors_impl(
+      ss, brush, [&](const int i) -> const float3 & { return positions[i]; }, factors);
+}
+
 void apply_translations(const Span<float3> translations,
                         const Span<int> verts,
                         const MutableSpan<float3> positions)
@@ -6640,14 +6717,15 @@ void apply_crazyspace_to_translations(const Span<float3x3> deform_imats,
   }
 }
 
-void clip_and_lock_translations(const Sculpt &sd,
-                                const SculptSession &ss,
-                                const Span<float3> positions,
-                                const Span<int> verts,
-                                const MutableSpan<float3> translations)
+/**
+ * \param get_position: Returns the position of the vertex at an index in the translations array.
+ */
+template<typename GetPositionFn>
+static void clip_and_lock_translations_impl(const Sculpt &sd,
+                                            const SculptSession &ss,
+                                            const GetPositionFn get_position,
+                                            const MutableSpan<float3> translations)
 {
-  BLI_assert(verts.size() == translations.size());
-
   const StrokeCache *cache = ss.cache;
   if (!cache) {
     return;
@@ -6666,22 +6744,43 @@ void clip_and_lock_translations(const Sculpt &sd,
 
     const float4x4 mirror(cache->clip_mirror_mtx);
     const float4x4 mirror_inverse = math::invert(mirror);
-    for (const int i : verts.index_range()) {
-      const int vert = verts[i];
+    for (const int i : translations.index_range()) {
+      const float3 &position = get_position(i);
 
       /* Transform into the space of the mirror plane, check translations, then transform back. */
-      float3 co_mirror = math::transform_point(mirror, positions[vert]);
+      float3 co_mirror = math::transform_point(mirror, position);
       if (math::abs(co_mirror[axis]) > cache->clip_tolerance[axis]) {
         continue;
       }
       /* Clear the translation in the local space of the mirror object. */
       co_mirror[axis] = 0.0f;
       const float3 co_local = math::transform_point(mirror_inverse, co_mirror);
-      translations[i][axis] = co_local[axis] - positions[vert][axis];
+      translations[i][axis] = co_local[axis] - position[axis];
     }
   }
 }
 
+void clip_and_lock_translations(const Sculpt &sd,
+                                const SculptSession &ss,
+                                const Span<float3> positions,
+                                const Span<int> verts,
+                                const MutableSpan<float3> translations)
+{
+  BLI_assert(verts.size() == translations.size());
+  clip_and_lock_translations_impl(
+      sd, ss, [&](const int i) -> const float3 & { return positions[verts[i]]; }, translations);
+}
+
+void clip_and_lock_translations(const Sculpt &sd,
+                                const SculptSession &ss,
+                                const Span<float3> positions,
+                                const MutableSpan<float3> translations)
+{
+  BLI_assert(positions.size() == translations.size());
+  clip_and_lock_translations_impl(
+      sd, ss, [&](const int i) -> const float3 & { return positions[i]; }, translations);
+}
+
 void apply_translations_to_shape_keys(Object &object,
                                       const Span<int> verts,
                                       const Span<float3> translations,
@@ -228,6 +228,12 @@ struct Node {
 
   Vector<int> face_indices;
 
+  /**
+   * Compressed copy of the per-element arrays above, used when the undo step isn't the most
+   * recent one. The arrays are empty while the data is compressed.
+   */
+  Array<std::byte> compressed;
+
   size_t undo_size;
 };
 
@@ -30,13 +30,19 @@
  * Operators must have the OPTYPE_UNDO flag set for this to work properly.
  */
 
+#include <atomic>
 #include <cstddef>
+#include <mutex>
+
+#include <zstd.h>
 
 #include "MEM_guardedalloc.h"
 
 #include "BLI_array_utils.hh"
 #include "BLI_listbase.h"
 #include "BLI_string.h"
+#include "BLI_task.h"
+#include "BLI_task.hh"
 #include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
@@ -129,6 +135,11 @@ struct StepData {
   Vector<std::unique_ptr<Node>> nodes;
 
   size_t undo_size;
+
+  /** Compresses the node arrays in the background, see #compress_step_data_begin. */
+  TaskPool *compress_pool;
+  /** Set when compression was started, until the step is decompressed again. */
+  std::atomic<bool> is_compressed;
 };
 
 struct SculptAttrRef {
@@ -161,9 +172,13 @@ static SculptUndoStep *get_active_step()
   return reinterpret_cast<SculptUndoStep *>(us);
 }
 
+static void decompress_step_data(SculptUndoStep &us);
+
 static StepData *get_step_data()
 {
   if (SculptUndoStep *us = get_active_step()) {
+    /* Outside of a push the active step may be one that was compressed after undo or redo. */
+    decompress_step_data(*us);
     return &us->data;
   }
   return nullptr;
@@ -1109,6 +1124,252 @@ static void restore_list(bContext *C, Depsgraph *depsgraph, StepData &step_data)
   }
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Compression
+ *
+ * Steps that are not the most recent one are only accessed when undoing or redoing, so their
+ * large per-vertex arrays are kept compressed in the meantime. The arrays of a node are
+ * concatenated and byte-shuffled (all bytes of the same significance are stored together), which
+ * makes the slowly varying float data compress well with a fast compression level. Compression
+ * runs in a background task pool that is finished before the step is accessed again.
+ * \{ */
+
+template<typename Fn> static void foreach_compressed_array(Node &unode, Fn &&fn)
+{
+  fn(unode.position);
+  fn(unode.orig_position);
+  fn(unode.col);
+  fn(unode.mask);
+  fn(unode.loop_col);
+  fn(unode.orig_loop_col);
+  fn(unode.face_sets);
+}
+
+/** All compressed arrays have elements made of 4 byte values. */
+constexpr int64_t compress_word_size = 4;
+
+static void byte_shuffle(const Span<std::byte> src, MutableSpan<std::byte> dst)
+{
+  const int64_t words_num = src.size() / compress_word_size;
+  for (const int64_t i : IndexRange(words_num)) {
+    for (const int64_t byte : IndexRange(compress_word_size)) {
+      dst[byte * words_num + i] = src[i * compress_word_size + byte];
+    }
+  }
+}
+
+static void byte_unshuffle(const Span<std::byte> src, MutableSpan<std::byte> dst)
+{
+  const int64_t words_num = src.size() / compress_word_size;
+  for (const int64_t i : IndexRange(words_num)) {
+    for (const int64_t byte : IndexRange(compress_word_size)) {
+      dst[i * compress_word_size + byte] = src[byte * words_num + i];
+    }
+  }
+}
+
+/** \return The number of bytes the node's memory usage changed by. */
+static int64_t compress_node(Node &unode)
+{
+  if (!unode.compressed.is_empty()) {
+    return 0;
+  }
+  int64_t arrays_num = 0;
+  int64_t arrays_size = 0;
+  foreach_compressed_array(unode, [&](auto &array) {
+    static_assert(sizeof(array[0]) % compress_word_size == 0);
+    arrays_num++;
+    arrays_size += array.as_span().size_in_bytes();
+  });
+  if (arrays_size == 0) {
+    return 0;
+  }
+
+  /* Every array is prefixed by its size, so that it can be reconstructed. */
+  const int64_t raw_size = arrays_size + arrays_num * int64_t(sizeof(int64_t));
+  Array<std::byte> raw(raw_size);
+  int64_t offset = 0;
+  foreach_compressed_array(unode, [&](auto &array) {
+    const int64_t size = array.size();
+    memcpy(&raw[offset], &size, sizeof(int64_t));
+    offset += sizeof(int64_t);
+    if (!array.is_empty()) {
+      memcpy(&raw[offset], array.data(), array.as_span().size_in_bytes());
+      offset += array.as_span().size_in_bytes();
+    }
+  });
+
+  Array<std::byte> shuffled(raw_size);
+  byte_shuffle(raw, shuffled);
+  raw = {};
+
+  Array<std::byte> compressed(ZSTD_compressBound(size_t(raw_size)));
+  const size_t compressed_size = ZSTD_compress(
+      compressed.data(), compressed.size(), shuffled.data(), size_t(raw_size), 1);
+  if (ZSTD_isError(compressed_size) || int64_t(compressed_size) >= raw_size) {
+    return 0;
+  }
+
+  unode.compressed = Array<std::byte>(compressed.as_span().take_front(int64_t(compressed_size)));
+  foreach_compressed_array(unode, [&](auto &array) { array = {}; });
+  return int64_t(compressed_size) - arrays_size;
+}
+
+/** \return The number of bytes the node's memory usage changed by. */
+static int64_t decompress_node(Node &unode)
+{
+  if (unode.compressed.is_empty()) {
+    return 0;
+  }
+  const int64_t compressed_size = unode.compressed.size();
+  const unsigned long long raw_size = ZSTD_getFrameContentSize(unode.compressed.data(),
+                                                               size_t(compressed_size));
+  BLI_assert(raw_size != ZSTD_CONTENTSIZE_UNKNOWN && raw_size != ZSTD_CONTENTSIZE_ERROR);
+  Array<std::byte> shuffled(static_cast<int64_t>(raw_size));
+  const size_t result = ZSTD_decompress(
+      shuffled.data(), size_t(raw_size), unode.compressed.data(), size_t(compressed_size));
+  BLI_assert(result == raw_size);
+  UNUSED_VARS_NDEBUG(result);
+  unode.compressed = {};
+
+  Array<std::byte> raw(shuffled.size());
+  byte_unshuffle(shuffled, raw);
+  shuffled = {};
+
+  int64_t arrays_size = 0;
+  int64_t offset = 0;
+  foreach_compressed_array(unode, [&](auto &array) {
+    int64_t size;
+    memcpy(&size, &raw[offset], sizeof(int64_t));
+    offset += sizeof(int64_t);
+    array.reinitialize(size);
+    if (size > 0) {
+      memcpy(array.data(), &raw[offset], array.as_span().size_in_bytes());
+      offset += array.as_span().size_in_bytes();
+      arrays_size += array.as_span().size_in_bytes();
+    }
+  });
+  return arrays_size - compressed_size;
+}
+
+static void compress_step_data_task(TaskPool *__restrict /*pool*/, void *taskdata)
+{
+  StepData &step_data = *static_cast<StepData *>(taskdata);
+  Array<int64_t> size_changes(step_data.nodes.size());
+  threading::parallel_for(step_data.nodes.index_range(), 1, [&](const IndexRange range) {
+    for (const int i : range) {
+      size_changes[i] = compress_node(*step_data.nodes[i]);
+    }
+  });
+  for (const int64_t change : size_changes) {
+    step_data.undo_size += change;
+  }
+}
+
+/** Start compressing the node arrays in the background. */
+static void compress_step_data_begin(StepData &step_data)
+{
+  /* Steps that are compressed already may still be compressing in the background. */
+  if (step_data.is_compressed || step_data.nodes.is_empty()) {
+    return;
+  }
+  BLI_assert(step_data.compress_pool == nullptr);
+  step_data.is_compressed = true;
+  step_data.compress_pool = BLI_task_pool_create_background(nullptr, TASK_PRIORITY_LOW);
+  BLI_task_pool_push(
+      step_data.compress_pool, compress_step_data_task, &step_data, false, nullptr);
+}
+
+/** Wait for background compression to finish, the step data can be accessed afterwards. */
+static void compress_step_data_end(SculptUndoStep &us)
+{
+  StepData &step_data = us.data;
+  if (step_data.compress_pool == nullptr) {
+    return;
+  }
+  BLI_task_pool_work_and_wait(step_data.compress_pool);
+  BLI_task_pool_free(step_data.compress_pool);
+  step_data.compress_pool = nullptr;
+  us.step.data_size = step_data.undo_size;
+}
+
+/**
+ * Make the node arrays accessible again. This is cheap when the step isn't compressed, and safe
+ * to call from multiple threads, since nodes are looked up from within parallel loops.
+ */
+static void decompress_step_data(SculptUndoStep &us)
+{
+  StepData &step_data = us.data;
+  if (!step_data.is_compressed) {
+    return;
+  }
+  static std::mutex mutex;
+  std::scoped_lock lock(mutex);
+  if (!step_data.is_compressed) {
+    return;
+  }
+  /* Isolate the task, so that waiting threads don't run tasks that need the same lock. */
+  threading::isolate_task([&]() {
+    compress_step_data_end(us);
+    Array<int64_t> size_changes(step_data.nodes.size());
+    threading::parallel_for(step_data.nodes.index_range(), 1, [&](const IndexRange range) {
+      for (const int i : range) {
+        size_changes[i] = decompress_node(*step_data.nodes[i]);
+      }
+    });
+    for (const int64_t change : size_changes) {
+      step_data.undo_size += change;
+    }
+    us.step.data_size = step_data.undo_size;
+  });
+  step_data.is_compressed = false;
+}
+
+/**
+ * Wait for the compression of the other sculpt steps in the stack of the given step, so that
+ * their size accounts for it in the undo memory limit.
+ */
+static void compress_other_steps_end(const UndoStep &us_in_stack)
+{
+  const auto compress_end = [&](UndoStep *us) {
+    if (us->type == BKE_UNDOSYS_TYPE_SCULPT) {
+      compress_step_data_end(*reinterpret_cast<SculptUndoStep *>(us));
+    }
+  };
+  for (UndoStep *us = us_in_stack.prev; us; us = us->prev) {
+    compress_end(us);
+  }
+  for (UndoStep *us = us_in_stack.next; us; us = us->next) {
+    compress_end(us);
+  }
+}
+
+/**
+ * The active step is un-applied by the next undo and the step after it is applied by the next
+ * redo, so only those are kept uncompressed. All other sculpt steps are compressed when they are
+ * evicted from that set, steps that are compressed already are left as they are. Compressions
+ * started before are finished first, so that the size of the steps they evicted is up to date.
+ */
+static void compress_evicted_steps(const UndoStep &us_active)
+{
+  compress_other_steps_end(us_active);
+  const auto compress_step = [&](UndoStep *us) {
+    if (us->type == BKE_UNDOSYS_TYPE_SCULPT) {
+      compress_step_data_begin(reinterpret_cast<SculptUndoStep *>(us)->data);
+    }
+  };
+  for (UndoStep *us = us_active.prev; us; us = us->prev) {
+    compress_step(us);
+  }
+  if (us_active.next) {
+    for (UndoStep *us = us_active.next->next; us; us = us->next) {
+      compress_step(us);
+    }
+  }
+}
+
+/** \} */
+
 static void free_step_data(StepData &step_data)
 {
   for (std::unique_ptr<Node> &unode : step_data.nodes) {
@@ -1800,6 +2061,14 @@ static bool step_encode(bContext * /*C*/, Main *bmain, UndoStep *us_p)
   SculptUndoStep *us = (SculptUndoStep *)us_p;
   us->step.data_size = us->data.undo_size;
 
+  /* The previous step is only needed again for undo, so it can be compressed now. The original
+   * data of the most recent step may still be accessed by sculpt operators. */
+  if (UndoStep *us_prev = us_p->prev; us_prev && us_prev->type == BKE_UNDOSYS_TYPE_SCULPT) {
+    /* Account for the compressed size of older steps in the undo memory limit. */
+    compress_other_steps_end(*us_prev);
+    compress_step_data_begin(reinterpret_cast<SculptUndoStep *>(us_prev)->data);
+  }
+
   Node *unode = us->data.nodes.is_empty() ? nullptr : us->data.nodes.last().get();
   if (unode && unode->type == Type::DyntopoEnd) {
     us->step.use_memfile_step = true;
@@ -1817,6 +2086,7 @@ static void step_decode_undo_impl(bContext *C, Depsgraph *depsgraph, SculptUndoS
 {
   BLI_assert(us->step.is_applied == true);
 
+  decompress_step_data(*us);
   restore_list(C, depsgraph, us->data);
   us->step.is_applied = false;
 
@@ -1827,6 +2097,7 @@ static void step_decode_redo_impl(bContext *C, Depsgraph *depsgraph, SculptUndoS
 {
   BLI_assert(us->step.is_applied == false);
 
+  decompress_step_data(*us);
   restore_list(C, depsgraph, us->data);
   us->step.is_applied = true;
 
@@ -1937,11 +2208,15 @@ static void step_decode(
   else if (dir == STEP_REDO) {
     step_decode_redo(C, depsgraph, us);
   }
+  if (is_final) {
+    compress_evicted_steps(us->step);
+  }
 }
 
 static void step_free(UndoStep *us_p)
 {
   SculptUndoStep *us = (SculptUndoStep *)us_p;
+  compress_step_data_end(*us);
   free_step_data(us->data);
 }
 
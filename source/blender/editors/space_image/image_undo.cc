@@ -217,25 +217,29 @@ void *ED_image_paint_tile_push(PaintTileMap *paint_tile_map,
                                bool use_thread_lock,
                                bool find_prev)
 {
-  if (use_thread_lock) {
-    BLI_spin_lock(&paint_tiles_lock);
-  }
   const bool has_float = (ibuf->float_buffer.data != nullptr);
 
   /* check if tile is already pushed */
 
   /* in projective painting we keep accounting of tiles, so if we need one pushed, just push! */
   if (find_prev) {
+    if (use_thread_lock) {
+      BLI_spin_lock(&paint_tiles_lock);
+    }
     void *data = ED_image_paint_tile_find(
         paint_tile_map, image, ibuf, iuser, x_tile, y_tile, r_mask, true);
+    if (use_thread_lock) {
+      BLI_spin_unlock(&paint_tiles_lock);
+    }
     if (data) {
-      if (use_thread_lock) {
-        BLI_spin_unlock(&paint_tiles_lock);
-      }
       return data;
     }
   }
 
+  /* The tile is allocated and copied without holding the lock. The temporary buffer is owned by
+   * the calling thread, and callers make sure nothing paints into the tile before it's pushed, so
+   * only the map itself has to be protected. This keeps threads pushing different tiles from
+   * waiting on each other's copies. */
   if (*tmpibuf == nullptr) {
     *tmpibuf = imbuf_alloc_temp_tile();
   }
@@ -252,7 +256,7 @@ void *ED_image_paint_tile_push(PaintTileMap *paint_tile_map,
 
   /* add mask explicitly here */
   if (r_mask) {
-    *r_mask = ptile->mask = static_cast<uint16_t *>(
+    ptile->mask = static_cast<uint16_t *>(
         MEM_callocN(sizeof(uint16_t) * square_i(ED_IMAGE_UNDO_TILE_SIZE), "PaintTile.mask"));
   }
 
@@ -263,10 +267,6 @@ void *ED_image_paint_tile_push(PaintTileMap *paint_tile_map,
   ptile->use_float = has_float;
   ptile->valid = true;
 
-  if (r_valid) {
-    *r_valid = &ptile->valid;
-  }
-
   IMB_rectcpy(*tmpibuf,
               ibuf,
               0,
@@ -290,15 +290,29 @@ void *ED_image_paint_tile_push(PaintTileMap *paint_tile_map,
   key.x_tile = x_tile;
   key.y_tile = y_tile;
   PaintTile *existing_tile = nullptr;
+  if (use_thread_lock) {
+    BLI_spin_lock(&paint_tiles_lock);
+  }
   paint_tile_map->map.add_or_modify(
       key,
       [&](PaintTile **pptile) { *pptile = ptile; },
       [&](PaintTile **pptile) { existing_tile = *pptile; });
   if (existing_tile) {
+    /* The tile was pushed already, possibly by another thread. Keep the first copy, it holds
+     * the oldest pixels. */
     ptile_free(ptile);
     ptile = existing_tile;
+    if (r_mask && !ptile->mask) {
+      ptile->mask = static_cast<uint16_t *>(MEM_callocN(
+          sizeof(uint16_t) * square_i(ED_IMAGE_UNDO_TILE_SIZE), "PaintTile.mask"));
+    }
+  }
+  if (r_mask) {
+    *r_mask = ptile->mask;
+  }
+  if (r_valid) {
+    *r_valid = &ptile->valid;
   }
-
   if (use_thread_lock) {
     BLI_spin_unlock(&paint_tiles_lock);
   }
@@ -0,0 +1,44 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#pragma once
+
+#include <optional>
+
+#include "BLI_index_mask.hh"
+
+struct Mesh;
+namespace blender::bke {
+class AnonymousAttributePropagationInfo;
+}
+
+namespace blender::geometry {
+
+/**
+ * Bevel the selected vertices with a single segment, working directly on the mesh arrays instead
+ * of going through #BMesh. Every selected vertex is replaced by new vertices on its connected
+ * edges, \a offset away from the original position. The new vertices are connected across every
+ * face corner and the hole around the vertex is closed with a new face.
+ *
+ * This is not a replacement for #BM_mesh_bevel: the element order of the result is different,
+ * and only generic attributes are propagated, so custom normals and original index layers are
+ * lost. Original edges and faces keep their indices, new edges and faces are added after them.
+ * New edges use default attribute values, face corner attributes are interpolated along the
+ * original edges.
+ *
+ * Vertices used by less than two edges or by loose edges are not beveled. Neither are
+ * non-manifold vertices, whose faces don't form a single fan that a new face could close.
+ *
+ * \param clamp_overlap: Reduce the offset of all vertices so that new vertices never pass each
+ * other on an edge.
+ * \return #std::nullopt if the mesh would be unchanged.
+ */
+std::optional<Mesh *> mesh_bevel_vertices(
+    const Mesh &src_mesh,
+    const IndexMask &selection,
+    float offset,
+    bool clamp_overlap,
+    const bke::AnonymousAttributePropagationInfo &propagation_info);
+
+}  // namespace blender::geometry
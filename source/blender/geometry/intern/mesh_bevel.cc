@@ -0,0 +1,498 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "BLI_array_utils.hh"
+#include "BLI_index_mask.hh"
+#include "BLI_listbase.h"
+#include "BLI_map.hh"
+#include "BLI_math_vector.hh"
+#include "BLI_set.hh"
+#include "BLI_task.hh"
+
+#include "DNA_meshdata_types.h"
+#include "DNA_object_types.h"
+
+#include "BKE_attribute.hh"
+#include "BKE_attribute_math.hh"
+#include "BKE_deform.hh"
+#include "BKE_mesh.hh"
+#include "BKE_mesh_mapping.hh"
+
+#include "GEO_mesh_bevel.hh"
+
+namespace blender::geometry {
+
+/**
+ * Reorder the corners around a beveled vertex so that consecutive corners share an edge, in the
+ * winding order of the new face that closes the hole around the vertex. Corner `c` is followed by
+ * the corner whose next edge is the previous edge of `c`.
+ *
+ * \return The number of corners in the new face, zero if the fan is too small to need a face, or
+ * -1 if the corners don't form a single manifold fan.
+ */
+static int sort_cap_corners(const OffsetIndices<int> faces,
+                            const Span<int> corner_edges,
+                            const Span<int> corner_to_face,
+                            MutableSpan<int> corners,
+                            bool &r_is_open)
+{
+  auto prev_edge = [&](const int corner) {
+    return corner_edges[bke::mesh::face_corner_prev(faces[corner_to_face[corner]], corner)];
+  };
+
+  /* Every edge is used at most once as next and once as previous edge in a manifold fan. */
+  Map<int, int> corner_by_next_edge;
+  Set<int> prev_edges;
+  corner_by_next_edge.reserve(corners.size());
+  prev_edges.reserve(corners.size());
+  for (const int corner : corners) {
+    if (!corner_by_next_edge.add(corner_edges[corner], corner) ||
+        !prev_edges.add(prev_edge(corner)))
+    {
+      return -1;
+    }
+  }
+
+  /* Start with a corner that nothing leads to, if there is one (the vertex is on a boundary). */
+  r_is_open = false;
+  int corner = corners.first();
+  for (const int other : corners) {
+    if (!prev_edges.contains(corner_edges[other])) {
+      corner = other;
+      r_is_open = true;
+      break;
+    }
+  }
+
+  const int first_corner = corner;
+  for (const int i : corners.index_range()) {
+    corners[i] = corner;
+    if (i == corners.size() - 1) {
+      break;
+    }
+    const int *next_corner = corner_by_next_edge.lookup_ptr(prev_edge(corner));
+    if (next_corner == nullptr || *next_corner == first_corner) {
+      /* The corners form more than one fan. */
+      return -1;
+    }
+    corner = *next_corner;
+  }
+
+  const int size = int(corners.size()) + int(r_is_open);
+  return size >= 3 ? size : 0;
+}
+
+std::optional<Mesh *> mesh_bevel_vertices(
+    const Mesh &src_mesh,
+    const IndexMask &selection,
+    const float offset,
+    const bool clamp_overlap,
+    const bke::AnonymousAttributePropagationInfo &propagation_info)
+{
+  if (selection.is_empty() || offset <= 0.0f) {
+    return std::nullopt;
+  }
+
+  const Span<float3> src_positions = src_mesh.vert_positions();
+  const Span<int2> src_edges = src_mesh.edges();
+  const OffsetIndices src_faces = src_mesh.faces();
+  const Span<int> src_corner_verts = src_mesh.corner_verts();
+  const Span<int> src_corner_edges = src_mesh.corner_edges();
+  const Span<int> corner_to_face = src_mesh.corner_to_face_map();
+
+  Array<int> vert_to_corner_offsets;
+  Array<int> vert_to_corner_indices;
+  const GroupedSpan<int> vert_to_corner_map = bke::mesh::build_vert_to_corner_map(
+      src_corner_verts, src_mesh.verts_num, vert_to_corner_offsets, vert_to_corner_indices);
+
+  Array<int> vert_edge_counts(src_mesh.verts_num, 0);
+  array_utils::count_indices(src_edges.cast<int>(), vert_edge_counts);
+
+  /* Find the corners of the new faces around each vertex. Vertices where the faces don't form a
+   * single fan are kept, since no face could close the hole left by beveling them. Boundary
+   * vertices need an extra edge to close the face. */
+  Array<bool> beveled(src_mesh.verts_num, false);
+  Array<int> cap_sizes(src_mesh.verts_num, 0);
+  Array<bool> cap_is_open(src_mesh.verts_num, false);
+  selection.foreach_index(GrainSize(1024), [&](const int vert) {
+    if (vert_edge_counts[vert] < 2) {
+      return;
+    }
+    cap_sizes[vert] = sort_cap_corners(
+        src_faces,
+        src_corner_edges,
+        corner_to_face,
+        vert_to_corner_indices.as_mutable_span().slice(vert_to_corner_map.offsets[vert]),
+        cap_is_open[vert]);
+    beveled[vert] = cap_sizes[vert] >= 0;
+  });
+  /* There is no face to connect loose edges to the new vertices, so their vertices are kept. */
+  const bke::LooseEdgeCache &loose_edges = src_mesh.loose_edges();
+  if (loose_edges.count > 0) {
+    for (const int edge : src_edges.index_range()) {
+      if (loose_edges.is_loose_bits[edge]) {
+        beveled[src_edges[edge][0]] = false;
+        beveled[src_edges[edge][1]] = false;
+      }
+    }
+  }
+
+  IndexMaskMemory memory;
+  const IndexMask bevel_verts = IndexMask::from_bools(beveled, memory);
+  if (bevel_verts.is_empty()) {
+    return std::nullopt;
+  }
+  const IndexMask kept_verts = bevel_verts.complement(IndexRange(src_mesh.verts_num), memory);
+
+  /* Like the BMesh bevel, clamp the offset of all vertices so that no new vertices pass each
+   * other on an edge. */
+  float limited_offset = offset;
+  if (clamp_overlap) {
+    limited_offset = threading::parallel_reduce(
+        src_edges.index_range(),
+        4096,
+        offset,
+        [&](const IndexRange range, float limit) {
+          for (const int edge : range) {
+            const int2 verts = src_edges[edge];
+            const int beveled_ends = int(beveled[verts[0]]) + int(beveled[verts[1]]);
+            if (beveled_ends > 0) {
+              const float length = math::distance(src_positions[verts[0]],
+                                                  src_positions[verts[1]]);
+              limit = std::min(limit, length / float(beveled_ends));
+            }
+          }
+          return limit;
+        },
+        [](const float a, const float b) { return std::min(a, b); });
+  }
+
+  /* Every edge end at a beveled vertex gets a new vertex. */
+  Array<int> edge_vert_offsets_data(src_edges.size() + 1);
+  threading::parallel_for(src_edges.index_range(), 4096, [&](const IndexRange range) {
+    for (const int edge : range) {
+      edge_vert_offsets_data[edge] = int(beveled[src_edges[edge][0]]) +
+                                     int(beveled[src_edges[edge][1]]);
+    }
+  });
+  const OffsetIndices edge_vert_offsets = offset_indices::accumulate_counts_to_offsets(
+      edge_vert_offsets_data, int(kept_verts.size()));
+  const int dst_verts_num = edge_vert_offsets.total_size() + int(kept_verts.size());
+
+  auto edge_end_vert = [&](const int edge, const int vert) {
+    const int2 verts = src_edges[edge];
+    const int start = edge_vert_offsets[edge].start();
+    return verts[0] == vert ? start : start + int(beveled[verts[0]]);
+  };
+
+  /* Position of every new vertex along its edge, used to place it and to interpolate the face
+   * corner attributes at it. */
+  Array<float> new_vert_factors(edge_vert_offsets.total_size());
+  threading::parallel_for(src_edges.index_range(), 4096, [&](const IndexRange range) {
+    for (const int edge : range) {
+      const int2 verts = src_edges[edge];
+      const float length = math::distance(src_positions[verts[0]], src_positions[verts[1]]);
+      float factor = 0.0f;
+      if (length > 0.0f) {
+        /* Same as the BMesh bevel, which keeps the new vertex just before the other end. */
+        factor = (limited_offset > length ? length - 5e-5f : limited_offset) / length;
+      }
+      for (const int vert_index : edge_vert_offsets[edge]) {
+        new_vert_factors[vert_index - kept_verts.size()] = factor;
+      }
+    }
+  });
+  auto edge_end_factor = [&](const int edge, const int vert) {
+    return new_vert_factors[edge_end_vert(edge, vert) - kept_verts.size()];
+  };
+
+  /* The two faces around a vertex used by two edges are cut between the same new vertices, so
+   * they share a single cut edge, added by the first corner. */
+  auto is_shared_cut = [&](const int vert) {
+    return vert_edge_counts[vert] == 2 && vert_to_corner_map[vert].size() == 2;
+  };
+  auto owns_cut_edge = [&](const int corner) {
+    const int vert = src_corner_verts[corner];
+    if (!is_shared_cut(vert)) {
+      return true;
+    }
+    const Span<int> vert_corners = vert_to_corner_map[vert];
+    return corner == std::min(vert_corners[0], vert_corners[1]);
+  };
+
+  /* Every face corner at a beveled vertex is cut by a new edge. */
+  Array<int> face_cut_offsets_data(src_faces.size() + 1);
+  threading::parallel_for(src_faces.index_range(), 1024, [&](const IndexRange range) {
+    for (const int face : range) {
+      int count = 0;
+      for (const int corner : src_faces[face]) {
+        count += int(beveled[src_corner_verts[corner]] && owns_cut_edge(corner));
+      }
+      face_cut_offsets_data[face] = count;
+    }
+  });
+  const OffsetIndices face_cut_offsets = offset_indices::accumulate_counts_to_offsets(
+      face_cut_offsets_data, src_mesh.edges_num);
+  const int cut_edges_end = face_cut_offsets.total_size() + src_mesh.edges_num;
+
+  Array<int> corner_cut_edges(src_mesh.corners_num);
+  threading::parallel_for(src_faces.index_range(), 1024, [&](const IndexRange range) {
+    for (const int face : range) {
+      int cut_edge = face_cut_offsets[face].start();
+      for (const int corner : src_faces[face]) {
+        if (beveled[src_corner_verts[corner]] && owns_cut_edge(corner)) {
+          corner_cut_edges[corner] = cut_edge++;
+        }
+      }
+    }
+  });
+  threading::parallel_for(src_faces.index_range(), 1024, [&](const IndexRange range) {
+    for (const int face : range) {
+      for (const int corner : src_faces[face]) {
+        if (beveled[src_corner_verts[corner]] && !owns_cut_edge(corner)) {
+          const Span<int> vert_corners = vert_to_corner_map[src_corner_verts[corner]];
+          corner_cut_edges[corner] = corner_cut_edges[std::min(vert_corners[0], vert_corners[1])];
+        }
+      }
+    }
+  });
+
+  Array<int> cap_corner_offsets_data(bevel_verts.size() + 1);
+  Array<int> closing_edge_offsets_data(bevel_verts.size() + 1);
+  bevel_verts.foreach_index(GrainSize(4096), [&](const int vert, const int i) {
+    cap_corner_offsets_data[i] = cap_sizes[vert];
+    closing_edge_offsets_data[i] = int(cap_sizes[vert] > 0 && cap_is_open[vert]);
+  });
+  const OffsetIndices cap_corner_offsets = offset_indices::accumulate_counts_to_offsets(
+      cap_corner_offsets_data);
+  const OffsetIndices closing_edge_offsets = offset_indices::accumulate_counts_to_offsets(
+      closing_edge_offsets_data, cut_edges_end);
+  const IndexMask caps = IndexMask::from_predicate(
+      bevel_verts.index_range(), GrainSize(4096), memory, [&](const int i) {
+        return !cap_corner_offsets[i].is_empty();
+      });
+
+  const int dst_edges_num = closing_edge_offsets.total_size() + cut_edges_end;
+  const int dst_faces_num = src_faces.size() + int(caps.size());
+  const int src_faces_corners_num = src_mesh.corners_num + face_cut_offsets.total_size();
+  const int dst_corners_num = src_faces_corners_num + cap_corner_offsets.total_size();
+
+  Mesh *dst_mesh = bke::mesh_new_no_attributes(
+      dst_verts_num, dst_edges_num, dst_faces_num, dst_corners_num);
+  BKE_mesh_copy_parameters_for_eval(dst_mesh, &src_mesh);
+  bke::MutableAttributeAccessor dst_attributes = dst_mesh->attributes_for_write();
+  dst_attributes.add<int2>(".edge_verts", bke::AttrDomain::Edge, bke::AttributeInitConstruct());
+  dst_attributes.add<int>(".corner_vert", bke::AttrDomain::Corner, bke::AttributeInitConstruct());
+  dst_attributes.add<int>(".corner_edge", bke::AttrDomain::Corner, bke::AttributeInitConstruct());
+  MutableSpan<int2> dst_edges = dst_mesh->edges_for_write();
+  MutableSpan<int> dst_face_offsets = dst_mesh->face_offsets_for_write();
+  MutableSpan<int> dst_corner_verts = dst_mesh->corner_verts_for_write();
+  MutableSpan<int> dst_corner_edges = dst_mesh->corner_edges_for_write();
+
+  /* Maps from every new element to the original element its attribute values are copied from.
+   * New face corners on an original edge also interpolate with the corner at its other end. */
+  Array<int> vert_src(dst_verts_num);
+  Array<int> face_src(dst_faces_num);
+  Array<int> corner_src(dst_corners_num);
+  Array<int> corner_mix_src(dst_corners_num, -1);
+  Array<float> corner_mix_factors(dst_corners_num);
+
+  /* Kept original faces grow by one corner for every cut. */
+  threading::parallel_for(src_faces.index_range(), 4096, [&](const IndexRange range) {
+    for (const int face : range) {
+      dst_face_offsets[face] = src_faces.data()[face] + face_cut_offsets.data()[face] -
+                               src_mesh.edges_num;
+    }
+  });
+  dst_face_offsets[src_faces.size()] = src_faces_corners_num;
+  offset_indices::gather_selected_offsets(cap_corner_offsets,
+                                          caps,
+                                          src_faces_corners_num,
+                                          dst_face_offsets.drop_front(src_faces.size()));
+  const OffsetIndices<int> dst_faces = dst_mesh->faces();
+
+  threading::parallel_invoke(
+      dst_verts_num > 1024,
+      [&]() {
+        Array<int> vert_map(src_mesh.verts_num);
+        index_mask::build_reverse_map<int>(kept_verts, vert_map);
+        kept_verts.to_indices(vert_src.as_mutable_span().take_front(kept_verts.size()));
+        threading::parallel_for(src_edges.index_range(), 4096, [&](const IndexRange range) {
+          for (const int edge : range) {
+            const int2 src_edge = src_edges[edge];
+            int2 &dst_edge = dst_edges[edge];
+            for (const int side : IndexRange(2)) {
+              const int vert = src_edge[side];
+              if (beveled[vert]) {
+                dst_edge[side] = edge_end_vert(edge, vert);
+                vert_src[dst_edge[side]] = vert;
+              }
+              else {
+                dst_edge[side] = vert_map[vert];
+              }
+            }
+          }
+        });
+        threading::parallel_for(src_faces.index_range(), 1024, [&](const IndexRange range) {
+          for (const int face : range) {
+            const IndexRange src_face = src_faces[face];
+            const IndexRange dst_face = dst_faces[face];
+            int dst_corner = dst_face.start();
+            for (const int corner : src_face) {
+              const int vert = src_corner_verts[corner];
+              const int next_edge = src_corner_edges[corner];
+              if (beveled[vert]) {
+                const int corner_prev = bke::mesh::face_corner_prev(src_face, corner);
+                const int prev_edge = src_corner_edges[corner_prev];
+                const int prev_vert = edge_end_vert(prev_edge, vert);
+                const int next_vert = edge_end_vert(next_edge, vert);
+                const int cut_edge = corner_cut_edges[corner];
+                if (owns_cut_edge(corner)) {
+                  dst_edges[cut_edge] = int2(prev_vert, next_vert);
+                }
+                dst_corner_verts[dst_corner] = prev_vert;
+                dst_corner_edges[dst_corner] = cut_edge;
+                corner_src[dst_corner] = corner;
+                corner_mix_src[dst_corner] = corner_prev;
+                corner_mix_factors[dst_corner] = edge_end_factor(prev_edge, vert);
+                dst_corner++;
+                dst_corner_verts[dst_corner] = next_vert;
+                corner_mix_src[dst_corner] = bke::mesh::face_corner_next(src_face, corner);
+                corner_mix_factors[dst_corner] = edge_end_factor(next_edge, vert);
+              }
+              else {
+                dst_corner_verts[dst_corner] = vert_map[vert];
+              }
+              dst_corner_edges[dst_corner] = next_edge;
+              corner_src[dst_corner] = corner;
+              dst_corner++;
+            }
+            face_src[face] = face;
+          }
+        });
+      },
+      [&]() {
+        caps.foreach_index(GrainSize(512), [&](const int i, const int cap) {
+          const int vert = bevel_verts[i];
+          const Span<int> corners = vert_to_corner_map[vert];
+          const IndexRange dst_face = dst_faces[src_faces.size() + cap];
+          for (const int j : corners.index_range()) {
+            const int corner = corners[j];
+            const int next_edge = src_corner_edges[corner];
+            const int dst_corner = dst_face[j];
+            dst_corner_verts[dst_corner] = edge_end_vert(next_edge, vert);
+            dst_corner_edges[dst_corner] = corner_cut_edges[corner];
+            corner_src[dst_corner] = corner;
+            corner_mix_src[dst_corner] = bke::mesh::face_corner_next(
+                src_faces[corner_to_face[corner]], corner);
+            corner_mix_factors[dst_corner] = edge_end_factor(next_edge, vert);
+          }
+          if (!closing_edge_offsets[i].is_empty()) {
+            const int last_corner = corners.last();
+            const int last_corner_prev = bke::mesh::face_corner_prev(
+                src_faces[corner_to_face[last_corner]], last_corner);
+            const int prev_edge = src_corner_edges[last_corner_prev];
+            const int closing_edge = closing_edge_offsets[i].start();
+            const int dst_corner = dst_face.last();
+            dst_corner_verts[dst_corner] = edge_end_vert(prev_edge, vert);
+            dst_corner_edges[dst_corner] = closing_edge;
+            corner_src[dst_corner] = last_corner;
+            corner_mix_src[dst_corner] = last_corner_prev;
+            corner_mix_factors[dst_corner] = edge_end_factor(prev_edge, vert);
+            dst_edges[closing_edge] = int2(dst_corner_verts[dst_corner],
+                                           dst_corner_verts[dst_face.first()]);
+          }
+          face_src[src_faces.size() + cap] = corner_to_face[corners.first()];
+        });
+      });
+
+  Set<std::string> vertex_group_names;
+  LISTBASE_FOREACH (bDeformGroup *, group, &src_mesh.vertex_group_names) {
+    vertex_group_names.add(group->name);
+  }
+  const bke::AttributeAccessor src_attributes = src_mesh.attributes();
+  threading::parallel_invoke(
+      dst_corners_num > 1024,
+      [&]() {
+        const Span<MDeformVert> src_dverts = src_mesh.deform_verts();
+        if (!vertex_group_names.is_empty() && !src_dverts.is_empty()) {
+          bke::gather_deform_verts(src_dverts, vert_src, dst_mesh->deform_verts_for_write());
+        }
+        bke::gather_attributes(src_attributes,
+                               bke::AttrDomain::Point,
+                               propagation_info,
+                               vertex_group_names,
+                               vert_src,
+                               dst_attributes);
+      },
+      [&]() {
+        /* Original edges keep their index. Like in the BMesh bevel, new edges don't copy flags
+         * like seams or sharpness from the original edges, they use the default values. */
+        for (bke::AttributeTransferData &attribute :
+             bke::retrieve_attributes_for_transfer(src_attributes,
+                                                   dst_attributes,
+                                                   ATTR_DOMAIN_MASK_EDGE,
+                                                   propagation_info,
+                                                   {".edge_verts"}))
+        {
+          GMutableSpan dst = attribute.dst.span;
+          const CPPType &type = dst.type();
+          type.copy_assign_n(attribute.src.data(), dst.data(), src_edges.size());
+          type.fill_assign_n(type.default_value(),
+                             dst.drop_front(src_edges.size()).data(),
+                             dst.size() - src_edges.size());
+          attribute.dst.finish();
+        }
+      },
+      [&]() {
+        bke::gather_attributes(
+            src_attributes, bke::AttrDomain::Face, propagation_info, {}, face_src, dst_attributes);
+      },
+      [&]() {
+        for (bke::AttributeTransferData &attribute :
+             bke::retrieve_attributes_for_transfer(src_attributes,
+                                                   dst_attributes,
+                                                   ATTR_DOMAIN_MASK_CORNER,
+                                                   propagation_info,
+                                                   {".corner_vert", ".corner_edge"}))
+        {
+          bke::attribute_math::convert_to_static_type(attribute.src.type(), [&](auto dummy) {
+            using T = decltype(dummy);
+            const Span<T> src = attribute.src.typed<T>();
+            MutableSpan<T> dst = attribute.dst.span.typed<T>();
+            threading::parallel_for(dst.index_range(), 4096, [&](const IndexRange range) {
+              for (const int i : range) {
+                if (corner_mix_src[i] == -1) {
+                  dst[i] = src[corner_src[i]];
+                }
+                else {
+                  dst[i] = bke::attribute_math::mix2(
+                      corner_mix_factors[i], src[corner_src[i]], src[corner_mix_src[i]]);
+                }
+              }
+            });
+          });
+          attribute.dst.finish();
+        }
+      });
+
+  /* Slide the new vertices along their edges. */
+  MutableSpan<float3> dst_positions = dst_mesh->vert_positions_for_write();
+  threading::parallel_for(src_edges.index_range(), 4096, [&](const IndexRange range) {
+    for (const int edge : range) {
+      const int2 src_edge = src_edges[edge];
+      for (const int side : IndexRange(2)) {
+        const int vert = src_edge[side];
+        if (beveled[vert]) {
+          dst_positions[edge_end_vert(edge, vert)] = math::interpolate(
+              src_positions[vert], src_positions[src_edge[1 - side]], edge_end_factor(edge, vert));
+        }
+      }
+    }
+  });
+
+  return dst_mesh;
+}
+
+}  // namespace blender::geometry
@@ -0,0 +1,274 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include <algorithm>
+
+#include "BLI_array_utils.hh"
+
+#include "BKE_attribute.hh"
+#include "BKE_idtype.hh"
+#include "BKE_lib_id.hh"
+#include "BKE_mesh.h"
+#include "BKE_mesh.hh"
+
+#include "GEO_mesh_bevel.hh"
+#include "GEO_mesh_primitive_cuboid.hh"
+#include "GEO_mesh_primitive_grid.hh"
+
+namespace blender::geometry::tests {
+
+class MeshBevelTest : public ::testing::Test {
+ public:
+  static void SetUpTestSuite()
+  {
+    BKE_idtype_init();
+  }
+};
+
+/** Number of faces using every edge. */
+static Array<int> count_edge_faces(const Mesh &mesh)
+{
+  Array<int> counts(mesh.edges_num, 0);
+  for (const int edge : mesh.corner_edges()) {
+    counts[edge]++;
+  }
+  return counts;
+}
+
+static int count_boundary_edges(const Mesh &mesh)
+{
+  const Array<int> counts = count_edge_faces(mesh);
+  return std::count(counts.begin(), counts.end(), 1);
+}
+
+/** Sizes of the faces added by the bevel, after the original faces. */
+static Vector<int> sorted_cap_sizes(const Mesh &mesh, const int src_faces_num)
+{
+  Vector<int> sizes;
+  for (const int face : mesh.faces().index_range().drop_front(src_faces_num)) {
+    sizes.append(mesh.faces()[face].size());
+  }
+  std::sort(sizes.begin(), sizes.end());
+  return sizes;
+}
+
+static Mesh *bevel_all_vertices(const Mesh &mesh, const float offset)
+{
+  std::optional<Mesh *> result = mesh_bevel_vertices(
+      mesh, IndexRange(mesh.verts_num), offset, true, {});
+  return result.value_or(nullptr);
+}
+
+TEST_F(MeshBevelTest, CubeIsClosed)
+{
+  Mesh *mesh = create_cuboid_mesh(float3(2.0f), 2, 2, 2);
+  Mesh *result = bevel_all_vertices(*mesh, 0.2f);
+  ASSERT_NE(result, nullptr);
+  EXPECT_TRUE(BKE_mesh_is_valid(result));
+
+  /* Every corner is cut off and closed by a triangle. */
+  EXPECT_EQ(result->verts_num, 24);
+  EXPECT_EQ(result->edges_num, 12 + 24);
+  EXPECT_EQ(result->faces_num, 6 + 8);
+  EXPECT_EQ(sorted_cap_sizes(*result, 6), Vector<int>(8, 3));
+  for (const int face : IndexRange(6)) {
+    EXPECT_EQ(result->faces()[face].size(), 8);
+  }
+  EXPECT_EQ(count_boundary_edges(*result), 0);
+  const Array<int> edge_faces = count_edge_faces(*result);
+  EXPECT_TRUE(std::all_of(edge_faces.begin(), edge_faces.end(), [](int n) { return n == 2; }));
+
+  BKE_id_free(nullptr, result);
+  BKE_id_free(nullptr, mesh);
+}
+
+TEST_F(MeshBevelTest, GridBoundary)
+{
+  /* A grid of 2x2 quads. */
+  Mesh *mesh = create_grid_mesh(3, 3, 2.0f, 2.0f, "uv_map");
+  ASSERT_EQ(mesh->faces_num, 4);
+  Mesh *result = bevel_all_vertices(*mesh, 0.25f);
+  ASSERT_NE(result, nullptr);
+  EXPECT_TRUE(BKE_mesh_is_valid(result));
+
+  /* The inner vertex is closed with a quad. Vertices in the middle of the boundary are closed
+   * with a triangle using an extra closing edge, corners of the grid are only cut. */
+  EXPECT_EQ(result->verts_num, 24);
+  EXPECT_EQ(result->edges_num, 12 + 16 + 4);
+  EXPECT_EQ(sorted_cap_sizes(*result, 4), Vector<int>({3, 3, 3, 3, 4}));
+  /* The original boundary edges, the corner cuts and the closing edges form the boundary. */
+  EXPECT_EQ(count_boundary_edges(*result), 8 + 4 + 4);
+
+  BKE_id_free(nullptr, result);
+  BKE_id_free(nullptr, mesh);
+}
+
+TEST_F(MeshBevelTest, TwoEdgeVertexSharesCut)
+{
+  /* Vertex 4 is only used by two edges, shared by two faces. */
+  Mesh *mesh = BKE_mesh_new_nomain(5, 0, 2, 8);
+  mesh->vert_positions_for_write().copy_from(
+      {{0, 0, 0}, {2, 0, 0}, {2, 2, 0}, {0, 2, 0}, {1.2f, 0.8f, 0}});
+  offset_indices::fill_constant_group_size(4, 0, mesh->face_offsets_for_write());
+  mesh->corner_verts_for_write().copy_from({0, 1, 2, 4, 0, 4, 2, 3});
+  bke::mesh_calc_edges(*mesh, false, false);
+  ASSERT_EQ(mesh->edges_num, 6);
+
+  Mesh *result = bevel_all_vertices(*mesh, 0.3f);
+  ASSERT_NE(result, nullptr);
+  EXPECT_TRUE(BKE_mesh_is_valid(result));
+  /* Both faces are cut between the same new vertices of vertex 4, which needs no new face. */
+  EXPECT_EQ(result->faces_num, 2 + 2);
+  EXPECT_EQ(sorted_cap_sizes(*result, 2), Vector<int>({3, 3}));
+  const Array<int> edge_faces = count_edge_faces(*result);
+  /* The two inner edges, the shared cut and the cuts closed by the two new faces. */
+  EXPECT_EQ(std::count(edge_faces.begin(), edge_faces.end(), 2), 2 + 1 + 2 + 2);
+
+  BKE_id_free(nullptr, result);
+  BKE_id_free(nullptr, mesh);
+}
+
+TEST_F(MeshBevelTest, NonManifoldVertexKept)
+{
+  /* Two triangles only sharing vertex 0. */
+  Mesh *mesh = BKE_mesh_new_nomain(5, 0, 2, 6);
+  mesh->vert_positions_for_write().copy_from(
+      {{0, 0, 0}, {1, 1, 0}, {1, -1, 0}, {-1, 1, 0}, {-1, -1, 0}});
+  offset_indices::fill_constant_group_size(3, 0, mesh->face_offsets_for_write());
+  mesh->corner_verts_for_write().copy_from({0, 2, 1, 0, 3, 4});
+  bke::mesh_calc_edges(*mesh, false, false);
+
+  Mesh *result = bevel_all_vertices(*mesh, 0.1f);
+  ASSERT_NE(result, nullptr);
+  EXPECT_TRUE(BKE_mesh_is_valid(result));
+
+  /* Beveling vertex 0 would leave a hole between the two fans that no face can close, so it is
+   * kept. The other vertices are only cut. */
+  EXPECT_EQ(result->faces_num, 2);
+  EXPECT_EQ(result->verts_num, 1 + 4 * 2);
+  EXPECT_EQ(result->vert_positions()[0], float3(0, 0, 0));
+  EXPECT_EQ(result->faces()[0].size(), 5);
+  EXPECT_EQ(result->faces()[1].size(), 5);
+  EXPECT_EQ(count_boundary_edges(*result), result->edges_num);
+
+  BKE_id_free(nullptr, result);
+  BKE_id_free(nullptr, mesh);
+}
+
+TEST_F(MeshBevelTest, NonManifoldEdgeKept)
+{
+  /* Three triangles sharing the edge between vertex 0 and 1. */
+  Mesh *mesh = BKE_mesh_new_nomain(5, 0, 3, 9);
+  mesh->vert_positions_for_write().copy_from(
+      {{0, 0, 0}, {1, 0, 0}, {0.5f, 1, 0}, {0.5f, -1, 0}, {0.5f, 0, 1}});
+  offset_indices::fill_constant_group_size(3, 0, mesh->face_offsets_for_write());
+  mesh->corner_verts_for_write().copy_from({0, 1, 2, 1, 0, 3, 0, 1, 4});
+  bke::mesh_calc_edges(*mesh, false, false);
+
+  Mesh *result = bevel_all_vertices(*mesh, 0.1f);
+  ASSERT_NE(result, nullptr);
+  EXPECT_TRUE(BKE_mesh_is_valid(result));
+
+  /* The ends of the non-manifold edge are kept, the other vertices are only cut. */
+  EXPECT_EQ(result->faces_num, 3);
+  EXPECT_EQ(result->verts_num, 2 + 3 * 2);
+  EXPECT_EQ(result->vert_positions()[0], float3(0, 0, 0));
+  EXPECT_EQ(result->vert_positions()[1], float3(1, 0, 0));
+  for (const int face : result->faces().index_range()) {
+    EXPECT_EQ(result->faces()[face].size(), 4);
+  }
+  const Array<int> edge_faces = count_edge_faces(*result);
+  EXPECT_EQ(std::count(edge_faces.begin(), edge_faces.end(), 3), 1);
+
+  BKE_id_free(nullptr, result);
+  BKE_id_free(nullptr, mesh);
+}
+
+TEST_F(MeshBevelTest, PointAndFaceAttributesPropagated)
+{
+  Mesh *mesh = create_cuboid_mesh(float3(2.0f), 2, 2, 2);
+  bke::MutableAttributeAccessor attributes = mesh->attributes_for_write();
+  bke::SpanAttributeWriter vert_ids = attributes.lookup_or_add_for_write_only_span<int>(
+      "vert_id", bke::AttrDomain::Point);
+  array_utils::fill_index_range<int>(vert_ids.span);
+  vert_ids.finish();
+  bke::SpanAttributeWriter face_ids = attributes.lookup_or_add_for_write_only_span<int>(
+      "face_id", bke::AttrDomain::Face);
+  array_utils::fill_index_range<int>(face_ids.span);
+  face_ids.finish();
+
+  Mesh *result = bevel_all_vertices(*mesh, 0.2f);
+  ASSERT_NE(result, nullptr);
+
+  /* Original edges keep their index, their new vertices come from the original ends. */
+  const VArraySpan<int> result_vert_ids = *result->attributes().lookup<int>("vert_id");
+  for (const int edge : mesh->edges().index_range()) {
+    EXPECT_EQ(result_vert_ids[result->edges()[edge][0]], mesh->edges()[edge][0]);
+    EXPECT_EQ(result_vert_ids[result->edges()[edge][1]], mesh->edges()[edge][1]);
+  }
+
+  /* Original faces keep their index, new faces copy a face around the beveled vertex. */
+  const VArraySpan<int> result_face_ids = *result->attributes().lookup<int>("face_id");
+  const Span<int> corner_verts = result->corner_verts();
+  for (const int face : result->faces().index_range()) {
+    if (face < mesh->faces_num) {
+      EXPECT_EQ(result_face_ids[face], face);
+      continue;
+    }
+    const int src_face = result_face_ids[face];
+    ASSERT_TRUE(IndexRange(mesh->faces_num).contains(src_face));
+    const int cap_vert = result_vert_ids[corner_verts[result->faces()[face].first()]];
+    const Span<int> src_face_verts = mesh->corner_verts().slice(mesh->faces()[src_face]);
+    EXPECT_TRUE(src_face_verts.contains(cap_vert));
+  }
+
+  BKE_id_free(nullptr, result);
+  BKE_id_free(nullptr, mesh);
+}
+
+TEST_F(MeshBevelTest, NewEdgesUseDefaultValues)
+{
+  Mesh *mesh = create_cuboid_mesh(float3(2.0f), 2, 2, 2);
+  bke::MutableAttributeAccessor attributes = mesh->attributes_for_write();
+  attributes.add<bool>("sharp_edge",
+                       bke::AttrDomain::Edge,
+                       bke::AttributeInitVArray(VArray<bool>::ForSingle(true, mesh->edges_num)));
+
+  std::optional<Mesh *> result = mesh_bevel_vertices(
+      *mesh, IndexRange(mesh->verts_num), 0.2f, true, {});
+  ASSERT_TRUE(result.has_value());
+  const VArraySpan<bool> sharp_edges = *(*result)->attributes().lookup<bool>("sharp_edge");
+  ASSERT_EQ(sharp_edges.size(), (*result)->edges_num);
+  for (const int edge : sharp_edges.index_range()) {
+    EXPECT_EQ(sharp_edges[edge], edge < mesh->edges_num);
+  }
+
+  BKE_id_free(nullptr, *result);
+  BKE_id_free(nullptr, mesh);
+}
+
+TEST_F(MeshBevelTest, CornerAttributesInterpolated)
+{
+  /* The grid UVs are a linear function of the positions, which interpolation must preserve. */
+  const float2 size(3.0f, 2.0f);
+  Mesh *mesh = create_grid_mesh(4, 3, size.x, size.y, "uv_map");
+  std::optional<Mesh *> result = mesh_bevel_vertices(
+      *mesh, IndexRange(mesh->verts_num), 0.25f, true, {});
+  ASSERT_TRUE(result.has_value());
+  const Span<float3> positions = (*result)->vert_positions();
+  const Span<int> corner_verts = (*result)->corner_verts();
+  const VArraySpan<float2> uvs = *(*result)->attributes().lookup<float2>("uv_map");
+  for (const int corner : corner_verts.index_range()) {
+    const float3 &position = positions[corner_verts[corner]];
+    EXPECT_NEAR(uvs[corner].x, position.x / size.x + 0.5f, 1e-5f);
+    EXPECT_NEAR(uvs[corner].y, position.y / size.y + 0.5f, 1e-5f);
+  }
+
+  BKE_id_free(nullptr, *result);
+  BKE_id_free(nullptr, mesh);
+}
+
+}  // namespace blender::geometry::tests
@@ -4051,23 +4051,31 @@ void IMB_colormanagement_processor_apply_pixel(ColormanageProcessor *cm_processo
   }
 }
 
-void IMB_colormanagement_processor_apply(ColormanageProcessor *cm_processor,
-                                         float *buffer,
-                                         int width,
-                                         int height,
-                                         int channels,
-                                         bool predivide)
+/**
+ * Number of image rows to process in one task, so that every task handles a reasonable amount of
+ * pixels regardless of the image width. Small buffers are processed in the calling thread, which
+ * also keeps callers that already split the image into rows from creating tiny tasks.
+ */
+static int64_t processor_apply_rows_grain_size(const int width)
 {
+  return std::max<int64_t>(1, (64 * 1024) / std::max(width, 1));
+}
+
+static void processor_apply_rows(ColormanageProcessor *cm_processor,
+                                 float *buffer,
+                                 const int width,
+                                 const blender::IndexRange rows,
+                                 const int channels,
+                                 const bool predivide)
+{
+  float *rows_buffer = buffer + size_t(channels) * width * rows.first();
+
   /* apply curve mapping */
   if (cm_processor->curve_mapping) {
-    int x, y;
-
-    for (y = 0; y < height; y++) {
-      for (x = 0; x < width; x++) {
-        float *pixel = buffer + channels * (size_t(y) * width + x);
+    for (const int64_t i : blender::IndexRange(int64_t(width) * rows.size())) {
+      float *pixel = rows_buffer + channels * i;
 
-        curve_mapping_apply_pixel(cm_processor->curve_mapping, pixel, channels);
-      }
+      curve_mapping_apply_pixel(cm_processor->curve_mapping, pixel, channels);
     }
   }
 
@@ -4075,9 +4083,9 @@ void IMB_colormanagement_processor_apply(ColormanageProcessor *cm_processor,
     OCIO_PackedImageDesc *img;
 
     /* apply OCIO processor */
-    img = OCIO_createOCIO_PackedImageDesc(buffer,
+    img = OCIO_createOCIO_PackedImageDesc(rows_buffer,
                                           width,
-                                          height,
+                                          rows.size(),
                                           channels,
                                           sizeof(float),
                                           size_t(channels) * sizeof(float),
@@ -4094,22 +4102,42 @@ void IMB_colormanagement_processor_apply(ColormanageProcessor *cm_processor,
   }
 }
 
+void IMB_colormanagement_processor_apply(ColormanageProcessor *cm_processor,
+                                         float *buffer,
+                                         int width,
+                                         int height,
+                                         int channels,
+                                         bool predivide)
+{
+  using namespace blender;
+  /* Both the curve mapping and the OCIO CPU processor are read-only once created, so rows can be
+   * processed concurrently. */
+  threading::parallel_for(
+      IndexRange(height), processor_apply_rows_grain_size(width), [&](const IndexRange rows) {
+        processor_apply_rows(cm_processor, buffer, width, rows, channels, predivide);
+      });
+}
+
 void IMB_colormanagement_processor_apply_byte(
     ColormanageProcessor *cm_processor, uchar *buffer, int width, int height, int channels)
 {
+  using namespace blender;
   /* TODO(sergey): Would be nice to support arbitrary channels configurations,
    * but for now it's not so important.
    */
   BLI_assert(channels == 4);
-  float pixel[4];
-  for (int y = 0; y < height; y++) {
-    for (int x = 0; x < width; x++) {
-      size_t offset = channels * (size_t(y) * width + x);
-      rgba_uchar_to_float(pixel, buffer + offset);
-      IMB_colormanagement_processor_apply_v4(cm_processor, pixel);
-      rgba_float_to_uchar(buffer + offset, pixel);
-    }
-  }
+  threading::parallel_for(
+      IndexRange(height), processor_apply_rows_grain_size(width), [&](const IndexRange rows) {
+        float pixel[4];
+        for (const int y : rows) {
+          for (int x = 0; x < width; x++) {
+            size_t offset = channels * (size_t(y) * width + x);
+            rgba_uchar_to_float(pixel, buffer + offset);
+            IMB_colormanagement_processor_apply_v4(cm_processor, pixel);
+            rgba_float_to_uchar(buffer + offset, pixel);
+          }
+        }
+      });
 }
 
 void IMB_colormanagement_processor_free(ColormanageProcessor *cm_processor)
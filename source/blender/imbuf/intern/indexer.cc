@@ -7,6 +7,7 @@
  */
 
 #include <cstdlib>
+#include <memory>
 
 #include "MEM_guardedalloc.h"
 
@@ -16,12 +17,15 @@
 #include "BLI_fileops.h"
 #include "BLI_ghash.h"
 #include "BLI_math_base.h"
+#include "BLI_math_base.hh"
 #include "BLI_path_util.h"
 #include "BLI_string.h"
 #include "BLI_string_utils.hh"
+#include "BLI_task.hh"
 #include "BLI_threads.h"
 #include "BLI_time.h"
 #include "BLI_utildefines.h"
+#include "BLI_vector.hh"
 
 #ifdef _WIN32
 #  include "BLI_winstuff.h"
@@ -458,14 +462,61 @@ struct proxy_output_ctx {
   AVStream *st;
   AVCodecContext *c;
   const AVCodec *codec;
-  SwsContext *sws_ctx;
-  AVFrame *frame;
+  int crf;
   int cfra;
   IMB_Proxy_Size proxy_size;
+  int orig_width;
   int orig_height;
+  AVPixelFormat orig_format;
   ImBufAnim *anim;
 };
 
+/* Encoder of one proxy size for a single segment of the source, see #IndexBuildSegment. */
+struct proxy_encoder_ctx {
+  AVCodecContext *c;
+  SwsContext *sws_ctx;
+  AVFrame *frame;
+  int frames_num;
+};
+
+static AVDictionary *proxy_codec_options_ffmpeg(const int crf)
+{
+  AVDictionary *codec_opts = nullptr;
+  /* High quality preset value. */
+  av_dict_set_int(&codec_opts, "crf", crf, 0);
+  /* Prefer smaller file-size. Presets from `veryslow` to `veryfast` produce output with very
+   * similar file-size, but there is big difference in performance.
+   * In some cases `veryfast` preset will produce smallest file-size. */
+  av_dict_set(&codec_opts, "preset", "veryfast", 0);
+  av_dict_set(&codec_opts, "tune", "fastdecode", 0);
+  return codec_opts;
+}
+
+/**
+ * Use \a thread_count threads for \a codec. Codecs with their own threading choose the number
+ * of threads themselves when they are the only ones using the system threads.
+ */
+static void codec_set_thread_count_ffmpeg(AVCodecContext *c,
+                                          const AVCodec *codec,
+                                          const int thread_count)
+{
+  if ((codec->capabilities & AV_CODEC_CAP_OTHER_THREADS) &&
+      thread_count >= BLI_system_thread_count())
+  {
+    c->thread_count = 0;
+  }
+  else {
+    c->thread_count = thread_count;
+  }
+
+  if (codec->capabilities & AV_CODEC_CAP_FRAME_THREADS) {
+    c->thread_type = FF_THREAD_FRAME;
+  }
+  else if (codec->capabilities & AV_CODEC_CAP_SLICE_THREADS) {
+    c->thread_type = FF_THREAD_SLICE;
+  }
+}
+
 static proxy_output_ctx *alloc_proxy_output_ffmpeg(
     ImBufAnim *anim, AVStream *st, IMB_Proxy_Size proxy_size, int width, int height, int quality)
 {
@@ -528,30 +579,12 @@ static proxy_output_ctx *alloc_proxy_output_ffmpeg(
    * `crf_range_max` to highest quality. */
   const int crf_range_min = 32;
   const int crf_range_max = 17;
-  int crf = round_fl_to_int((quality / 100.0f) * (crf_range_max - crf_range_min) + crf_range_min);
+  rv->crf = round_fl_to_int((quality / 100.0f) * (crf_range_max - crf_range_min) +
+                            crf_range_min);
 
-  AVDictionary *codec_opts = nullptr;
-  /* High quality preset value. */
-  av_dict_set_int(&codec_opts, "crf", crf, 0);
-  /* Prefer smaller file-size. Presets from `veryslow` to `veryfast` produce output with very
-   * similar file-size, but there is big difference in performance.
-   * In some cases `veryfast` preset will produce smallest file-size. */
-  av_dict_set(&codec_opts, "preset", "veryfast", 0);
-  av_dict_set(&codec_opts, "tune", "fastdecode", 0);
-
-  if (rv->codec->capabilities & AV_CODEC_CAP_OTHER_THREADS) {
-    rv->c->thread_count = 0;
-  }
-  else {
-    rv->c->thread_count = BLI_system_thread_count();
-  }
+  AVDictionary *codec_opts = proxy_codec_options_ffmpeg(rv->crf);
 
-  if (rv->codec->capabilities & AV_CODEC_CAP_FRAME_THREADS) {
-    rv->c->thread_type = FF_THREAD_FRAME;
-  }
-  else if (rv->codec->capabilities & AV_CODEC_CAP_SLICE_THREADS) {
-    rv->c->thread_type = FF_THREAD_SLICE;
-  }
+  codec_set_thread_count_ffmpeg(rv->c, rv->codec, BLI_system_thread_count());
 
   if (rv->of->flags & AVFMT_GLOBALHEADER) {
     rv->c->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
@@ -569,13 +602,17 @@ static proxy_output_ctx *alloc_proxy_output_ffmpeg(
             "Couldn't open IO: %s\n"
             "Proxy not built!\n",
             error_str);
+    av_dict_free(&codec_opts);
     avcodec_free_context(&rv->c);
     avformat_free_context(rv->of);
     MEM_freeN(rv);
     return nullptr;
   }
 
+  /* The encoders of the segments are opened with the same settings, make sure they work before
+   * writing anything. */
   ret = avcodec_open2(rv->c, rv->codec, &codec_opts);
+  av_dict_free(&codec_opts);
   if (ret < 0) {
     char error_str[AV_ERROR_MAX_STRING_SIZE];
     av_make_error_string(error_str, AV_ERROR_MAX_STRING_SIZE, ret);
@@ -590,38 +627,9 @@ static proxy_output_ctx *alloc_proxy_output_ffmpeg(
     return nullptr;
   }
 
+  rv->orig_width = st->codecpar->width;
   rv->orig_height = st->codecpar->height;
-
-  if (st->codecpar->width != width || st->codecpar->height != height ||
-      st->codecpar->format != rv->c->pix_fmt)
-  {
-    rv->frame = av_frame_alloc();
-
-    av_image_fill_arrays(rv->frame->data,
-                         rv->frame->linesize,
-                         static_cast<const uint8_t *>(MEM_mallocN(
-                             av_image_get_buffer_size(rv->c->pix_fmt, width, height, 1),
-                             "alloc proxy output frame")),
-                         rv->c->pix_fmt,
-                         width,
-                         height,
-                         1);
-
-    rv->frame->format = rv->c->pix_fmt;
-    rv->frame->width = width;
-    rv->frame->height = height;
-
-    rv->sws_ctx = sws_getContext(st->codecpar->width,
-                                 rv->orig_height,
-                                 AVPixelFormat(st->codecpar->format),
-                                 width,
-                                 height,
-                                 rv->c->pix_fmt,
-                                 SWS_FAST_BILINEAR | SWS_PRINT_INFO,
-                                 nullptr,
-                                 nullptr,
-                                 nullptr);
-  }
+  rv->orig_format = AVPixelFormat(st->codecpar->format);
 
   ret = avformat_write_header(rv->of, nullptr);
   if (ret < 0) {
@@ -633,10 +641,6 @@ static proxy_output_ctx *alloc_proxy_output_ffmpeg(
             "Proxy not built!\n",
             error_str);
 
-    if (rv->frame) {
-      av_frame_free(&rv->frame);
-    }
-
     avcodec_free_context(&rv->c);
     avformat_free_context(rv->of);
     MEM_freeN(rv);
@@ -646,31 +650,96 @@ static proxy_output_ctx *alloc_proxy_output_ffmpeg(
   return rv;
 }
 
-static void add_to_proxy_output_ffmpeg(proxy_output_ctx *ctx, AVFrame *frame)
+static proxy_encoder_ctx *alloc_proxy_encoder_ffmpeg(const proxy_output_ctx *ctx,
+                                                     const int thread_count)
 {
-  if (!ctx) {
-    return;
+  AVCodecContext *c = avcodec_alloc_context3(ctx->codec);
+  c->width = ctx->c->width;
+  c->height = ctx->c->height;
+  c->gop_size = ctx->c->gop_size;
+  c->max_b_frames = ctx->c->max_b_frames;
+  c->pix_fmt = ctx->c->pix_fmt;
+  c->sample_aspect_ratio = ctx->c->sample_aspect_ratio;
+  c->time_base = ctx->c->time_base;
+  c->flags = ctx->c->flags;
+  codec_set_thread_count_ffmpeg(c, ctx->codec, thread_count);
+
+  AVDictionary *codec_opts = proxy_codec_options_ffmpeg(ctx->crf);
+  const int ret = avcodec_open2(c, ctx->codec, &codec_opts);
+  av_dict_free(&codec_opts);
+  if (ret < 0) {
+    char error_str[AV_ERROR_MAX_STRING_SIZE];
+    av_make_error_string(error_str, AV_ERROR_MAX_STRING_SIZE, ret);
+    fprintf(stderr, "Couldn't open codec for '%s': %s\n", ctx->of->url, error_str);
+    avcodec_free_context(&c);
+    return nullptr;
   }
 
-  if (ctx->sws_ctx && frame &&
+  proxy_encoder_ctx *enc = MEM_cnew<proxy_encoder_ctx>("alloc_proxy_encoder");
+  enc->c = c;
+
+  if (ctx->orig_width != c->width || ctx->orig_height != c->height ||
+      ctx->orig_format != c->pix_fmt)
+  {
+    enc->frame = av_frame_alloc();
+
+    av_image_fill_arrays(enc->frame->data,
+                         enc->frame->linesize,
+                         static_cast<const uint8_t *>(MEM_mallocN(
+                             av_image_get_buffer_size(c->pix_fmt, c->width, c->height, 1),
+                             "alloc proxy output frame")),
+                         c->pix_fmt,
+                         c->width,
+                         c->height,
+                         1);
+
+    enc->frame->format = c->pix_fmt;
+    enc->frame->width = c->width;
+    enc->frame->height = c->height;
+
+    enc->sws_ctx = sws_getContext(ctx->orig_width,
+                                  ctx->orig_height,
+                                  ctx->orig_format,
+                                  c->width,
+                                  c->height,
+                                  c->pix_fmt,
+                                  SWS_FAST_BILINEAR,
+                                  nullptr,
+                                  nullptr,
+                                  nullptr);
+  }
+
+  return enc;
+}
+
+/**
+ * Encode \a frame and append the finished packets to \a r_packets. The packet timestamps start at
+ * zero for every encoder, they are offset when the packets are written to the proxy file.
+ * Passing null for \a frame flushes the encoder.
+ */
+static void add_to_proxy_encoder_ffmpeg(proxy_encoder_ctx *enc,
+                                        AVFrame *frame,
+                                        blender::Vector<AVPacket *> &r_packets)
+{
+  if (enc->sws_ctx && frame &&
       (frame->data[0] || frame->data[1] || frame->data[2] || frame->data[3]))
   {
-    sws_scale(ctx->sws_ctx,
+    sws_scale(enc->sws_ctx,
               (const uint8_t *const *)frame->data,
               frame->linesize,
               0,
-              ctx->orig_height,
-              ctx->frame->data,
-              ctx->frame->linesize);
+              frame->height,
+              enc->frame->data,
+              enc->frame->linesize);
   }
 
-  frame = ctx->sws_ctx ? (frame ? ctx->frame : nullptr) : frame;
+  frame = enc->sws_ctx ? (frame ? enc->frame : nullptr) : frame;
 
   if (frame) {
-    frame->pts = ctx->cfra++;
+    frame->pts = enc->frames_num++;
   }
 
-  int ret = avcodec_send_frame(ctx->c, frame);
+  int ret = avcodec_send_frame(enc->c, frame);
   if (ret < 0) {
     /* Can't send frame to encoder. This shouldn't happen. */
     char error_str[AV_ERROR_MAX_STRING_SIZE];
@@ -679,28 +748,56 @@ static void add_to_proxy_output_ffmpeg(proxy_output_ctx *ctx, AVFrame *frame)
     fprintf(stderr, "Can't send video frame: %s\n", error_str);
     return;
   }
-  AVPacket *packet = av_packet_alloc();
 
   while (ret >= 0) {
-    ret = avcodec_receive_packet(ctx->c, packet);
+    AVPacket *packet = av_packet_alloc();
+    ret = avcodec_receive_packet(enc->c, packet);
 
     if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
       /* No more packets to flush. */
+      av_packet_free(&packet);
       break;
     }
     if (ret < 0) {
       char error_str[AV_ERROR_MAX_STRING_SIZE];
       av_make_error_string(error_str, AV_ERROR_MAX_STRING_SIZE, ret);
 
-      fprintf(stderr,
-              "Error encoding proxy frame %d for '%s': %s\n",
-              ctx->cfra - 1,
-              ctx->of->url,
-              error_str);
+      fprintf(stderr, "Error encoding proxy frame %d: %s\n", enc->frames_num - 1, error_str);
+      av_packet_free(&packet);
       break;
     }
 
+    r_packets.append(packet);
+  }
+}
+
+static void free_proxy_encoder_ffmpeg(proxy_encoder_ctx *enc)
+{
+  if (!enc) {
+    return;
+  }
+
+  avcodec_free_context(&enc->c);
+
+  if (enc->sws_ctx) {
+    sws_freeContext(enc->sws_ctx);
+
+    MEM_freeN(enc->frame->data[0]);
+    av_free(enc->frame);
+  }
+
+  MEM_freeN(enc);
+}
+
+/* Write packets of one encoded segment, their timestamps continue after the previous segment. */
+static void write_proxy_packets_ffmpeg(proxy_output_ctx *ctx,
+                                       blender::Span<AVPacket *> packets,
+                                       const int frames_num)
+{
+  for (AVPacket *packet : packets) {
     packet->stream_index = ctx->st->index;
+    packet->pts += ctx->cfra;
+    packet->dts += ctx->cfra;
     av_packet_rescale_ts(packet, ctx->c->time_base, ctx->st->time_base);
 #  ifdef FFMPEG_USE_DURATION_WORKAROUND
     my_guess_pkt_duration(ctx->of, ctx->st, packet);
@@ -714,14 +811,14 @@ static void add_to_proxy_output_ffmpeg(proxy_output_ctx *ctx, AVFrame *frame)
       fprintf(stderr,
               "Error writing proxy frame %d "
               "into '%s': %s\n",
-              ctx->cfra - 1,
+              ctx->cfra,
               ctx->of->url,
               error_str);
       break;
     }
   }
 
-  av_packet_free(&packet);
+  ctx->cfra += frames_num;
 }
 
 static void free_proxy_output_ffmpeg(proxy_output_ctx *ctx, int rollback)
@@ -733,13 +830,6 @@ static void free_proxy_output_ffmpeg(proxy_output_ctx *ctx, int rollback)
     return;
   }
 
-  if (!rollback) {
-    /* Flush the remaining packets. */
-    add_to_proxy_output_ffmpeg(ctx, nullptr);
-  }
-
-  avcodec_flush_buffers(ctx->c);
-
   av_write_trailer(ctx->of);
 
   avcodec_free_context(&ctx->c);
@@ -751,13 +841,6 @@ static void free_proxy_output_ffmpeg(proxy_output_ctx *ctx, int rollback)
   }
   avformat_free_context(ctx->of);
 
-  if (ctx->sws_ctx) {
-    sws_freeContext(ctx->sws_ctx);
-
-    MEM_freeN(ctx->frame->data[0]);
-    av_free(ctx->frame);
-  }
-
   get_proxy_filepath(ctx->anim, ctx->proxy_size, filepath_tmp, true);
 
   if (rollback) {
@@ -790,12 +873,6 @@ struct FFmpegIndexBuilderContext : public IndexBuildContext {
   int tcs_in_use;
   int proxy_sizes_in_use;
 
-  uint64_t seek_pos;
-  uint64_t seek_pos_pts;
-  uint64_t seek_pos_dts;
-  uint64_t last_seek_pos;
-  uint64_t last_seek_pos_pts;
-  uint64_t last_seek_pos_dts;
   uint64_t start_pts;
   double frame_rate;
   double pts_time_base;
@@ -806,6 +883,71 @@ struct FFmpegIndexBuilderContext : public IndexBuildContext {
   bool building_cancelled;
 };
 
+struct IndexBuildKeyframe {
+  uint64_t pos;
+  uint64_t pts;
+  uint64_t dts;
+  int64_t timestamp;
+};
+
+/**
+ * Part of the source video stream that starts at a key-frame. Segments are decoded, scaled and
+ * encoded independently, so they can be processed in parallel. Every segment encodes the frames
+ * that are displayed between its first key-frame and the first key-frame of the next segment.
+ */
+struct IndexBuildSegment {
+  blender::Vector<AVPacket *> packets;
+  blender::Vector<IndexBuildKeyframe> keyframes;
+  /* Timestamp of the first displayed frame, the first segment also gets all frames before it. */
+  int64_t start_timestamp;
+  /* Total size of #packets in bytes. */
+  int64_t packets_size = 0;
+  /* The decoder or an encoder of the segment couldn't be created, its frames are missing. */
+  bool failed = false;
+
+  /* Index entries of the decoded frames, #anim_index_entry::frameno is set when writing. */
+  blender::Vector<anim_index_entry> entries;
+  blender::Vector<AVPacket *> proxy_packets[IMB_PROXY_MAX_SLOT];
+
+  ~IndexBuildSegment()
+  {
+    for (AVPacket *packet : packets) {
+      av_packet_free(&packet);
+    }
+    for (blender::Vector<AVPacket *> &proxy_packets_of_size : proxy_packets) {
+      for (AVPacket *packet : proxy_packets_of_size) {
+        av_packet_free(&packet);
+      }
+    }
+  }
+};
+
+/* Minimum number of packets in a segment, new segments only start at key-frames. */
+#  define INDEX_BUILD_SEGMENT_MIN_PACKETS 60
+/**
+ * Size of the packets that are kept in memory before a batch of segments is processed, even if
+ * there are fewer segments than threads. Segments of large packets start with fewer packets, so
+ * a batch still has several segments. The limit can only be exceeded by one group of pictures.
+ */
+#  define INDEX_BUILD_BATCH_MAX_BYTES (256 * 1024 * 1024)
+
+static AVCodecContext *alloc_index_decoder_ffmpeg(const AVCodec *codec,
+                                                  const AVStream *stream,
+                                                  const int thread_count)
+{
+  AVCodecContext *c = avcodec_alloc_context3(nullptr);
+  avcodec_parameters_to_context(c, stream->codecpar);
+  c->workaround_bugs = FF_BUG_AUTODETECT;
+
+  codec_set_thread_count_ffmpeg(c, codec, thread_count);
+
+  if (avcodec_open2(c, codec, nullptr) < 0) {
+    avcodec_free_context(&c);
+    return nullptr;
+  }
+  return c;
+}
+
 static IndexBuildContext *index_ffmpeg_create_context(ImBufAnim *anim,
                                                       int tcs_in_use,
                                                       int proxy_sizes_in_use,
@@ -867,27 +1009,11 @@ static IndexBuildContext *index_ffmpeg_create_context(ImBufAnim *anim,
     return nullptr;
   }
 
-  context->iCodecCtx = avcodec_alloc_context3(nullptr);
-  avcodec_parameters_to_context(context->iCodecCtx, context->iStream->codecpar);
-  context->iCodecCtx->workaround_bugs = FF_BUG_AUTODETECT;
-
-  if (context->iCodec->capabilities & AV_CODEC_CAP_OTHER_THREADS) {
-    context->iCodecCtx->thread_count = 0;
-  }
-  else {
-    context->iCodecCtx->thread_count = BLI_system_thread_count();
-  }
-
-  if (context->iCodec->capabilities & AV_CODEC_CAP_FRAME_THREADS) {
-    context->iCodecCtx->thread_type = FF_THREAD_FRAME;
-  }
-  else if (context->iCodec->capabilities & AV_CODEC_CAP_SLICE_THREADS) {
-    context->iCodecCtx->thread_type = FF_THREAD_SLICE;
-  }
+  context->iCodecCtx = alloc_index_decoder_ffmpeg(
+      context->iCodec, context->iStream, BLI_system_thread_count());
 
-  if (avcodec_open2(context->iCodecCtx, context->iCodec, nullptr) < 0) {
+  if (context->iCodecCtx == nullptr) {
     avformat_close_input(&context->iFormatCtx);
-    avcodec_free_context(&context->iCodecCtx);
     MEM_freeN(context);
     return nullptr;
   }
@@ -955,60 +1081,248 @@ static void index_rebuild_ffmpeg_finish(FFmpegIndexBuilderContext *context, cons
   MEM_freeN(context);
 }
 
-static void index_rebuild_ffmpeg_proc_decoded_frame(FFmpegIndexBuilderContext *context,
-                                                    AVPacket *curr_packet,
-                                                    AVFrame *in_frame)
+static void index_rebuild_ffmpeg_segment_proc_decoded_frame(
+    FFmpegIndexBuilderContext *context,
+    IndexBuildSegment &segment,
+    const int64_t end_timestamp,
+    proxy_encoder_ctx **encoders,
+    AVFrame *in_frame)
 {
-  int i;
-  uint64_t s_pos = context->seek_pos;
-  uint64_t s_pts = context->seek_pos_pts;
-  uint64_t s_dts = context->seek_pos_dts;
-  uint64_t pts = av_get_pts_from_frame(in_frame);
+  const int64_t pts = av_get_pts_from_frame(in_frame);
+  if ((pts < segment.start_timestamp) || (pts >= end_timestamp)) {
+    /* Frame is encoded by a neighbor segment. */
+    return;
+  }
 
-  for (i = 0; i < context->num_proxy_sizes; i++) {
-    add_to_proxy_output_ffmpeg(context->proxy_ctx[i], in_frame);
+  for (int i = 0; i < context->num_proxy_sizes; i++) {
+    if (encoders[i]) {
+      add_to_proxy_encoder_ffmpeg(encoders[i], in_frame, segment.proxy_packets[i]);
+    }
   }
 
-  if (!context->start_pts_set) {
-    context->start_pts = pts;
-    context->start_pts_set = true;
+  /* Decoding starts *always* on I-Frames. Use the last key-frame before this frame to be able
+   * to decode it properly. */
+  const IndexBuildKeyframe *keyframe = &segment.keyframes.first();
+  for (const IndexBuildKeyframe &other : segment.keyframes) {
+    if (other.timestamp <= pts) {
+      keyframe = &other;
+    }
   }
 
-  context->frameno = floor(
-      (pts - context->start_pts) * context->pts_time_base * context->frame_rate + 0.5);
+  anim_index_entry entry;
+  entry.frameno = 0;
+  entry.seek_pos = keyframe->pos;
+  entry.seek_pos_pts = keyframe->pts;
+  entry.seek_pos_dts = keyframe->dts;
+  entry.pts = pts;
+  segment.entries.append(entry);
+}
+
+/**
+ * Decode the packets of \a segment and encode its frames for every proxy size. The leading
+ * packets of \a next_segment are decoded as well, they can contain frames that are displayed
+ * before the next key-frame, which belong to this segment.
+ */
+static void index_rebuild_ffmpeg_segment(FFmpegIndexBuilderContext *context,
+                                         IndexBuildSegment &segment,
+                                         const IndexBuildSegment *next_segment,
+                                         const int thread_count,
+                                         const bool *stop)
+{
+  if (segment.keyframes.is_empty()) {
+    /* Only possible for the very first packets of broken files, nothing can be decoded. */
+    return;
+  }
 
-  int64_t seek_pos_pts = timestamp_from_pts_or_dts(context->seek_pos_pts, context->seek_pos_dts);
+  AVCodecContext *decoder = alloc_index_decoder_ffmpeg(
+      context->iCodec, context->iStream, thread_count);
+  if (decoder == nullptr) {
+    fprintf(stderr, "Couldn't open decoder for proxy segment\n");
+    segment.failed = true;
+    return;
+  }
 
-  if (pts < seek_pos_pts) {
-    /* Decoding starts *always* on I-Frames. In this case our position is
-     * before our seek I-Frame. So we need to pick the previous available
-     * I-Frame to be able to decode this one properly.
-     */
-    s_pos = context->last_seek_pos;
-    s_pts = context->last_seek_pos_pts;
-    s_dts = context->last_seek_pos_dts;
+  proxy_encoder_ctx *encoders[IMB_PROXY_MAX_SLOT] = {nullptr};
+  for (int i = 0; i < context->num_proxy_sizes; i++) {
+    if (context->proxy_ctx[i]) {
+      encoders[i] = alloc_proxy_encoder_ffmpeg(context->proxy_ctx[i], thread_count);
+      if (encoders[i] == nullptr) {
+        segment.failed = true;
+      }
+    }
   }
 
-  for (i = 0; i < tc_types.size(); i++) {
-    if (context->tcs_in_use & tc_types[i]) {
-      int tc_frameno = context->frameno;
+  if (segment.failed) {
+    for (proxy_encoder_ctx *encoder : encoders) {
+      free_proxy_encoder_ffmpeg(encoder);
+    }
+    avcodec_free_context(&decoder);
+    return;
+  }
+
+  const int64_t end_timestamp = next_segment ? next_segment->start_timestamp : INT64_MAX;
+
+  blender::Vector<AVPacket *> packets_to_decode = segment.packets;
+  if (next_segment) {
+    for (AVPacket *packet : next_segment->packets) {
+      const int64_t timestamp = timestamp_from_pts_or_dts(packet->pts, packet->dts);
+      if (packet != next_segment->packets.first() && timestamp >= end_timestamp) {
+        break;
+      }
+      packets_to_decode.append(packet);
+    }
+  }
+
+  AVFrame *in_frame = av_frame_alloc();
+
+  for (AVPacket *packet : packets_to_decode) {
+    if (*stop) {
+      break;
+    }
+
+    int ret = avcodec_send_packet(decoder, packet);
+    while (ret >= 0) {
+      ret = avcodec_receive_frame(decoder, in_frame);
+
+      if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
+        /* No more frames to flush. */
+        break;
+      }
+      if (ret < 0) {
+        char error_str[AV_ERROR_MAX_STRING_SIZE];
+        av_make_error_string(error_str, AV_ERROR_MAX_STRING_SIZE, ret);
+        fprintf(stderr, "Error decoding proxy frame: %s\n", error_str);
+        break;
+      }
+
+      index_rebuild_ffmpeg_segment_proc_decoded_frame(
+          context, segment, end_timestamp, encoders, in_frame);
+    }
+  }
+
+  /* Process pictures still stuck in decoder engine according to ffmpeg docs using
+   * nullptr packets. */
+  if (!*stop) {
+    int ret = avcodec_send_packet(decoder, nullptr);
+
+    while (ret >= 0) {
+      ret = avcodec_receive_frame(decoder, in_frame);
+
+      if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
+        /* No more frames to flush. */
+        break;
+      }
+      if (ret < 0) {
+        char error_str[AV_ERROR_MAX_STRING_SIZE];
+        av_make_error_string(error_str, AV_ERROR_MAX_STRING_SIZE, ret);
+        fprintf(stderr, "Error flushing proxy frame: %s\n", error_str);
+        break;
+      }
+      index_rebuild_ffmpeg_segment_proc_decoded_frame(
+          context, segment, end_timestamp, encoders, in_frame);
+    }
+  }
+
+  for (int i = 0; i < context->num_proxy_sizes; i++) {
+    if (encoders[i]) {
+      /* Flush the remaining packets. */
+      add_to_proxy_encoder_ffmpeg(encoders[i], nullptr, segment.proxy_packets[i]);
+      free_proxy_encoder_ffmpeg(encoders[i]);
+    }
+  }
+
+  av_frame_free(&in_frame);
+  avcodec_free_context(&decoder);
+}
+
+/* Write the encoded proxy frames and index entries of a segment, in display order. */
+static void index_rebuild_ffmpeg_write_segment(FFmpegIndexBuilderContext *context,
+                                               IndexBuildSegment &segment)
+{
+  for (int i = 0; i < context->num_proxy_sizes; i++) {
+    if (context->proxy_ctx[i]) {
+      write_proxy_packets_ffmpeg(
+          context->proxy_ctx[i], segment.proxy_packets[i], segment.entries.size());
+    }
+  }
+
+  for (const anim_index_entry &entry : segment.entries) {
+    if (!context->start_pts_set) {
+      context->start_pts = entry.pts;
+      context->start_pts_set = true;
+    }
+
+    context->frameno = floor(
+        (entry.pts - context->start_pts) * context->pts_time_base * context->frame_rate + 0.5);
 
-      if (tc_types[i] == IMB_TC_RECORD_RUN_NO_GAPS) {
-        tc_frameno = context->frameno_gapless;
+    for (int i = 0; i < tc_types.size(); i++) {
+      if (context->tcs_in_use & tc_types[i]) {
+        int tc_frameno = context->frameno;
+
+        if (tc_types[i] == IMB_TC_RECORD_RUN_NO_GAPS) {
+          tc_frameno = context->frameno_gapless;
+        }
+
+        IMB_index_builder_proc_frame(context->indexer[i],
+                                     nullptr,
+                                     0,
+                                     tc_frameno,
+                                     entry.seek_pos,
+                                     entry.seek_pos_pts,
+                                     entry.seek_pos_dts,
+                                     entry.pts);
       }
+    }
 
-      IMB_index_builder_proc_frame(context->indexer[i],
-                                   curr_packet->data,
-                                   curr_packet->size,
-                                   tc_frameno,
-                                   s_pos,
-                                   s_pts,
-                                   s_dts,
-                                   pts);
+    context->frameno_gapless++;
+  }
+}
+
+/**
+ * Encode and write all segments except the last one, which is only used to find the frames
+ * that belong to the segment before it. The written segments are removed.
+ * Building is cancelled when a segment couldn't be encoded, the proxies would miss frames.
+ */
+static void index_rebuild_ffmpeg_segments(
+    FFmpegIndexBuilderContext *context,
+    blender::Vector<std::unique_ptr<IndexBuildSegment>> &segments,
+    const bool is_last_batch,
+    const bool *stop)
+{
+  using namespace blender;
+
+  const int segments_num = is_last_batch ? segments.size() : segments.size() - 1;
+  if (segments_num <= 0) {
+    return;
+  }
+
+  /* Decoders and encoders use frame threads when there are fewer segments than threads. */
+  const int thread_count = math::max(1, BLI_system_thread_count() / segments_num);
+
+  threading::parallel_for(IndexRange(segments_num), 1, [&](const IndexRange range) {
+    for (const int i : range) {
+      const IndexBuildSegment *next_segment = i + 1 < segments.size() ? segments[i + 1].get() :
+                                                                        nullptr;
+      index_rebuild_ffmpeg_segment(context, *segments[i], next_segment, thread_count, stop);
+    }
+  });
+
+  if (*stop) {
+    return;
+  }
+
+  for (const int i : IndexRange(segments_num)) {
+    if (segments[i]->failed) {
+      fprintf(stderr, "Proxy not built!\n");
+      context->building_cancelled = true;
+      return;
     }
   }
 
-  context->frameno_gapless++;
+  for (const int i : IndexRange(segments_num)) {
+    index_rebuild_ffmpeg_write_segment(context, *segments[i]);
+  }
+  segments.remove(0, segments_num);
 }
 
 static int index_rebuild_ffmpeg(FFmpegIndexBuilderContext *context,
@@ -1016,7 +1330,8 @@ static int index_rebuild_ffmpeg(FFmpegIndexBuilderContext *context,
                                 bool *do_update,
                                 float *progress)
 {
-  AVFrame *in_frame = av_frame_alloc();
+  using namespace blender;
+
   AVPacket *next_packet = av_packet_alloc();
   uint64_t stream_size;
 
@@ -1026,6 +1341,14 @@ static int index_rebuild_ffmpeg(FFmpegIndexBuilderContext *context,
       av_guess_frame_rate(context->iFormatCtx, context->iStream, nullptr));
   context->pts_time_base = av_q2d(context->iStream->time_base);
 
+  /* The stream is only demuxed here, decoding and encoding of a batch of segments happens in
+   * parallel once there is a segment for every thread or the packets use too much memory. */
+  const int batch_size = BLI_system_thread_count();
+  const int64_t segment_max_bytes = INDEX_BUILD_BATCH_MAX_BYTES / batch_size;
+  Vector<std::unique_ptr<IndexBuildSegment>> segments;
+  segments.append(std::make_unique<IndexBuildSegment>());
+  segments.last()->start_timestamp = INT64_MIN;
+
   while (av_read_frame(context->iFormatCtx, next_packet) >= 0) {
     float next_progress =
         float(int(floor(double(next_packet->pos) * 100 / double(stream_size) + 0.5))) / 100;
@@ -1039,65 +1362,50 @@ static int index_rebuild_ffmpeg(FFmpegIndexBuilderContext *context,
       break;
     }
 
-    if (next_packet->stream_index == context->videoStream) {
-      int ret = avcodec_send_packet(context->iCodecCtx, next_packet);
-      while (ret >= 0) {
-        ret = avcodec_receive_frame(context->iCodecCtx, in_frame);
-
-        if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
-          /* No more frames to flush. */
-          break;
-        }
-        if (ret < 0) {
-          char error_str[AV_ERROR_MAX_STRING_SIZE];
-          av_make_error_string(error_str, AV_ERROR_MAX_STRING_SIZE, ret);
-          fprintf(stderr, "Error decoding proxy frame: %s\n", error_str);
-          break;
-        }
+    if (next_packet->stream_index != context->videoStream) {
+      av_packet_unref(next_packet);
+      continue;
+    }
 
-        if (next_packet->flags & AV_PKT_FLAG_KEY) {
-          context->last_seek_pos = context->seek_pos;
-          context->last_seek_pos_pts = context->seek_pos_pts;
-          context->last_seek_pos_dts = context->seek_pos_dts;
+    const int64_t timestamp = timestamp_from_pts_or_dts(next_packet->pts, next_packet->dts);
 
-          context->seek_pos = in_frame->pkt_pos;
-          context->seek_pos_pts = in_frame->pts;
-          context->seek_pos_dts = in_frame->pkt_dts;
+    if ((next_packet->flags & AV_PKT_FLAG_KEY) &&
+        (segments.last()->packets.size() >= INDEX_BUILD_SEGMENT_MIN_PACKETS ||
+         segments.last()->packets_size >= segment_max_bytes))
+    {
+      int64_t batch_bytes = 0;
+      for (const std::unique_ptr<IndexBuildSegment> &segment : segments) {
+        batch_bytes += segment->packets_size;
+      }
+      if (segments.size() > batch_size || batch_bytes >= INDEX_BUILD_BATCH_MAX_BYTES) {
+        index_rebuild_ffmpeg_segments(context, segments, false, stop);
+        if (*stop || context->building_cancelled) {
+          break;
         }
-
-        index_rebuild_ffmpeg_proc_decoded_frame(context, next_packet, in_frame);
       }
+      segments.append(std::make_unique<IndexBuildSegment>());
+      segments.last()->start_timestamp = timestamp;
+    }
+
+    IndexBuildSegment &segment = *segments.last();
+    if (next_packet->flags & AV_PKT_FLAG_KEY) {
+      IndexBuildKeyframe keyframe;
+      keyframe.pos = next_packet->pos;
+      keyframe.pts = next_packet->pts;
+      keyframe.dts = next_packet->dts;
+      keyframe.timestamp = timestamp;
+      segment.keyframes.append(keyframe);
     }
+    segment.packets.append(av_packet_clone(next_packet));
+    segment.packets_size += next_packet->size;
     av_packet_unref(next_packet);
   }
 
-  /* process pictures still stuck in decoder engine after EOF
-   * according to ffmpeg docs using nullptr packets.
-   *
-   * At least, if we haven't already stopped... */
-
-  if (!*stop) {
-    int ret = avcodec_send_packet(context->iCodecCtx, nullptr);
-
-    while (ret >= 0) {
-      ret = avcodec_receive_frame(context->iCodecCtx, in_frame);
-
-      if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
-        /* No more frames to flush. */
-        break;
-      }
-      if (ret < 0) {
-        char error_str[AV_ERROR_MAX_STRING_SIZE];
-        av_make_error_string(error_str, AV_ERROR_MAX_STRING_SIZE, ret);
-        fprintf(stderr, "Error flushing proxy frame: %s\n", error_str);
-        break;
-      }
-      index_rebuild_ffmpeg_proc_decoded_frame(context, next_packet, in_frame);
-    }
+  if (!*stop && !context->building_cancelled) {
+    index_rebuild_ffmpeg_segments(context, segments, true, stop);
   }
 
   av_packet_free(&next_packet);
-  av_free(in_frame);
 
   return 1;
 }
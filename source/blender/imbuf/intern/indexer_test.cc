@@ -0,0 +1,238 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include <cstring>
+
+#include "BLI_fileops.h"
+#include "BLI_path_util.h"
+#include "BLI_tempfile.h"
+#include "BLI_vector.hh"
+
+#include "BKE_appdir.hh"
+
+#include "IMB_imbuf.hh"
+#include "IMB_indexer.hh"
+
+#ifdef WITH_FFMPEG
+extern "C" {
+#  include <libavcodec/avcodec.h>
+#  include <libavformat/avformat.h>
+}
+#endif
+
+namespace blender::imbuf::tests {
+
+#ifdef WITH_FFMPEG
+
+/* Enough frames for several segments, which are encoded in parallel. */
+static const int frames_num = 250;
+static const int movie_width = 128;
+static const int movie_height = 96;
+
+/* Gray level of a frame, neighbor frames differ enough to notice frames in the wrong order. */
+static int frame_luma(const int frame)
+{
+  return 32 + (frame * 53) % 192;
+}
+
+/* Write a movie with flat gray frames, with B-frames and a key-frame every 12 frames. */
+static bool write_test_movie(const char *filepath)
+{
+  const AVCodec *codec = avcodec_find_encoder(AV_CODEC_ID_MPEG4);
+  if (codec == nullptr) {
+    return false;
+  }
+
+  AVFormatContext *of = nullptr;
+  if (avformat_alloc_output_context2(&of, nullptr, "avi", filepath) < 0) {
+    return false;
+  }
+  AVStream *st = avformat_new_stream(of, nullptr);
+  AVCodecContext *c = avcodec_alloc_context3(codec);
+  c->width = movie_width;
+  c->height = movie_height;
+  c->pix_fmt = AV_PIX_FMT_YUV420P;
+  c->time_base = AVRational{1, 25};
+  c->gop_size = 12;
+  c->max_b_frames = 2;
+  st->time_base = c->time_base;
+  if (of->oformat->flags & AVFMT_GLOBALHEADER) {
+    c->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+  }
+
+  bool ok = avcodec_open2(c, codec, nullptr) >= 0 &&
+            avcodec_parameters_from_context(st->codecpar, c) >= 0 &&
+            avio_open(&of->pb, filepath, AVIO_FLAG_WRITE) >= 0 &&
+            avformat_write_header(of, nullptr) >= 0;
+
+  AVFrame *frame = av_frame_alloc();
+  frame->format = c->pix_fmt;
+  frame->width = c->width;
+  frame->height = c->height;
+  ok = ok && av_frame_get_buffer(frame, 0) >= 0;
+
+  AVPacket *packet = av_packet_alloc();
+  for (int i = 0; ok && i <= frames_num; i++) {
+    AVFrame *frame_to_send = nullptr;
+    if (i < frames_num) {
+      av_frame_make_writable(frame);
+      for (int y = 0; y < c->height; y++) {
+        memset(frame->data[0] + y * frame->linesize[0], frame_luma(i), c->width);
+      }
+      for (int y = 0; y < c->height / 2; y++) {
+        memset(frame->data[1] + y * frame->linesize[1], 128, c->width / 2);
+        memset(frame->data[2] + y * frame->linesize[2], 128, c->width / 2);
+      }
+      frame->pts = i;
+      frame_to_send = frame;
+    }
+
+    /* Sending null flushes the encoder after the last frame. */
+    ok = avcodec_send_frame(c, frame_to_send) >= 0;
+    while (ok && avcodec_receive_packet(c, packet) >= 0) {
+      av_packet_rescale_ts(packet, c->time_base, st->time_base);
+      packet->stream_index = st->index;
+      ok = av_interleaved_write_frame(of, packet) >= 0;
+    }
+  }
+
+  if (of->pb) {
+    ok = av_write_trailer(of) >= 0 && ok;
+    avio_closep(&of->pb);
+  }
+  av_packet_free(&packet);
+  av_frame_free(&frame);
+  avcodec_free_context(&c);
+  avformat_free_context(of);
+  return ok;
+}
+
+/* Decode all frames of a movie and return the gray level at the center of every frame. */
+static Vector<int> read_frame_lumas(const char *filepath)
+{
+  Vector<int> lumas;
+
+  AVFormatContext *format_ctx = nullptr;
+  if (avformat_open_input(&format_ctx, filepath, nullptr, nullptr) != 0) {
+    return lumas;
+  }
+  avformat_find_stream_info(format_ctx, nullptr);
+  const int stream = av_find_best_stream(format_ctx, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+  if (stream < 0) {
+    avformat_close_input(&format_ctx);
+    return lumas;
+  }
+
+  const AVCodecParameters *codecpar = format_ctx->streams[stream]->codecpar;
+  const AVCodec *codec = avcodec_find_decoder(codecpar->codec_id);
+  AVCodecContext *c = avcodec_alloc_context3(codec);
+  avcodec_parameters_to_context(c, codecpar);
+
+  if (avcodec_open2(c, codec, nullptr) >= 0) {
+    AVPacket *packet = av_packet_alloc();
+    AVFrame *frame = av_frame_alloc();
+    auto receive_frames = [&]() {
+      while (avcodec_receive_frame(c, frame) >= 0) {
+        const uint8_t *row = frame->data[0] + (frame->height / 2) * frame->linesize[0];
+        lumas.append(row[frame->width / 2]);
+      }
+    };
+
+    while (av_read_frame(format_ctx, packet) >= 0) {
+      if (packet->stream_index == stream) {
+        avcodec_send_packet(c, packet);
+        receive_frames();
+      }
+      av_packet_unref(packet);
+    }
+    avcodec_send_packet(c, nullptr);
+    receive_frames();
+
+    av_frame_free(&frame);
+    av_packet_free(&packet);
+  }
+
+  avcodec_free_context(&c);
+  avformat_close_input(&format_ctx);
+  return lumas;
+}
+
+class IndexerTest : public ::testing::Test {
+ protected:
+  char movie_filepath[FILE_MAX];
+  char index_dir[FILE_MAX];
+
+  void SetUp() override
+  {
+    BKE_appdir_init();
+    IMB_init();
+
+    char temp_dir[FILE_MAX];
+    BLI_temp_directory_path_get(temp_dir, sizeof(temp_dir));
+    BLI_path_join(movie_filepath, sizeof(movie_filepath), temp_dir, "imbuf_indexer_test.avi");
+    BLI_path_join(index_dir, sizeof(index_dir), temp_dir, "imbuf_indexer_test_proxy");
+  }
+
+  void TearDown() override
+  {
+    if (BLI_exists(index_dir)) {
+      BLI_delete(index_dir, true, true);
+    }
+    if (BLI_exists(movie_filepath)) {
+      BLI_delete(movie_filepath, false, false);
+    }
+
+    IMB_exit();
+    BKE_appdir_exit();
+  }
+};
+
+TEST_F(IndexerTest, proxy_and_index_have_all_frames_in_order)
+{
+  ASSERT_TRUE(write_test_movie(movie_filepath));
+
+  ImBufAnim *anim = IMB_open_anim(movie_filepath, IB_rect, 0, nullptr);
+  ASSERT_NE(anim, nullptr);
+  IMB_anim_set_index_dir(anim, index_dir);
+
+  /* Loads the movie, the index can only be built for valid movies. */
+  ImBuf *ibuf = IMB_anim_absolute(anim, 0, IMB_TC_NONE, IMB_PROXY_NONE);
+  ASSERT_NE(ibuf, nullptr);
+  IMB_freeImBuf(ibuf);
+
+  IndexBuildContext *context = IMB_anim_index_rebuild_context(
+      anim, IMB_TC_RECORD_RUN, IMB_PROXY_25, 90, true, nullptr, false);
+  ASSERT_NE(context, nullptr);
+  bool stop = false;
+  bool do_update = false;
+  float progress = 0.0f;
+  IMB_anim_index_rebuild(context, &stop, &do_update, &progress);
+  IMB_anim_index_rebuild_finish(context, false);
+  IMB_free_anim(anim);
+
+  /* Every frame is encoded exactly once, in the order of the source. */
+  char proxy_filepath[FILE_MAX];
+  BLI_path_join(proxy_filepath, sizeof(proxy_filepath), index_dir, "proxy_25.avi");
+  const Vector<int> lumas = read_frame_lumas(proxy_filepath);
+  ASSERT_EQ(lumas.size(), frames_num);
+  for (const int i : lumas.index_range()) {
+    EXPECT_NEAR(lumas[i], frame_luma(i), 8) << "Frame " << i;
+  }
+
+  char index_filepath[FILE_MAX];
+  BLI_path_join(index_filepath, sizeof(index_filepath), index_dir, "record_run.blen_tc");
+  ImBufAnimIndex *index = IMB_indexer_open(index_filepath);
+  ASSERT_NE(index, nullptr);
+  EXPECT_EQ(IMB_indexer_get_duration(index), frames_num);
+  for (const int i : IndexRange(frames_num)) {
+    EXPECT_EQ(IMB_indexer_get_frame_index(index, i), i);
+  }
+  IMB_indexer_close(index);
+}
+
+#endif
+
+}  // namespace blender::imbuf::tests
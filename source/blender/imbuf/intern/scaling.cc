@@ -6,8 +6,11 @@
  * \ingroup imbuf
  */
 
+#include <algorithm>
 #include <cmath>
+#include <type_traits>
 
+#include "BLI_task.hh"
 #include "BLI_utildefines.h"
 #include "MEM_guardedalloc.h"
 
@@ -748,300 +751,245 @@ static bool q_scale_linear_interpolation(ImBuf *ibuf, int newx, int newy)
   return true;
 }
 
-static ImBuf *scaledownx(ImBuf *ibuf, int newx)
+/* -------------------------------------------------------------------- */
+/** \name Separable Scaling
+ *
+ * The image is scaled along one axis at a time. Every row (or column) is independent from the
+ * others, so they are processed in parallel. The same line functions are used for byte and float
+ * buffers, in both directions.
+ * \{ */
+
+/** Number of lines processed by one task, so each task handles a reasonable amount of pixels. */
+static int64_t scale_lines_grain_size(const int line_len)
 {
-  const bool do_rect = (ibuf->byte_buffer.data != nullptr);
-  const bool do_float = (ibuf->float_buffer.data != nullptr);
-  const size_t rect_size = IMB_get_rect_len(ibuf) * 4;
+  return std::max<int64_t>(1, (16 * 1024) / std::max(line_len, 1));
+}
 
-  uchar *rect, *_newrect, *newrect;
-  float *rectf, *_newrectf, *newrectf;
-  float sample, add, val[4], nval[4], valf[4], nvalf[4];
-  int x, y;
+/**
+ * Box filter one line of RGBA pixels down to \a new_len pixels.
+ * \param stride: Distance between pixels of the line, in elements of \a T.
+ * \param add: Number of source pixels covered by one destination pixel.
+ * \return The end of the source pixels that were read.
+ */
+template<typename T>
+static const T *scale_down_line(
+    const T *src, T *dst, const int64_t stride, const int new_len, const float add)
+{
+  float sample = 0.0f;
+  float val[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+  float nval[4];
 
-  rectf = _newrectf = newrectf = nullptr;
-  rect = _newrect = newrect = nullptr;
-  nval[0] = nval[1] = nval[2] = nval[3] = 0.0f;
-  nvalf[0] = nvalf[1] = nvalf[2] = nvalf[3] = 0.0f;
+  for (int i = 0; i < new_len; i++) {
+    for (int c = 0; c < 4; c++) {
+      nval[c] = -val[c] * sample;
+    }
 
-  if (!do_rect && !do_float) {
-    return ibuf;
-  }
+    sample += add;
 
-  if (do_rect) {
-    _newrect = static_cast<uchar *>(MEM_mallocN(sizeof(uchar[4]) * newx * ibuf->y, "scaledownx"));
-    if (_newrect == nullptr) {
-      return ibuf;
-    }
-  }
-  if (do_float) {
-    _newrectf = static_cast<float *>(
-        MEM_mallocN(sizeof(float[4]) * newx * ibuf->y, "scaledownxf"));
-    if (_newrectf == nullptr) {
-      if (_newrect) {
-        MEM_freeN(_newrect);
+    while (sample >= 1.0f) {
+      sample -= 1.0f;
+      for (int c = 0; c < 4; c++) {
+        nval[c] += src[c];
       }
-      return ibuf;
+      src += stride;
     }
-  }
 
-  add = (ibuf->x - 0.01) / newx;
-
-  if (do_rect) {
-    rect = ibuf->byte_buffer.data;
-    newrect = _newrect;
-  }
-  if (do_float) {
-    rectf = ibuf->float_buffer.data;
-    newrectf = _newrectf;
-  }
-
-  for (y = ibuf->y; y > 0; y--) {
-    sample = 0.0f;
-    val[0] = val[1] = val[2] = val[3] = 0.0f;
-    valf[0] = valf[1] = valf[2] = valf[3] = 0.0f;
+    for (int c = 0; c < 4; c++) {
+      val[c] = src[c];
+    }
+    src += stride;
 
-    for (x = newx; x > 0; x--) {
-      if (do_rect) {
-        nval[0] = -val[0] * sample;
-        nval[1] = -val[1] * sample;
-        nval[2] = -val[2] * sample;
-        nval[3] = -val[3] * sample;
+    for (int c = 0; c < 4; c++) {
+      const float value = (nval[c] + sample * val[c]) / add;
+      if constexpr (std::is_same_v<T, uchar>) {
+        dst[c] = roundf(value);
       }
-      if (do_float) {
-        nvalf[0] = -valf[0] * sample;
-        nvalf[1] = -valf[1] * sample;
-        nvalf[2] = -valf[2] * sample;
-        nvalf[3] = -valf[3] * sample;
+      else {
+        dst[c] = value;
       }
+    }
+    dst += stride;
 
-      sample += add;
+    sample -= 1.0f;
+  }
+  return src;
+}
 
-      while (sample >= 1.0f) {
-        sample -= 1.0f;
+/**
+ * Linearly interpolate one line of RGBA pixels up to \a new_len pixels. The source line must
+ * have at least two pixels.
+ * \param stride: Distance between pixels of the line, in elements of \a T.
+ * \param add: Distance in source pixels between two destination pixels.
+ */
+template<typename T>
+static void scale_up_line(
+    const T *src, T *dst, const int64_t stride, const int new_len, const float add)
+{
+  float val[4], nval[4], diff[4];
+
+  for (int c = 0; c < 4; c++) {
+    val[c] = src[c];
+    nval[c] = src[stride + c];
+    diff[c] = nval[c] - val[c];
+    if constexpr (std::is_same_v<T, uchar>) {
+      /* Round instead of truncating when converting back to bytes. */
+      val[c] += 0.5f;
+    }
+  }
+  src += 2 * stride;
 
-        if (do_rect) {
-          nval[0] += rect[0];
-          nval[1] += rect[1];
-          nval[2] += rect[2];
-          nval[3] += rect[3];
-          rect += 4;
-        }
-        if (do_float) {
-          nvalf[0] += rectf[0];
-          nvalf[1] += rectf[1];
-          nvalf[2] += rectf[2];
-          nvalf[3] += rectf[3];
-          rectf += 4;
-        }
-      }
+  float sample = 0.0f;
+  for (int i = 0; i < new_len; i++) {
+    if (sample >= 1.0f) {
+      sample -= 1.0f;
 
-      if (do_rect) {
-        val[0] = rect[0];
-        val[1] = rect[1];
-        val[2] = rect[2];
-        val[3] = rect[3];
-        rect += 4;
-
-        newrect[0] = roundf((nval[0] + sample * val[0]) / add);
-        newrect[1] = roundf((nval[1] + sample * val[1]) / add);
-        newrect[2] = roundf((nval[2] + sample * val[2]) / add);
-        newrect[3] = roundf((nval[3] + sample * val[3]) / add);
-
-        newrect += 4;
+      for (int c = 0; c < 4; c++) {
+        val[c] = nval[c];
+        nval[c] = src[c];
+        diff[c] = nval[c] - val[c];
+        if constexpr (std::is_same_v<T, uchar>) {
+          val[c] += 0.5f;
+        }
       }
-      if (do_float) {
+      src += stride;
+    }
 
-        valf[0] = rectf[0];
-        valf[1] = rectf[1];
-        valf[2] = rectf[2];
-        valf[3] = rectf[3];
-        rectf += 4;
+    for (int c = 0; c < 4; c++) {
+      dst[c] = T(val[c] + sample * diff[c]);
+    }
+    dst += stride;
 
-        newrectf[0] = ((nvalf[0] + sample * valf[0]) / add);
-        newrectf[1] = ((nvalf[1] + sample * valf[1]) / add);
-        newrectf[2] = ((nvalf[2] + sample * valf[2]) / add);
-        newrectf[3] = ((nvalf[3] + sample * valf[3]) / add);
+    sample += add;
+  }
+}
 
-        newrectf += 4;
-      }
+/**
+ * Scale all buffers of the image along one axis.
+ *
+ * \param lines_num: Number of independent lines to scale (rows or columns).
+ * \param src_line_offset, dst_line_offset: Distance between the first pixels of two lines.
+ * \param stride: Distance between two pixels within a line.
+ * \return False if the new buffers couldn't be allocated.
+ */
+template<typename ScaleLineFn>
+static bool scale_lines(ImBuf *ibuf,
+                        const int64_t new_pixels_num,
+                        const int lines_num,
+                        const int new_len,
+                        const int64_t src_line_offset,
+                        const int64_t dst_line_offset,
+                        const int64_t stride,
+                        const ScaleLineFn scale_line)
+{
+  using namespace blender;
+  uchar *new_byte = nullptr;
+  float *new_float = nullptr;
 
-      sample -= 1.0f;
+  if (ibuf->byte_buffer.data) {
+    new_byte = static_cast<uchar *>(
+        MEM_mallocN(sizeof(uchar[4]) * size_t(new_pixels_num), "scale byte lines"));
+    if (new_byte == nullptr) {
+      return false;
+    }
+  }
+  if (ibuf->float_buffer.data) {
+    new_float = static_cast<float *>(
+        MEM_mallocN(sizeof(float[4]) * size_t(new_pixels_num), "scale float lines"));
+    if (new_float == nullptr) {
+      MEM_SAFE_FREE(new_byte);
+      return false;
     }
   }
 
-  if (do_rect) {
-    // printf("%ld %ld\n", (uchar *)rect - ibuf->byte_buffer.data, rect_size);
-    BLI_assert((uchar *)rect - ibuf->byte_buffer.data == rect_size); /* see bug #26502. */
+  const uchar *src_byte = ibuf->byte_buffer.data;
+  const float *src_float = ibuf->float_buffer.data;
+  threading::parallel_for(
+      IndexRange(lines_num), scale_lines_grain_size(new_len), [&](const IndexRange lines) {
+        for (const int64_t line : lines) {
+          if (new_byte) {
+            scale_line(src_byte + line * src_line_offset,
+                       new_byte + line * dst_line_offset,
+                       stride,
+                       new_len);
+          }
+          if (new_float) {
+            scale_line(src_float + line * src_line_offset,
+                       new_float + line * dst_line_offset,
+                       stride,
+                       new_len);
+          }
+        }
+      });
 
+  if (new_byte) {
     imb_freerectImBuf(ibuf);
-    IMB_assign_byte_buffer(ibuf, _newrect, IB_TAKE_OWNERSHIP);
+    IMB_assign_byte_buffer(ibuf, new_byte, IB_TAKE_OWNERSHIP);
   }
-  if (do_float) {
-    // printf("%ld %ld\n", rectf - ibuf->float_buffer.data, rect_size);
-    BLI_assert((rectf - ibuf->float_buffer.data) == rect_size); /* see bug #26502. */
-
+  if (new_float) {
     imb_freerectfloatImBuf(ibuf);
-    IMB_assign_float_buffer(ibuf, _newrectf, IB_TAKE_OWNERSHIP);
+    IMB_assign_float_buffer(ibuf, new_float, IB_TAKE_OWNERSHIP);
   }
-
-  (void)rect_size; /* UNUSED in release builds */
-
-  ibuf->x = newx;
-  return ibuf;
+  return true;
 }
 
-static ImBuf *scaledowny(ImBuf *ibuf, int newy)
+static ImBuf *scaledownx(ImBuf *ibuf, int newx)
 {
-  const bool do_rect = (ibuf->byte_buffer.data != nullptr);
-  const bool do_float = (ibuf->float_buffer.data != nullptr);
-  const size_t rect_size = IMB_get_rect_len(ibuf) * 4;
-
-  uchar *rect, *_newrect, *newrect;
-  float *rectf, *_newrectf, *newrectf;
-  float sample, add, val[4], nval[4], valf[4], nvalf[4];
-  int x, y, skipx;
-
-  rectf = _newrectf = newrectf = nullptr;
-  rect = _newrect = newrect = nullptr;
-  nval[0] = nval[1] = nval[2] = nval[3] = 0.0f;
-  nvalf[0] = nvalf[1] = nvalf[2] = nvalf[3] = 0.0f;
-
-  if (!do_rect && !do_float) {
+  if (ibuf->byte_buffer.data == nullptr && ibuf->float_buffer.data == nullptr) {
     return ibuf;
   }
 
-  if (do_rect) {
-    _newrect = static_cast<uchar *>(MEM_mallocN(sizeof(uchar[4]) * newy * ibuf->x, "scaledowny"));
-    if (_newrect == nullptr) {
-      return ibuf;
-    }
-  }
-  if (do_float) {
-    _newrectf = static_cast<float *>(
-        MEM_mallocN(sizeof(float[4]) * newy * ibuf->x, "scaledownyf"));
-    if (_newrectf == nullptr) {
-      if (_newrect) {
-        MEM_freeN(_newrect);
-      }
-      return ibuf;
-    }
-  }
-
-  add = (ibuf->y - 0.01) / newy;
-  skipx = 4 * ibuf->x;
-
-  for (x = skipx - 4; x >= 0; x -= 4) {
-    if (do_rect) {
-      rect = ibuf->byte_buffer.data + x;
-      newrect = _newrect + x;
-    }
-    if (do_float) {
-      rectf = ibuf->float_buffer.data + x;
-      newrectf = _newrectf + x;
-    }
-
-    sample = 0.0f;
-    val[0] = val[1] = val[2] = val[3] = 0.0f;
-    valf[0] = valf[1] = valf[2] = valf[3] = 0.0f;
-
-    for (y = newy; y > 0; y--) {
-      if (do_rect) {
-        nval[0] = -val[0] * sample;
-        nval[1] = -val[1] * sample;
-        nval[2] = -val[2] * sample;
-        nval[3] = -val[3] * sample;
-      }
-      if (do_float) {
-        nvalf[0] = -valf[0] * sample;
-        nvalf[1] = -valf[1] * sample;
-        nvalf[2] = -valf[2] * sample;
-        nvalf[3] = -valf[3] * sample;
-      }
-
-      sample += add;
-
-      while (sample >= 1.0f) {
-        sample -= 1.0f;
-
-        if (do_rect) {
-          nval[0] += rect[0];
-          nval[1] += rect[1];
-          nval[2] += rect[2];
-          nval[3] += rect[3];
-          rect += skipx;
-        }
-        if (do_float) {
-          nvalf[0] += rectf[0];
-          nvalf[1] += rectf[1];
-          nvalf[2] += rectf[2];
-          nvalf[3] += rectf[3];
-          rectf += skipx;
-        }
-      }
-
-      if (do_rect) {
-        val[0] = rect[0];
-        val[1] = rect[1];
-        val[2] = rect[2];
-        val[3] = rect[3];
-        rect += skipx;
-
-        newrect[0] = roundf((nval[0] + sample * val[0]) / add);
-        newrect[1] = roundf((nval[1] + sample * val[1]) / add);
-        newrect[2] = roundf((nval[2] + sample * val[2]) / add);
-        newrect[3] = roundf((nval[3] + sample * val[3]) / add);
-
-        newrect += skipx;
-      }
-      if (do_float) {
-
-        valf[0] = rectf[0];
-        valf[1] = rectf[1];
-        valf[2] = rectf[2];
-        valf[3] = rectf[3];
-        rectf += skipx;
-
-        newrectf[0] = ((nvalf[0] + sample * valf[0]) / add);
-        newrectf[1] = ((nvalf[1] + sample * valf[1]) / add);
-        newrectf[2] = ((nvalf[2] + sample * valf[2]) / add);
-        newrectf[3] = ((nvalf[3] + sample * valf[3]) / add);
-
-        newrectf += skipx;
-      }
-
-      sample -= 1.0f;
-    }
+  const int old_len = ibuf->x;
+  const float add = (old_len - 0.01) / newx;
+  const bool success = scale_lines(
+      ibuf,
+      int64_t(newx) * ibuf->y,
+      ibuf->y,
+      newx,
+      4 * int64_t(ibuf->x),
+      4 * int64_t(newx),
+      4,
+      [&](const auto *src, auto *dst, const int64_t stride, const int new_len) {
+        const auto *src_end = scale_down_line(src, dst, stride, new_len, add);
+        BLI_assert(src_end == src + stride * old_len); /* See bug #26502. */
+        UNUSED_VARS_NDEBUG(src_end);
+      });
+
+  if (success) {
+    ibuf->x = newx;
   }
+  return ibuf;
+}
 
-  if (do_rect) {
-    // printf("%ld %ld\n", (uchar *)rect - byte_buffer.data, rect_size);
-    BLI_assert((uchar *)rect - ibuf->byte_buffer.data == rect_size); /* see bug #26502. */
-
-    imb_freerectImBuf(ibuf);
-    IMB_assign_byte_buffer(ibuf, _newrect, IB_TAKE_OWNERSHIP);
+static ImBuf *scaledowny(ImBuf *ibuf, int newy)
+{
+  if (ibuf->byte_buffer.data == nullptr && ibuf->float_buffer.data == nullptr) {
+    return ibuf;
   }
-  if (do_float) {
-    // printf("%ld %ld\n", rectf - ibuf->float_buffer.data, rect_size);
-    BLI_assert((rectf - ibuf->float_buffer.data) == rect_size); /* see bug #26502. */
 
-    imb_freerectfloatImBuf(ibuf);
-    IMB_assign_float_buffer(ibuf, _newrectf, IB_TAKE_OWNERSHIP);
+  const int old_len = ibuf->y;
+  const float add = (old_len - 0.01) / newy;
+  const bool success = scale_lines(
+      ibuf,
+      int64_t(ibuf->x) * newy,
+      ibuf->x,
+      newy,
+      4,
+      4,
+      4 * int64_t(ibuf->x),
+      [&](const auto *src, auto *dst, const int64_t stride, const int new_len) {
+        const auto *src_end = scale_down_line(src, dst, stride, new_len, add);
+        BLI_assert(src_end == src + stride * old_len); /* See bug #26502. */
+        UNUSED_VARS_NDEBUG(src_end);
+      });
+
+  if (success) {
+    ibuf->y = newy;
   }
-
-  (void)rect_size; /* UNUSED in release builds */
-
-  ibuf->y = newy;
   return ibuf;
 }
 
 static ImBuf *scaleupx(ImBuf *ibuf, int newx)
 {
-  uchar *rect, *_newrect = nullptr, *newrect;
-  float *rectf, *_newrectf = nullptr, *newrectf;
-  int x, y;
-  bool do_rect = false, do_float = false;
-
   if (ibuf == nullptr) {
     return nullptr;
   }
@@ -1049,199 +997,36 @@ static ImBuf *scaleupx(ImBuf *ibuf, int newx)
     return ibuf;
   }
 
-  if (ibuf->byte_buffer.data) {
-    do_rect = true;
-    _newrect = static_cast<uchar *>(MEM_mallocN(newx * ibuf->y * sizeof(int), "scaleupx"));
-    if (_newrect == nullptr) {
-      return ibuf;
-    }
-  }
-  if (ibuf->float_buffer.data) {
-    do_float = true;
-    _newrectf = static_cast<float *>(MEM_mallocN(sizeof(float[4]) * newx * ibuf->y, "scaleupxf"));
-    if (_newrectf == nullptr) {
-      if (_newrect) {
-        MEM_freeN(_newrect);
-      }
-      return ibuf;
-    }
-  }
-
-  rect = ibuf->byte_buffer.data;
-  rectf = ibuf->float_buffer.data;
-  newrect = _newrect;
-  newrectf = _newrectf;
-
-  /* Special case, copy all columns, needed since the scaling logic assumes there is at least
-   * two rows to interpolate between causing out of bounds read for 1px images, see #70356. */
-  if (UNLIKELY(ibuf->x == 1)) {
-    if (do_rect) {
-      for (y = ibuf->y; y > 0; y--) {
-        for (x = newx; x > 0; x--) {
-          memcpy(newrect, rect, sizeof(char[4]));
-          newrect += 4;
-        }
-        rect += 4;
-      }
-    }
-    if (do_float) {
-      for (y = ibuf->y; y > 0; y--) {
-        for (x = newx; x > 0; x--) {
-          memcpy(newrectf, rectf, sizeof(float[4]));
-          newrectf += 4;
-        }
-        rectf += 4;
-      }
-    }
-  }
-  else {
-    const float add = (ibuf->x - 1.001) / (newx - 1.0);
-    float sample;
-
-    float val_a, nval_a, diff_a;
-    float val_b, nval_b, diff_b;
-    float val_g, nval_g, diff_g;
-    float val_r, nval_r, diff_r;
-    float val_af, nval_af, diff_af;
-    float val_bf, nval_bf, diff_bf;
-    float val_gf, nval_gf, diff_gf;
-    float val_rf, nval_rf, diff_rf;
-
-    val_a = nval_a = diff_a = val_b = nval_b = diff_b = 0;
-    val_g = nval_g = diff_g = val_r = nval_r = diff_r = 0;
-    val_af = nval_af = diff_af = val_bf = nval_bf = diff_bf = 0;
-    val_gf = nval_gf = diff_gf = val_rf = nval_rf = diff_rf = 0;
-
-    for (y = ibuf->y; y > 0; y--) {
-
-      sample = 0;
-
-      if (do_rect) {
-        val_a = rect[0];
-        nval_a = rect[4];
-        diff_a = nval_a - val_a;
-        val_a += 0.5f;
-
-        val_b = rect[1];
-        nval_b = rect[5];
-        diff_b = nval_b - val_b;
-        val_b += 0.5f;
-
-        val_g = rect[2];
-        nval_g = rect[6];
-        diff_g = nval_g - val_g;
-        val_g += 0.5f;
-
-        val_r = rect[3];
-        nval_r = rect[7];
-        diff_r = nval_r - val_r;
-        val_r += 0.5f;
-
-        rect += 8;
-      }
-      if (do_float) {
-        val_af = rectf[0];
-        nval_af = rectf[4];
-        diff_af = nval_af - val_af;
-
-        val_bf = rectf[1];
-        nval_bf = rectf[5];
-        diff_bf = nval_bf - val_bf;
-
-        val_gf = rectf[2];
-        nval_gf = rectf[6];
-        diff_gf = nval_gf - val_gf;
-
-        val_rf = rectf[3];
-        nval_rf = rectf[7];
-        diff_rf = nval_rf - val_rf;
-
-        rectf += 8;
-      }
-      for (x = newx; x > 0; x--) {
-        if (sample >= 1.0f) {
-          sample -= 1.0f;
-
-          if (do_rect) {
-            val_a = nval_a;
-            nval_a = rect[0];
-            diff_a = nval_a - val_a;
-            val_a += 0.5f;
-
-            val_b = nval_b;
-            nval_b = rect[1];
-            diff_b = nval_b - val_b;
-            val_b += 0.5f;
-
-            val_g = nval_g;
-            nval_g = rect[2];
-            diff_g = nval_g - val_g;
-            val_g += 0.5f;
-
-            val_r = nval_r;
-            nval_r = rect[3];
-            diff_r = nval_r - val_r;
-            val_r += 0.5f;
-            rect += 4;
+  const float add = (ibuf->x - 1.001) / (newx - 1.0);
+  const bool success = scale_lines(
+      ibuf,
+      int64_t(newx) * ibuf->y,
+      ibuf->y,
+      newx,
+      4 * int64_t(ibuf->x),
+      4 * int64_t(newx),
+      4,
+      [&](const auto *src, auto *dst, const int64_t stride, const int new_len) {
+        /* Special case, copy all columns, needed since the scaling logic assumes there is at
+         * least two pixels to interpolate between causing out of bounds read for 1px images,
+         * see #70356. */
+        if (UNLIKELY(ibuf->x == 1)) {
+          for (int i = 0; i < new_len; i++) {
+            std::copy_n(src, 4, dst + i * stride);
           }
-          if (do_float) {
-            val_af = nval_af;
-            nval_af = rectf[0];
-            diff_af = nval_af - val_af;
-
-            val_bf = nval_bf;
-            nval_bf = rectf[1];
-            diff_bf = nval_bf - val_bf;
-
-            val_gf = nval_gf;
-            nval_gf = rectf[2];
-            diff_gf = nval_gf - val_gf;
-
-            val_rf = nval_rf;
-            nval_rf = rectf[3];
-            diff_rf = nval_rf - val_rf;
-            rectf += 4;
-          }
-        }
-        if (do_rect) {
-          newrect[0] = val_a + sample * diff_a;
-          newrect[1] = val_b + sample * diff_b;
-          newrect[2] = val_g + sample * diff_g;
-          newrect[3] = val_r + sample * diff_r;
-          newrect += 4;
-        }
-        if (do_float) {
-          newrectf[0] = val_af + sample * diff_af;
-          newrectf[1] = val_bf + sample * diff_bf;
-          newrectf[2] = val_gf + sample * diff_gf;
-          newrectf[3] = val_rf + sample * diff_rf;
-          newrectf += 4;
+          return;
         }
-        sample += add;
-      }
-    }
-  }
+        scale_up_line(src, dst, stride, new_len, add);
+      });
 
-  if (do_rect) {
-    imb_freerectImBuf(ibuf);
-    IMB_assign_byte_buffer(ibuf, _newrect, IB_TAKE_OWNERSHIP);
-  }
-  if (do_float) {
-    imb_freerectfloatImBuf(ibuf);
-    IMB_assign_float_buffer(ibuf, _newrectf, IB_TAKE_OWNERSHIP);
+  if (success) {
+    ibuf->x = newx;
   }
-
-  ibuf->x = newx;
   return ibuf;
 }
 
 static ImBuf *scaleupy(ImBuf *ibuf, int newy)
 {
-  uchar *rect, *_newrect = nullptr, *newrect;
-  float *rectf, *_newrectf = nullptr, *newrectf;
-  int x, y, skipx;
-  bool do_rect = false, do_float = false;
-
   if (ibuf == nullptr) {
     return nullptr;
   }
@@ -1249,193 +1034,36 @@ static ImBuf *scaleupy(ImBuf *ibuf, int newy)
     return ibuf;
   }
 
-  if (ibuf->byte_buffer.data) {
-    do_rect = true;
-    _newrect = static_cast<uchar *>(MEM_mallocN(ibuf->x * newy * sizeof(int), "scaleupy"));
-    if (_newrect == nullptr) {
-      return ibuf;
-    }
-  }
-  if (ibuf->float_buffer.data) {
-    do_float = true;
-    _newrectf = static_cast<float *>(MEM_mallocN(sizeof(float[4]) * ibuf->x * newy, "scaleupyf"));
-    if (_newrectf == nullptr) {
-      if (_newrect) {
-        MEM_freeN(_newrect);
-      }
-      return ibuf;
-    }
-  }
-
-  rect = ibuf->byte_buffer.data;
-  rectf = ibuf->float_buffer.data;
-  newrect = _newrect;
-  newrectf = _newrectf;
-
-  skipx = 4 * ibuf->x;
-
-  /* Special case, copy all rows, needed since the scaling logic assumes there is at least
-   * two rows to interpolate between causing out of bounds read for 1px images, see #70356. */
-  if (UNLIKELY(ibuf->y == 1)) {
-    if (do_rect) {
-      for (y = newy; y > 0; y--) {
-        memcpy(newrect, rect, sizeof(char) * skipx);
-        newrect += skipx;
-      }
-    }
-    if (do_float) {
-      for (y = newy; y > 0; y--) {
-        memcpy(newrectf, rectf, sizeof(float) * skipx);
-        newrectf += skipx;
-      }
-    }
-  }
-  else {
-    const float add = (ibuf->y - 1.001) / (newy - 1.0);
-    float sample;
-
-    float val_a, nval_a, diff_a;
-    float val_b, nval_b, diff_b;
-    float val_g, nval_g, diff_g;
-    float val_r, nval_r, diff_r;
-    float val_af, nval_af, diff_af;
-    float val_bf, nval_bf, diff_bf;
-    float val_gf, nval_gf, diff_gf;
-    float val_rf, nval_rf, diff_rf;
-
-    val_a = nval_a = diff_a = val_b = nval_b = diff_b = 0;
-    val_g = nval_g = diff_g = val_r = nval_r = diff_r = 0;
-    val_af = nval_af = diff_af = val_bf = nval_bf = diff_bf = 0;
-    val_gf = nval_gf = diff_gf = val_rf = nval_rf = diff_rf = 0;
-
-    for (x = ibuf->x; x > 0; x--) {
-      sample = 0;
-      if (do_rect) {
-        rect = ibuf->byte_buffer.data + 4 * (x - 1);
-        newrect = _newrect + 4 * (x - 1);
-
-        val_a = rect[0];
-        nval_a = rect[skipx];
-        diff_a = nval_a - val_a;
-        val_a += 0.5f;
-
-        val_b = rect[1];
-        nval_b = rect[skipx + 1];
-        diff_b = nval_b - val_b;
-        val_b += 0.5f;
-
-        val_g = rect[2];
-        nval_g = rect[skipx + 2];
-        diff_g = nval_g - val_g;
-        val_g += 0.5f;
-
-        val_r = rect[3];
-        nval_r = rect[skipx + 3];
-        diff_r = nval_r - val_r;
-        val_r += 0.5f;
-
-        rect += 2 * skipx;
-      }
-      if (do_float) {
-        rectf = ibuf->float_buffer.data + 4 * (x - 1);
-        newrectf = _newrectf + 4 * (x - 1);
-
-        val_af = rectf[0];
-        nval_af = rectf[skipx];
-        diff_af = nval_af - val_af;
-
-        val_bf = rectf[1];
-        nval_bf = rectf[skipx + 1];
-        diff_bf = nval_bf - val_bf;
-
-        val_gf = rectf[2];
-        nval_gf = rectf[skipx + 2];
-        diff_gf = nval_gf - val_gf;
-
-        val_rf = rectf[3];
-        nval_rf = rectf[skipx + 3];
-        diff_rf = nval_rf - val_rf;
-
-        rectf += 2 * skipx;
-      }
-
-      for (y = newy; y > 0; y--) {
-        if (sample >= 1.0f) {
-          sample -= 1.0f;
-
-          if (do_rect) {
-            val_a = nval_a;
-            nval_a = rect[0];
-            diff_a = nval_a - val_a;
-            val_a += 0.5f;
-
-            val_b = nval_b;
-            nval_b = rect[1];
-            diff_b = nval_b - val_b;
-            val_b += 0.5f;
-
-            val_g = nval_g;
-            nval_g = rect[2];
-            diff_g = nval_g - val_g;
-            val_g += 0.5f;
-
-            val_r = nval_r;
-            nval_r = rect[3];
-            diff_r = nval_r - val_r;
-            val_r += 0.5f;
-            rect += skipx;
+  const float add = (ibuf->y - 1.001) / (newy - 1.0);
+  const bool success = scale_lines(
+      ibuf,
+      int64_t(ibuf->x) * newy,
+      ibuf->x,
+      newy,
+      4,
+      4,
+      4 * int64_t(ibuf->x),
+      [&](const auto *src, auto *dst, const int64_t stride, const int new_len) {
+        /* Special case, copy all rows, needed since the scaling logic assumes there is at least
+         * two pixels to interpolate between causing out of bounds read for 1px images,
+         * see #70356. */
+        if (UNLIKELY(ibuf->y == 1)) {
+          for (int i = 0; i < new_len; i++) {
+            std::copy_n(src, 4, dst + i * stride);
           }
-          if (do_float) {
-            val_af = nval_af;
-            nval_af = rectf[0];
-            diff_af = nval_af - val_af;
-
-            val_bf = nval_bf;
-            nval_bf = rectf[1];
-            diff_bf = nval_bf - val_bf;
-
-            val_gf = nval_gf;
-            nval_gf = rectf[2];
-            diff_gf = nval_gf - val_gf;
-
-            val_rf = nval_rf;
-            nval_rf = rectf[3];
-            diff_rf = nval_rf - val_rf;
-            rectf += skipx;
-          }
-        }
-        if (do_rect) {
-          newrect[0] = val_a + sample * diff_a;
-          newrect[1] = val_b + sample * diff_b;
-          newrect[2] = val_g + sample * diff_g;
-          newrect[3] = val_r + sample * diff_r;
-          newrect += skipx;
+          return;
         }
-        if (do_float) {
-          newrectf[0] = val_af + sample * diff_af;
-          newrectf[1] = val_bf + sample * diff_bf;
-          newrectf[2] = val_gf + sample * diff_gf;
-          newrectf[3] = val_rf + sample * diff_rf;
-          newrectf += skipx;
-        }
-        sample += add;
-      }
-    }
-  }
+        scale_up_line(src, dst, stride, new_len, add);
+      });
 
-  if (do_rect) {
-    imb_freerectImBuf(ibuf);
-    IMB_assign_byte_buffer(ibuf, _newrect, IB_TAKE_OWNERSHIP);
-  }
-  if (do_float) {
-    imb_freerectfloatImBuf(ibuf);
-    IMB_assign_float_buffer(ibuf, _newrectf, IB_TAKE_OWNERSHIP);
+  if (success) {
+    ibuf->y = newy;
   }
-
-  ibuf->y = newy;
   return ibuf;
 }
 
+/** \} */
+
 bool IMB_scaleImBuf(ImBuf *ibuf, uint newx, uint newy)
 {
   BLI_assert_msg(newx > 0 && newy > 0, "Images must be at least 1 on both dimensions!");
@@ -7,6 +7,8 @@
  * \ingroup imbuf
  */
 
+#include <algorithm>
+#include <cmath>
 #include <type_traits>
 
 #include "BLI_math_color_blend.h"
@@ -98,6 +100,47 @@ static bool should_discard(const TransformContext &ctx, const float2 &uv)
          uv.y >= ctx.src_crop.ymax;
 }
 
+/**
+ * Range of destination pixels on the scanline starting at \a uv_row whose sample position can be
+ * inside the source crop rectangle. The sample position is an affine function of the pixel index,
+ * so this is a single interval per scanline. It is computed conservatively (padded by a couple of
+ * pixels and by the floating point error of the position), pixels near its ends still go through
+ * #should_discard.
+ */
+static IndexRange crop_scanline_range(const TransformContext &ctx, const float2 &uv_row)
+{
+  float x_begin = ctx.dst_region_x_range.first();
+  float x_end = ctx.dst_region_x_range.one_after_last();
+  const float2 crop_min(ctx.src_crop.xmin, ctx.src_crop.ymin);
+  const float2 crop_max(ctx.src_crop.xmax, ctx.src_crop.ymax);
+  for (const int axis : IndexRange(2)) {
+    const float start = uv_row[axis];
+    const float step = ctx.add_x[axis];
+    if (step == 0.0f) {
+      if (start < crop_min[axis] || start >= crop_max[axis]) {
+        return {};
+      }
+      continue;
+    }
+    float t_min = (crop_min[axis] - start) / step;
+    float t_max = (crop_max[axis] - start) / step;
+    if (step < 0.0f) {
+      std::swap(t_min, t_max);
+    }
+    const float max_value = std::max({std::abs(start),
+                                      std::abs(crop_min[axis]),
+                                      std::abs(crop_max[axis]),
+                                      std::abs(step * x_end)});
+    const float margin = 2.0f + max_value * 1e-5f / std::abs(step);
+    x_begin = std::max(x_begin, std::floor(t_min - margin));
+    x_end = std::min(x_end, std::ceil(t_max + margin));
+  }
+  if (!(x_begin < x_end)) {
+    return {};
+  }
+  return IndexRange::from_begin_end(int(x_begin), int(x_end));
+}
+
 template<typename T> static T *init_pixel_pointer(const ImBuf *image, int x, int y);
 template<> uchar *init_pixel_pointer(const ImBuf *image, int x, int y)
 {
@@ -301,9 +344,16 @@ static void process_scanlines(const TransformContext &ctx, IndexRange y_range)
      * NOTE: sample at pixel center for proper filtering. */
     float2 uv_start = ctx.start_uv + ctx.add_x * 0.5f + ctx.add_y * 0.5f;
     for (int yi : y_range) {
-      T *output = init_pixel_pointer<T>(ctx.dst, ctx.dst_region_x_range.first(), yi);
       float2 uv_row = uv_start + yi * ctx.add_y;
-      for (int xi : ctx.dst_region_x_range) {
+      /* When cropping, pixels that map outside of the crop rectangle are left untouched, so only
+       * visit the part of the scanline that can map inside of it. */
+      const IndexRange x_range = CropSource ? crop_scanline_range(ctx, uv_row) :
+                                              ctx.dst_region_x_range;
+      if (x_range.is_empty()) {
+        continue;
+      }
+      T *output = init_pixel_pointer<T>(ctx.dst, x_range.first(), yi);
+      for (int xi : x_range) {
         float2 uv = uv_row + xi * ctx.add_x;
         if (!CropSource || !should_discard(ctx, uv)) {
           T sample[4];
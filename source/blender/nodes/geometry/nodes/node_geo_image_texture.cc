@@ -45,6 +45,23 @@ static void node_init(bNodeTree * /*tree*/, bNode *node)
   node->storage = tex;
 }
 
+/**
+ * Pixel access for the sampling functions. Byte images in color spaces that are converted to scene
+ * linear per channel are read directly from the byte buffer with a lookup table. That avoids
+ * allocating a float copy of the image, which is four times larger and stays around as long as
+ * the image buffer does.
+ */
+struct ImagePixels {
+  int width = 0;
+  int height = 0;
+  const float4 *float_data = nullptr;
+  const uchar4 *byte_data = nullptr;
+  /** Scene linear value of every byte value of the color channels. */
+  std::array<float, 256> byte_to_linear;
+  /** Match the alpha conversion done by #IMB_float_from_rect. */
+  bool premultiply = false;
+};
+
 class ImageFieldsFunction : public mf::MultiFunction {
  private:
   const int8_t interpolation_;
@@ -53,6 +70,7 @@ class ImageFieldsFunction : public mf::MultiFunction {
   ImageUser image_user_;
   void *image_lock_;
   ImBuf *image_buffer_;
+  ImagePixels pixels_;
 
  public:
   ImageFieldsFunction(const int8_t interpolation,
@@ -79,6 +97,23 @@ class ImageFieldsFunction : public mf::MultiFunction {
       throw std::runtime_error("cannot acquire image buffer");
     }
 
+    pixels_.width = image_buffer_->x;
+    pixels_.height = image_buffer_->y;
+
+    if (image_buffer_->float_buffer.data == nullptr && image_buffer_->byte_buffer.data &&
+        byte_buffer_is_per_channel(*image_buffer_))
+    {
+      pixels_.byte_data = reinterpret_cast<const uchar4 *>(image_buffer_->byte_buffer.data);
+      for (const int i : IndexRange(256)) {
+        float4 value(float(i) * (1.0f / 255.0f));
+        IMB_colormanagement_colorspace_to_scene_linear(
+            value, 1, 1, 4, image_buffer_->byte_buffer.colorspace, false);
+        pixels_.byte_to_linear[i] = value.x;
+      }
+      pixels_.premultiply = IMB_alpha_affects_rgb(image_buffer_);
+      return;
+    }
+
     if (image_buffer_->float_buffer.data == nullptr) {
       BLI_thread_lock(LOCK_IMAGE);
       if (!image_buffer_->float_buffer.data) {
@@ -91,6 +126,7 @@ class ImageFieldsFunction : public mf::MultiFunction {
       BKE_image_release_ibuf(&image_, image_buffer_, image_lock_);
       throw std::runtime_error("cannot get float buffer");
     }
+    pixels_.float_data = reinterpret_cast<const float4 *>(image_buffer_->float_buffer.data);
   }
 
   ~ImageFieldsFunction() override
@@ -98,6 +134,21 @@ class ImageFieldsFunction : public mf::MultiFunction {
     BKE_image_release_ibuf(&image_, image_buffer_, image_lock_);
   }
 
+  /**
+   * Whether the byte buffer's color space converts to scene linear with the same curve on every
+   * channel, so the conversion can be done with a lookup table while sampling.
+   */
+  static bool byte_buffer_is_per_channel(const ImBuf &ibuf)
+  {
+    ColorSpace *colorspace = ibuf.byte_buffer.colorspace;
+    if (colorspace == nullptr) {
+      return false;
+    }
+    return IMB_colormanagement_space_is_data(colorspace) ||
+           IMB_colormanagement_space_is_srgb(colorspace) ||
+           IMB_colormanagement_space_is_scene_linear(colorspace);
+  }
+
   static int wrap_periodic(int x, const int width)
   {
     x %= width;
@@ -121,12 +172,21 @@ class ImageFieldsFunction : public mf::MultiFunction {
     return m;
   }
 
-  static float4 image_pixel_lookup(const ImBuf &ibuf, const int px, const int py)
+  static float4 image_pixel_lookup(const ImagePixels &pixels, const int px, const int py)
   {
-    if (px < 0 || py < 0 || px >= ibuf.x || py >= ibuf.y) {
+    if (px < 0 || py < 0 || px >= pixels.width || py >= pixels.height) {
       return float4(0.0f, 0.0f, 0.0f, 0.0f);
     }
-    return ((const float4 *)ibuf.float_buffer.data)[px + py * ibuf.x];
+    const int64_t index = px + int64_t(py) * pixels.width;
+    if (pixels.float_data) {
+      return pixels.float_data[index];
+    }
+    const uchar4 &byte = pixels.byte_data[index];
+    const float alpha = float(byte.w) * (1.0f / 255.0f);
+    const float3 color(pixels.byte_to_linear[byte.x],
+                       pixels.byte_to_linear[byte.y],
+                       pixels.byte_to_linear[byte.z]);
+    return float4(pixels.premultiply ? color * alpha : color, alpha);
   }
 
   static float frac(const float x, int *ix)
@@ -136,13 +196,13 @@ class ImageFieldsFunction : public mf::MultiFunction {
     return x - float(i);
   }
 
-  static float4 image_cubic_texture_lookup(const ImBuf &ibuf,
+  static float4 image_cubic_texture_lookup(const ImagePixels &pixels,
                                            const float px,
                                            const float py,
                                            const int extension)
   {
-    const int width = ibuf.x;
-    const int height = ibuf.y;
+    const int width = pixels.width;
+    const int height = pixels.height;
     int pix, piy, nix, niy;
     const float tx = frac(px * float(width) - 0.5f, &pix);
     const float ty = frac(py * float(height) - 0.5f, &piy);
@@ -209,31 +269,31 @@ class ImageFieldsFunction : public mf::MultiFunction {
     v[2] = ((-0.5f * ty + 0.5f) * ty + 0.5f) * ty + (1.0f / 6.0f);
     v[3] = (1.0f / 6.0f) * ty * ty * ty;
 
-    return (v[0] * (u[0] * image_pixel_lookup(ibuf, xc[0], yc[0]) +
-                    u[1] * image_pixel_lookup(ibuf, xc[1], yc[0]) +
-                    u[2] * image_pixel_lookup(ibuf, xc[2], yc[0]) +
-                    u[3] * image_pixel_lookup(ibuf, xc[3], yc[0]))) +
-           (v[1] * (u[0] * image_pixel_lookup(ibuf, xc[0], yc[1]) +
-                    u[1] * image_pixel_lookup(ibuf, xc[1], yc[1]) +
-                    u[2] * image_pixel_lookup(ibuf, xc[2], yc[1]) +
-                    u[3] * image_pixel_lookup(ibuf, xc[3], yc[1]))) +
-           (v[2] * (u[0] * image_pixel_lookup(ibuf, xc[0], yc[2]) +
-                    u[1] * image_pixel_lookup(ibuf, xc[1], yc[2]) +
-                    u[2] * image_pixel_lookup(ibuf, xc[2], yc[2]) +
-                    u[3] * image_pixel_lookup(ibuf, xc[3], yc[2]))) +
-           (v[3] * (u[0] * image_pixel_lookup(ibuf, xc[0], yc[3]) +
-                    u[1] * image_pixel_lookup(ibuf, xc[1], yc[3]) +
-                    u[2] * image_pixel_lookup(ibuf, xc[2], yc[3]) +
-                    u[3] * image_pixel_lookup(ibuf, xc[3], yc[3])));
+    return (v[0] * (u[0] * image_pixel_lookup(pixels, xc[0], yc[0]) +
+                    u[1] * image_pixel_lookup(pixels, xc[1], yc[0]) +
+                    u[2] * image_pixel_lookup(pixels, xc[2], yc[0]) +
+                    u[3] * image_pixel_lookup(pixels, xc[3], yc[0]))) +
+           (v[1] * (u[0] * image_pixel_lookup(pixels, xc[0], yc[1]) +
+                    u[1] * image_pixel_lookup(pixels, xc[1], yc[1]) +
+                    u[2] * image_pixel_lookup(pixels, xc[2], yc[1]) +
+                    u[3] * image_pixel_lookup(pixels, xc[3], yc[1]))) +
+           (v[2] * (u[0] * image_pixel_lookup(pixels, xc[0], yc[2]) +
+                    u[1] * image_pixel_lookup(pixels, xc[1], yc[2]) +
+                    u[2] * image_pixel_lookup(pixels, xc[2], yc[2]) +
+                    u[3] * image_pixel_lookup(pixels, xc[3], yc[2]))) +
+           (v[3] * (u[0] * image_pixel_lookup(pixels, xc[0], yc[3]) +
+                    u[1] * image_pixel_lookup(pixels, xc[1], yc[3]) +
+                    u[2] * image_pixel_lookup(pixels, xc[2], yc[3]) +
+                    u[3] * image_pixel_lookup(pixels, xc[3], yc[3])));
   }
 
-  static float4 image_linear_texture_lookup(const ImBuf &ibuf,
+  static float4 image_linear_texture_lookup(const ImagePixels &pixels,
                                             const float px,
                                             const float py,
                                             const int8_t extension)
   {
-    const int width = ibuf.x;
-    const int height = ibuf.y;
+    const int width = pixels.width;
+    const int height = pixels.height;
     int pix, piy, nix, niy;
     const float nfx = frac(px * float(width) - 0.5f, &pix);
     const float nfy = frac(py * float(height) - 0.5f, &piy);
@@ -269,19 +329,19 @@ class ImageFieldsFunction : public mf::MultiFunction {
     const float ptx = 1.0f - nfx;
     const float pty = 1.0f - nfy;
 
-    return image_pixel_lookup(ibuf, pix, piy) * ptx * pty +
-           image_pixel_lookup(ibuf, nix, piy) * nfx * pty +
-           image_pixel_lookup(ibuf, pix, niy) * ptx * nfy +
-           image_pixel_lookup(ibuf, nix, niy) * nfx * nfy;
+    return image_pixel_lookup(pixels, pix, piy) * ptx * pty +
+           image_pixel_lookup(pixels, nix, piy) * nfx * pty +
+           image_pixel_lookup(pixels, pix, niy) * ptx * nfy +
+           image_pixel_lookup(pixels, nix, niy) * nfx * nfy;
   }
 
-  static float4 image_closest_texture_lookup(const ImBuf &ibuf,
+  static float4 image_closest_texture_lookup(const ImagePixels &pixels,
                                              const float px,
                                              const float py,
                                              const int extension)
   {
-    const int width = ibuf.x;
-    const int height = ibuf.y;
+    const int width = pixels.width;
+    const int height = pixels.height;
     int ix, iy;
     const float tx = frac(px * float(width), &ix);
     const float ty = frac(py * float(height), &iy);
@@ -290,7 +350,7 @@ class ImageFieldsFunction : public mf::MultiFunction {
       case SHD_IMAGE_EXTENSION_REPEAT: {
         ix = wrap_periodic(ix, width);
         iy = wrap_periodic(iy, height);
-        return image_pixel_lookup(ibuf, ix, iy);
+        return image_pixel_lookup(pixels, ix, iy);
       }
       case SHD_IMAGE_EXTENSION_CLIP: {
         if (tx < 0.0f || ty < 0.0f || tx > 1.0f || ty > 1.0f) {
@@ -304,12 +364,12 @@ class ImageFieldsFunction : public mf::MultiFunction {
       case SHD_IMAGE_EXTENSION_EXTEND: {
         ix = wrap_clamp(ix, width);
         iy = wrap_clamp(iy, height);
-        return image_pixel_lookup(ibuf, ix, iy);
+        return image_pixel_lookup(pixels, ix, iy);
       }
       case SHD_IMAGE_EXTENSION_MIRROR: {
         ix = wrap_mirror(ix, width);
         iy = wrap_mirror(iy, height);
-        return image_pixel_lookup(ibuf, ix, iy);
+        return image_pixel_lookup(pixels, ix, iy);
       }
       default:
         return float4(0.0f, 0.0f, 0.0f, 0.0f);
@@ -330,20 +390,20 @@ class ImageFieldsFunction : public mf::MultiFunction {
       case SHD_INTERP_LINEAR:
         mask.foreach_index([&](const int64_t i) {
           const float3 p = vectors[i];
-          color_data[i] = image_linear_texture_lookup(*image_buffer_, p.x, p.y, extension_);
+          color_data[i] = image_linear_texture_lookup(pixels_, p.x, p.y, extension_);
         });
         break;
       case SHD_INTERP_CLOSEST:
         mask.foreach_index([&](const int64_t i) {
           const float3 p = vectors[i];
-          color_data[i] = image_closest_texture_lookup(*image_buffer_, p.x, p.y, extension_);
+          color_data[i] = image_closest_texture_lookup(pixels_, p.x, p.y, extension_);
         });
         break;
       case SHD_INTERP_CUBIC:
       case SHD_INTERP_SMART:
         mask.foreach_index([&](const int64_t i) {
           const float3 p = vectors[i];
-          color_data[i] = image_cubic_texture_lookup(*image_buffer_, p.x, p.y, extension_);
+          color_data[i] = image_cubic_texture_lookup(pixels_, p.x, p.y, extension_);
         });
         break;
     }
@@ -21,9 +21,16 @@ struct Sequence;
 struct StripElem;
 struct rctf;
 
+/** Maximum number of frames that prefetching renders at the same time. */
+#define SEQ_PREFETCH_TASKS_NUM 4
+
 enum eSeqTaskId {
   SEQ_TASK_MAIN_RENDER,
+  /**
+   * Every frame that prefetching renders at the same time uses its own ID, this is the first one.
+   */
   SEQ_TASK_PREFETCH_RENDER,
+  SEQ_TASK_NUM = SEQ_TASK_PREFETCH_RENDER + SEQ_PREFETCH_TASKS_NUM,
 };
 
 struct SeqRenderData {
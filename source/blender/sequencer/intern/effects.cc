@@ -871,14 +871,13 @@ static void do_mul_effect(const SeqRenderData *context,
 /* blend_function has to be: void (T* dst, const T *src1, const T *src2) */
 template<typename T, typename Func>
 static void apply_blend_function(
-    float fac, int width, int height, const T *src1, T *src2, T *dst, Func blend_function)
+    float fac, int width, int height, const T *src1, const T *src2, T *dst, Func blend_function)
 {
   for (int y = 0; y < height; y++) {
     for (int x = 0; x < width; x++) {
-      T achannel = src2[3];
-      src2[3] = T(achannel * fac);
-      blend_function(dst, src1, src2);
-      src2[3] = achannel;
+      /* Scale the alpha of a copy, the input can be read by other threads at the same time. */
+      const T src2_fac[4] = {src2[0], src2[1], src2[2], T(src2[3] * fac)};
+      blend_function(dst, src1, src2_fac);
       dst[3] = src1[3];
       src1 += 4;
       src2 += 4;
@@ -888,7 +887,7 @@ static void apply_blend_function(
 }
 
 static void do_blend_effect_float(
-    float fac, int x, int y, const float *rect1, float *rect2, int btype, float *out)
+    float fac, int x, int y, const float *rect1, const float *rect2, int btype, float *out)
 {
   switch (btype) {
     case SEQ_TYPE_ADD:
@@ -960,7 +959,7 @@ static void do_blend_effect_float(
 }
 
 static void do_blend_effect_byte(
-    float fac, int x, int y, uchar *rect1, uchar *rect2, int btype, uchar *out)
+    float fac, int x, int y, const uchar *rect1, const uchar *rect2, int btype, uchar *out)
 {
   switch (btype) {
     case SEQ_TYPE_ADD:
@@ -1718,21 +1717,26 @@ static void glow_blur_bitmap(
     }
   });
 
-  /* Blur the columns: read temp, write map */
-  threading::parallel_for(IndexRange(width), 32, [&](const IndexRange x_range) {
+  /* Blur the columns: read temp, write map. Whole rows are accumulated at once to read the
+   * image in memory order, every pixel still sums its samples in the same order. */
+  threading::parallel_for(IndexRange(height), 32, [&](const IndexRange y_range) {
     const float4 one = float4(1.0f);
-    for (const int x : x_range) {
-      for (int y = 0; y < height; y++) {
-        float4 curColor = float4(0.0f);
-        int ymin = math::max(y - halfWidth, 0);
-        int ymax = math::min(y + halfWidth, height);
-        for (int ny = ymin, index = (ymin - y) + halfWidth; ny < ymax; ny++, index++) {
-          curColor += temp[x + ny * width] * filter[index];
+    for (const int y : y_range) {
+      MutableSpan<float4> row(map + y * width, width);
+      row.fill(float4(0.0f));
+      int ymin = math::max(y - halfWidth, 0);
+      int ymax = math::min(y + halfWidth, height);
+      for (int ny = ymin, index = (ymin - y) + halfWidth; ny < ymax; ny++, index++) {
+        const float4 *temp_row = &temp[ny * width];
+        const float weight = filter[index];
+        for (int x = 0; x < width; x++) {
+          row[x] += temp_row[x] * weight;
         }
-        if (src != nullptr) {
-          curColor = math::min(one, src[x + y * width] + curColor);
+      }
+      if (src != nullptr) {
+        for (int x = 0; x < width; x++) {
+          row[x] = math::min(one, src[x + y * width] + row[x]);
         }
-        map[x + y * width] = curColor;
       }
     }
   });
@@ -2413,13 +2417,34 @@ static Array<float> make_gaussian_blur_kernel(float rad, int size)
   return gaussian;
 }
 
+/**
+ * Sum of the kernel weights that are inside of the image for every pixel along a line of
+ * \a size pixels. The kernel is only cut off at the borders, so this is the same for every line.
+ */
+static Array<float> gaussian_blur_weights_sum(const Span<float> gaussian,
+                                              int half_size,
+                                              int size)
+{
+  Array<float> weights_sum(size);
+  for (int i = 0; i < size; i++) {
+    float accum_weight = 0.0f;
+    int min = math::max(i - half_size, 0);
+    int max = math::min(i + half_size, size - 1);
+    for (int ni = min, index = (min - i) + half_size; ni <= max; ni++, index++) {
+      accum_weight += gaussian[index];
+    }
+    weights_sum[i] = accum_weight;
+  }
+  return weights_sum;
+}
+
 template<typename T>
 static void gaussian_blur_x(const Span<float> gaussian,
+                            const Span<float> weights_sum,
                             int half_size,
                             int start_line,
                             int width,
                             int height,
-                            int /*frame_height*/,
                             const T *rect,
                             T *dst)
 {
@@ -2427,7 +2452,6 @@ static void gaussian_blur_x(const Span<float> gaussian,
   for (int y = start_line; y < start_line + height; y++) {
     for (int x = 0; x < width; x++) {
       float4 accum(0.0f);
-      float accum_weight = 0.0f;
 
       int xmin = math::max(x - half_size, 0);
       int xmax = math::min(x + half_size, width - 1);
@@ -2435,9 +2459,8 @@ static void gaussian_blur_x(const Span<float> gaussian,
         float weight = gaussian[index];
         int offset = (y * width + nx) * 4;
         accum += float4(rect + offset) * weight;
-        accum_weight += weight;
       }
-      accum *= (1.0f / accum_weight);
+      accum *= (1.0f / weights_sum[x]);
       dst[0] = accum[0];
       dst[1] = accum[1];
       dst[2] = accum[2];
@@ -2447,8 +2470,11 @@ static void gaussian_blur_x(const Span<float> gaussian,
   }
 }
 
+/* Whole rows are accumulated at once to read the image in memory order, every pixel still sums
+ * its samples in the same order. */
 template<typename T>
 static void gaussian_blur_y(const Span<float> gaussian,
+                            const Span<float> weights_sum,
                             int half_size,
                             int start_line,
                             int width,
@@ -2457,24 +2483,26 @@ static void gaussian_blur_y(const Span<float> gaussian,
                             const T *rect,
                             T *dst)
 {
+  Array<float4> accum(width);
   dst += int64_t(start_line) * width * 4;
   for (int y = start_line; y < start_line + height; y++) {
-    for (int x = 0; x < width; x++) {
-      float4 accum(0.0f);
-      float accum_weight = 0.0f;
-      int ymin = math::max(y - half_size, 0);
-      int ymax = math::min(y + half_size, frame_height - 1);
-      for (int ny = ymin, index = (ymin - y) + half_size; ny <= ymax; ny++, index++) {
-        float weight = gaussian[index];
-        int offset = (ny * width + x) * 4;
-        accum += float4(rect + offset) * weight;
-        accum_weight += weight;
+    accum.fill(float4(0.0f));
+    int ymin = math::max(y - half_size, 0);
+    int ymax = math::min(y + half_size, frame_height - 1);
+    for (int ny = ymin, index = (ymin - y) + half_size; ny <= ymax; ny++, index++) {
+      float weight = gaussian[index];
+      const T *src = rect + int64_t(ny) * width * 4;
+      for (int x = 0; x < width; x++) {
+        accum[x] += float4(src + x * 4) * weight;
       }
-      accum *= (1.0f / accum_weight);
-      dst[0] = accum[0];
-      dst[1] = accum[1];
-      dst[2] = accum[2];
-      dst[3] = accum[3];
+    }
+    const float inv_weight = 1.0f / weights_sum[y];
+    for (int x = 0; x < width; x++) {
+      const float4 value = accum[x] * inv_weight;
+      dst[0] = value[0];
+      dst[1] = value[1];
+      dst[2] = value[2];
+      dst[3] = value[3];
       dst += 4;
     }
   }
@@ -2500,6 +2528,8 @@ static ImBuf *do_gaussian_blur_effect(const SeqRenderData *context,
   const int width = context->rectx;
   const int height = context->recty;
   const bool is_float = ibuf1->float_buffer.data;
+  const Array<float> weights_sum_x = gaussian_blur_weights_sum(gaussian_x, half_size_x, width);
+  const Array<float> weights_sum_y = gaussian_blur_weights_sum(gaussian_y, half_size_y, height);
 
   /* Horizontal blur: create output, blur ibuf1 into it. */
   ImBuf *out = prepare_effect_imbufs(context, ibuf1, nullptr, nullptr);
@@ -2508,21 +2538,21 @@ static ImBuf *do_gaussian_blur_effect(const SeqRenderData *context,
     const int y_size = y_range.size();
     if (is_float) {
       gaussian_blur_x(gaussian_x,
+                      weights_sum_x,
                       half_size_x,
                       y_first,
                       width,
                       y_size,
-                      height,
                       ibuf1->float_buffer.data,
                       out->float_buffer.data);
     }
     else {
       gaussian_blur_x(gaussian_x,
+                      weights_sum_x,
                       half_size_x,
                       y_first,
                       width,
                       y_size,
-                      height,
                       ibuf1->byte_buffer.data,
                       out->byte_buffer.data);
     }
@@ -2536,6 +2566,7 @@ static ImBuf *do_gaussian_blur_effect(const SeqRenderData *context,
     const int y_size = y_range.size();
     if (is_float) {
       gaussian_blur_y(gaussian_y,
+                      weights_sum_y,
                       half_size_y,
                       y_first,
                       width,
@@ -2546,6 +2577,7 @@ static ImBuf *do_gaussian_blur_effect(const SeqRenderData *context,
     }
     else {
       gaussian_blur_y(gaussian_y,
+                      weights_sum_y,
                       half_size_y,
                       y_first,
                       width,
@@ -6,6 +6,7 @@
  * \ingroup bke
  */
 
+#include <algorithm>
 #include <cstddef>
 #include <ctime>
 #include <memory.h>
@@ -50,7 +51,8 @@
  * If the cache is full all entries for pending frame will have is_temp_cache set.
  *
  * Linking: We use links to reduce number of iterations over entries needed to manage cache.
- * Entries are linked in order as they are put into cache.
+ * Entries are linked in order as they are put into cache. Every render task (see #eSeqTaskId)
+ * has its own chain, so frames that are rendered at the same time are not linked together.
  * Only permanent (is_temp_cache = 0) cache entries are linked.
  * Putting #SEQ_CACHE_STORE_FINAL_OUT will reset linking
  *
@@ -69,7 +71,8 @@ struct SeqCache {
   ThreadMutex iterator_mutex;
   BLI_mempool *keys_pool;
   BLI_mempool *items_pool;
-  SeqCacheKey *last_key;
+  /* Last key put into the cache by every render task. */
+  SeqCacheKey *last_key[SEQ_TASK_NUM];
   SeqDiskCache *disk_cache;
   int thumbnail_count;
 };
@@ -155,6 +158,16 @@ static SeqCache *seq_cache_get_from_scene(Scene *scene)
   return nullptr;
 }
 
+static void seq_cache_last_keys_clear(SeqCache *cache)
+{
+  std::fill_n(cache->last_key, SEQ_TASK_NUM, nullptr);
+}
+
+static bool seq_cache_is_last_key(const SeqCache *cache, const SeqCacheKey *key)
+{
+  return cache->last_key[key->task_id] == key;
+}
+
 static void seq_cache_lock(Scene *scene)
 {
   SeqCache *cache = seq_cache_get_from_scene(scene);
@@ -221,10 +234,12 @@ static void seq_cache_put_ex(Scene *scene, SeqCacheKey *key, ImBuf *ibuf)
 
   const int stored_types_flag = get_stored_types_flag(scene, key);
 
+  SeqCacheKey *&last_key = cache->last_key[key->task_id];
+
   /* Item stored for later use. */
   if (stored_types_flag & key->type) {
     key->is_temp_cache = false;
-    key->link_prev = cache->last_key;
+    key->link_prev = last_key;
   }
 
   BLI_assert(!BLI_ghash_haskey(cache->hash, key));
@@ -232,22 +247,22 @@ static void seq_cache_put_ex(Scene *scene, SeqCacheKey *key, ImBuf *ibuf)
   IMB_refImBuf(ibuf);
 
   /* Store pointer to last cached key. */
-  SeqCacheKey *temp_last_key = cache->last_key;
+  SeqCacheKey *temp_last_key = last_key;
 
   if (!key->is_temp_cache || key->type != SEQ_CACHE_STORE_THUMBNAIL) {
-    cache->last_key = key;
+    last_key = key;
   }
 
   /* Set last_key's reference to this key so we can look up chain backwards.
-   * Item is already put in cache, so cache->last_key points to current key.
+   * Item is already put in cache, so last_key points to current key.
    */
   if (!key->is_temp_cache && temp_last_key) {
-    temp_last_key->link_next = cache->last_key;
+    temp_last_key->link_next = last_key;
   }
 
   /* Reset linking. */
   if (key->type == SEQ_CACHE_STORE_FINAL_OUT) {
-    cache->last_key = nullptr;
+    last_key = nullptr;
   }
 }
 
@@ -362,7 +377,7 @@ static void seq_cache_recycle_linked(Scene *scene, SeqCacheKey *base)
 
     seq_cache_key_unlink(base);
     BLI_ghash_remove(cache->hash, base, seq_cache_keyfree, seq_cache_valfree);
-    BLI_assert(base != cache->last_key);
+    BLI_assert(!seq_cache_is_last_key(cache, base));
     base = prev;
   }
 
@@ -381,7 +396,7 @@ static void seq_cache_recycle_linked(Scene *scene, SeqCacheKey *base)
 
     seq_cache_key_unlink(base);
     BLI_ghash_remove(cache->hash, base, seq_cache_keyfree, seq_cache_valfree);
-    BLI_assert(base != cache->last_key);
+    BLI_assert(!seq_cache_is_last_key(cache, base));
     base = next;
   }
 }
@@ -500,7 +515,7 @@ static void seq_cache_create(Main *bmain, Scene *scene)
     cache->keys_pool = BLI_mempool_create(sizeof(SeqCacheKey), 0, 64, BLI_MEMPOOL_NOP);
     cache->items_pool = BLI_mempool_create(sizeof(SeqCacheItem), 0, 64, BLI_MEMPOOL_NOP);
     cache->hash = BLI_ghash_new(seq_cache_hashhash, seq_cache_hashcmp, "SeqCache hash");
-    cache->last_key = nullptr;
+    seq_cache_last_keys_clear(cache);
     cache->bmain = bmain;
     cache->thumbnail_count = 0;
     BLI_mutex_init(&cache->iterator_mutex);
@@ -543,6 +558,16 @@ static SeqCacheKey *seq_cache_allocate_key(SeqCache *cache,
   return key;
 }
 
+/* Frames rendered at the same time may all be the first to use the disk cache. */
+static void seq_cache_ensure_disk_cache(const SeqRenderData *context, SeqCache *cache)
+{
+  seq_cache_lock(context->scene);
+  if (cache->disk_cache == nullptr) {
+    cache->disk_cache = seq_disk_cache_create(context->bmain, context->scene);
+  }
+  seq_cache_unlock(context->scene);
+}
+
 /* ***************************** API ****************************** */
 
 void seq_cache_free_temp_cache(Scene *scene, short id, int timeline_frame)
@@ -571,8 +596,8 @@ void seq_cache_free_temp_cache(Scene *scene, short id, int timeline_frame)
       {
         seq_cache_key_unlink(key);
         BLI_ghash_remove(cache->hash, key, seq_cache_keyfree, seq_cache_valfree);
-        if (key == cache->last_key) {
-          cache->last_key = nullptr;
+        if (seq_cache_is_last_key(cache, key)) {
+          cache->last_key[key->task_id] = nullptr;
         }
       }
     }
@@ -630,7 +655,7 @@ void SEQ_cache_cleanup(Scene *scene)
     /* NOTE: no need to call #seq_cache_key_unlink as all keys are removed. */
     BLI_ghash_remove(cache->hash, key, seq_cache_keyfree, seq_cache_valfree);
   }
-  cache->last_key = nullptr;
+  seq_cache_last_keys_clear(cache);
   cache->thumbnail_count = 0;
   seq_cache_unlock(scene);
 }
@@ -686,7 +711,7 @@ void seq_cache_cleanup_sequence(Scene *scene,
       BLI_ghash_remove(cache->hash, key, seq_cache_keyfree, seq_cache_valfree);
     }
   }
-  cache->last_key = nullptr;
+  seq_cache_last_keys_clear(cache);
   seq_cache_unlock(scene);
 }
 
@@ -730,7 +755,7 @@ void seq_cache_thumbnail_cleanup(Scene *scene, rctf *view_area_safe)
       cache->thumbnail_count--;
     }
   }
-  cache->last_key = nullptr;
+  seq_cache_last_keys_clear(cache);
 }
 
 ImBuf *seq_cache_get(const SeqRenderData *context, Sequence *seq, float timeline_frame, int type)
@@ -774,9 +799,7 @@ ImBuf *seq_cache_get(const SeqRenderData *context, Sequence *seq, float timeline
 
   /* Try disk cache: */
   if (seq_disk_cache_is_enabled(context->bmain)) {
-    if (cache->disk_cache == nullptr) {
-      cache->disk_cache = seq_disk_cache_create(context->bmain, context->scene);
-    }
+    seq_cache_ensure_disk_cache(context, cache);
 
     ibuf = seq_disk_cache_read_file(cache->disk_cache, &key);
 
@@ -786,8 +809,13 @@ ImBuf *seq_cache_get(const SeqRenderData *context, Sequence *seq, float timeline
 
     /* Store read image in RAM. Only recycle item for final type. */
     if (key.type != SEQ_CACHE_STORE_FINAL_OUT || seq_cache_recycle_item(scene)) {
-      SeqCacheKey *new_key = seq_cache_allocate_key(cache, context, seq, timeline_frame, type);
-      seq_cache_put_ex(scene, new_key, ibuf);
+      seq_cache_lock(scene);
+      /* Another frame that is rendered at the same time may have read the same image. */
+      if (!BLI_ghash_haskey(cache->hash, &key)) {
+        SeqCacheKey *new_key = seq_cache_allocate_key(cache, context, seq, timeline_frame, type);
+        seq_cache_put_ex(scene, new_key, ibuf);
+      }
+      seq_cache_unlock(scene);
     }
   }
 
@@ -814,8 +842,12 @@ bool seq_cache_put_if_possible(
     return true;
   }
 
-  seq_cache_set_temp_cache_linked(scene, scene->ed->cache->last_key);
-  scene->ed->cache->last_key = nullptr;
+  /* Other frames may be put into the cache at the same time while prefetching. */
+  seq_cache_lock(scene);
+  SeqCacheKey *&last_key = scene->ed->cache->last_key[context->task_id];
+  seq_cache_set_temp_cache_linked(scene, last_key);
+  last_key = nullptr;
+  seq_cache_unlock(scene);
   return false;
 }
 
@@ -883,14 +915,20 @@ void seq_cache_put(
   seq_cache_lock(scene);
   SeqCache *cache = seq_cache_get_from_scene(scene);
   SeqCacheKey *key = seq_cache_allocate_key(cache, context, seq, timeline_frame, type);
+
+  /* The same image may have been put by a frame that is rendered at the same time. */
+  if (BLI_ghash_haskey(cache->hash, key)) {
+    BLI_mempool_free(cache->keys_pool, key);
+    seq_cache_unlock(scene);
+    return;
+  }
+
   seq_cache_put_ex(scene, key, i);
   seq_cache_unlock(scene);
 
   if (!key->is_temp_cache) {
     if (seq_disk_cache_is_enabled(context->bmain)) {
-      if (cache->disk_cache == nullptr) {
-        seq_disk_cache_create(context->bmain, context->scene);
-      }
+      seq_cache_ensure_disk_cache(context, cache);
 
       seq_disk_cache_write_file(cache->disk_cache, key, i);
       seq_disk_cache_enforce_limits(cache->disk_cache);
@@ -939,7 +977,7 @@ void SEQ_cache_iterate(
     interrupt = callback_iter(userdata, key->seq, timeline_frame, key->type);
   }
 
-  cache->last_key = nullptr;
+  seq_cache_last_keys_clear(cache);
   seq_cache_unlock(scene);
 }
 
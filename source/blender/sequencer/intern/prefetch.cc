@@ -6,6 +6,7 @@
  * \ingroup bke
  */
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdlib>
 #include <cstring>
@@ -18,6 +19,7 @@
 #include "DNA_space_types.h"
 
 #include "BLI_listbase.h"
+#include "BLI_task.hh"
 #include "BLI_threads.h"
 
 #include "IMB_imbuf.hh"
@@ -46,29 +48,37 @@
 #include "prefetch.hh"
 #include "render.hh"
 
+/* Evaluated scene used to render one of the frames that are prefetched at the same time. */
+struct PrefetchTask {
+  Main *bmain_eval;
+  Scene *scene_eval;
+  Depsgraph *depsgraph;
+
+  /* context */
+  SeqRenderData context;
+  SeqRenderData context_cpy;
+};
+
 struct PrefetchJob {
   PrefetchJob *next, *prev;
 
   Main *bmain;
-  Main *bmain_eval;
   Scene *scene;
-  Scene *scene_eval;
-  Depsgraph *depsgraph;
+
+  /* The first task is always used, the others only when frames can be rendered in parallel. */
+  PrefetchTask tasks[SEQ_PREFETCH_TASKS_NUM];
+  int tasks_num;
 
   ThreadMutex prefetch_suspend_mutex;
   ThreadCondition prefetch_suspend_cond;
 
   ListBase threads;
 
-  /* context */
-  SeqRenderData context;
-  SeqRenderData context_cpy;
-  ListBase *seqbasep;
-  ListBase *seqbasep_cpy;
-
   /* prefetch area */
   float cfra;
   int num_frames_prefetched;
+  /* Number of frames rendered at the same time, starting at the last prefetched one. */
+  int num_frames_rendering;
 
   /* control */
   bool running;
@@ -159,7 +169,7 @@ SeqRenderData *seq_prefetch_get_original_context(const SeqRenderData *context)
 {
   PrefetchJob *pfjob = seq_prefetch_job_get(context->scene);
 
-  return &pfjob->context;
+  return &pfjob->tasks[context->task_id - SEQ_TASK_PREFETCH_RENDER].context;
 }
 
 static bool seq_prefetch_is_cache_full(Scene *scene)
@@ -177,50 +187,43 @@ static float seq_prefetch_cfra(PrefetchJob *pfjob)
 {
   return pfjob->cfra + pfjob->num_frames_prefetched;
 }
-static AnimationEvalContext seq_prefetch_anim_eval_context(PrefetchJob *pfjob)
-{
-  return BKE_animsys_eval_context_construct(pfjob->depsgraph, seq_prefetch_cfra(pfjob));
-}
-
 void seq_prefetch_get_time_range(Scene *scene, int *r_start, int *r_end)
 {
   PrefetchJob *pfjob = seq_prefetch_job_get(scene);
 
   *r_start = pfjob->cfra;
-  *r_end = seq_prefetch_cfra(pfjob);
+  *r_end = seq_prefetch_cfra(pfjob) + pfjob->num_frames_rendering - 1;
 }
 
-static void seq_prefetch_free_depsgraph(PrefetchJob *pfjob)
+static void seq_prefetch_free_depsgraph(PrefetchTask *task)
 {
-  if (pfjob->depsgraph != nullptr) {
-    DEG_graph_free(pfjob->depsgraph);
+  if (task->depsgraph != nullptr) {
+    DEG_graph_free(task->depsgraph);
   }
-  pfjob->depsgraph = nullptr;
-  pfjob->scene_eval = nullptr;
+  task->depsgraph = nullptr;
+  task->scene_eval = nullptr;
 }
 
-static void seq_prefetch_update_depsgraph(PrefetchJob *pfjob)
+static void seq_prefetch_init_depsgraph(PrefetchJob *pfjob, PrefetchTask *task)
 {
-  DEG_evaluate_on_framechange(pfjob->depsgraph, seq_prefetch_cfra(pfjob));
-}
-
-static void seq_prefetch_init_depsgraph(PrefetchJob *pfjob)
-{
-  Main *bmain = pfjob->bmain_eval;
+  if (task->bmain_eval == nullptr) {
+    task->bmain_eval = BKE_main_new();
+  }
+  Main *bmain = task->bmain_eval;
   Scene *scene = pfjob->scene;
   ViewLayer *view_layer = BKE_view_layer_default_render(scene);
 
-  pfjob->depsgraph = DEG_graph_new(bmain, scene, view_layer, DAG_EVAL_RENDER);
-  DEG_debug_name_set(pfjob->depsgraph, "SEQUENCER PREFETCH");
+  task->depsgraph = DEG_graph_new(bmain, scene, view_layer, DAG_EVAL_RENDER);
+  DEG_debug_name_set(task->depsgraph, "SEQUENCER PREFETCH");
 
   /* Make sure there is a correct evaluated scene pointer. */
-  DEG_graph_build_for_render_pipeline(pfjob->depsgraph);
+  DEG_graph_build_for_render_pipeline(task->depsgraph);
 
   /* Update immediately so we have proper evaluated scene. */
-  seq_prefetch_update_depsgraph(pfjob);
+  DEG_evaluate_on_framechange(task->depsgraph, seq_prefetch_cfra(pfjob));
 
-  pfjob->scene_eval = DEG_get_evaluated_scene(pfjob->depsgraph);
-  pfjob->scene_eval->ed->cache_flag = 0;
+  task->scene_eval = DEG_get_evaluated_scene(task->depsgraph);
+  task->scene_eval->ed->cache_flag = 0;
 }
 
 static void seq_prefetch_update_area(PrefetchJob *pfjob)
@@ -276,32 +279,37 @@ static void seq_prefetch_update_context(const SeqRenderData *context)
   PrefetchJob *pfjob;
   pfjob = seq_prefetch_job_get(context->scene);
 
-  SEQ_render_new_render_data(pfjob->bmain_eval,
-                             pfjob->depsgraph,
-                             pfjob->scene_eval,
-                             context->rectx,
-                             context->recty,
-                             context->preview_render_size,
-                             false,
-                             &pfjob->context_cpy);
-  pfjob->context_cpy.is_prefetch_render = true;
-  pfjob->context_cpy.task_id = SEQ_TASK_PREFETCH_RENDER;
-
-  SEQ_render_new_render_data(pfjob->bmain,
-                             pfjob->depsgraph,
-                             pfjob->scene,
-                             context->rectx,
-                             context->recty,
-                             context->preview_render_size,
-                             false,
-                             &pfjob->context);
-  pfjob->context.is_prefetch_render = false;
-
-  /* Same ID as prefetch context, because context will be swapped, but we still
-   * want to assign this ID to cache entries created in this thread.
-   * This is to allow "temp cache" work correctly for both threads.
-   */
-  pfjob->context.task_id = SEQ_TASK_PREFETCH_RENDER;
+  for (const int i : blender::IndexRange(pfjob->tasks_num)) {
+    PrefetchTask &task = pfjob->tasks[i];
+    const eSeqTaskId task_id = eSeqTaskId(SEQ_TASK_PREFETCH_RENDER + i);
+
+    SEQ_render_new_render_data(task.bmain_eval,
+                               task.depsgraph,
+                               task.scene_eval,
+                               context->rectx,
+                               context->recty,
+                               context->preview_render_size,
+                               false,
+                               &task.context_cpy);
+    task.context_cpy.is_prefetch_render = true;
+    task.context_cpy.task_id = task_id;
+
+    SEQ_render_new_render_data(pfjob->bmain,
+                               task.depsgraph,
+                               pfjob->scene,
+                               context->rectx,
+                               context->recty,
+                               context->preview_render_size,
+                               false,
+                               &task.context);
+    task.context.is_prefetch_render = false;
+
+    /* Same ID as prefetch context, because context will be swapped, but we still
+     * want to assign this ID to cache entries created in this thread.
+     * This is to allow "temp cache" work correctly for both threads.
+     */
+    task.context.task_id = task_id;
+  }
 }
 
 static void seq_prefetch_update_scene(Scene *scene)
@@ -313,21 +321,29 @@ static void seq_prefetch_update_scene(Scene *scene)
   }
 
   pfjob->scene = scene;
-  seq_prefetch_free_depsgraph(pfjob);
-  seq_prefetch_init_depsgraph(pfjob);
+  for (const int i : blender::IndexRange(SEQ_PREFETCH_TASKS_NUM)) {
+    seq_prefetch_free_depsgraph(&pfjob->tasks[i]);
+    if (i < pfjob->tasks_num) {
+      seq_prefetch_init_depsgraph(pfjob, &pfjob->tasks[i]);
+    }
+  }
 }
 
 static void seq_prefetch_update_active_seqbase(PrefetchJob *pfjob)
 {
   MetaStack *ms_orig = SEQ_meta_stack_active_get(SEQ_editing_get(pfjob->scene));
-  Editing *ed_eval = SEQ_editing_get(pfjob->scene_eval);
 
-  if (ms_orig != nullptr) {
-    Sequence *meta_eval = seq_prefetch_get_original_sequence(ms_orig->parseq, pfjob->scene_eval);
-    SEQ_seqbase_active_set(ed_eval, &meta_eval->seqbase);
-  }
-  else {
-    SEQ_seqbase_active_set(ed_eval, &ed_eval->seqbase);
+  for (const int i : blender::IndexRange(pfjob->tasks_num)) {
+    Scene *scene_eval = pfjob->tasks[i].scene_eval;
+    Editing *ed_eval = SEQ_editing_get(scene_eval);
+
+    if (ms_orig != nullptr) {
+      Sequence *meta_eval = seq_prefetch_get_original_sequence(ms_orig->parseq, scene_eval);
+      SEQ_seqbase_active_set(ed_eval, &meta_eval->seqbase);
+    }
+    else {
+      SEQ_seqbase_active_set(ed_eval, &ed_eval->seqbase);
+    }
   }
 }
 
@@ -353,8 +369,12 @@ void seq_prefetch_free(Scene *scene)
   BLI_threadpool_end(&pfjob->threads);
   BLI_mutex_end(&pfjob->prefetch_suspend_mutex);
   BLI_condition_end(&pfjob->prefetch_suspend_cond);
-  seq_prefetch_free_depsgraph(pfjob);
-  BKE_main_free(pfjob->bmain_eval);
+  for (PrefetchTask &task : pfjob->tasks) {
+    seq_prefetch_free_depsgraph(&task);
+    if (task.bmain_eval != nullptr) {
+      BKE_main_free(task.bmain_eval);
+    }
+  }
   MEM_freeN(pfjob);
   scene->ed->prefetch_job = nullptr;
 }
@@ -363,7 +383,7 @@ static bool seq_prefetch_seq_has_disk_cache(PrefetchJob *pfjob,
                                             Sequence *seq,
                                             bool can_have_final_image)
 {
-  SeqRenderData *ctx = &pfjob->context_cpy;
+  SeqRenderData *ctx = &pfjob->tasks[0].context_cpy;
   float cfra = seq_prefetch_cfra(pfjob);
 
   ImBuf *ibuf = seq_cache_get(ctx, seq, cfra, SEQ_CACHE_STORE_PREPROCESSED);
@@ -399,7 +419,7 @@ static bool seq_prefetch_scene_strip_is_rendered(PrefetchJob *pfjob,
 {
   float cfra = seq_prefetch_cfra(pfjob);
   blender::Vector<Sequence *> strips = seq_get_shown_sequences(
-      pfjob->scene_eval, channels, seqbase, cfra, 0);
+      pfjob->tasks[0].scene_eval, channels, seqbase, cfra, 0);
 
   /* Iterate over rendered strips. */
   for (Sequence *seq : strips) {
@@ -468,41 +488,84 @@ static void seq_prefetch_do_suspend(PrefetchJob *pfjob)
   BLI_mutex_unlock(&pfjob->prefetch_suspend_mutex);
 }
 
+static void seq_prefetch_update_task(PrefetchJob *pfjob, PrefetchTask *task, float cfra)
+{
+  task->scene_eval->ed->prefetch_job = nullptr;
+
+  DEG_evaluate_on_framechange(task->depsgraph, cfra);
+  AnimData *adt = BKE_animdata_from_id(&task->context_cpy.scene->id);
+  AnimationEvalContext anim_eval_context = BKE_animsys_eval_context_construct(task->depsgraph,
+                                                                              cfra);
+  BKE_animsys_evaluate_animdata(
+      &task->context_cpy.scene->id, adt, &anim_eval_context, ADT_RECALC_ALL, false);
+
+  /* This is quite hacky solution:
+   * We need cross-reference original scene with copy for cache.
+   * However depsgraph must not have this data, because it will try to kill this job.
+   * Scene copy don't reference original scene. Perhaps, this could be done by depsgraph.
+   * Set to nullptr before return!
+   */
+  task->scene_eval->ed->prefetch_job = pfjob;
+}
+
+/* Render the next \a frames_num frames at the same time, each with its own task. */
+static void seq_prefetch_render_frames_parallel(PrefetchJob *pfjob, const int frames_num)
+{
+  const float cfra = seq_prefetch_cfra(pfjob);
+  for (const int i : blender::IndexRange(frames_num)) {
+    seq_prefetch_update_task(pfjob, &pfjob->tasks[i], cfra + i);
+  }
+
+  seq_render_lock();
+  /* Isolate, so that waiting threads don't take unrelated tasks that need the render lock. */
+  blender::threading::isolate_task([&]() {
+    blender::threading::parallel_for(
+        blender::IndexRange(frames_num), 1, [&](const blender::IndexRange range) {
+          for (const int i : range) {
+            PrefetchTask &task = pfjob->tasks[i];
+            ImBuf *ibuf = seq_render_give_ibuf_no_lock(&task.context_cpy, cfra + i, 0);
+            seq_cache_free_temp_cache(pfjob->scene, task.context.task_id, cfra + i);
+            IMB_freeImBuf(ibuf);
+          }
+        });
+  });
+  seq_render_unlock();
+}
+
 static void *seq_prefetch_frames(void *job)
 {
   PrefetchJob *pfjob = (PrefetchJob *)job;
+  PrefetchTask *first_task = &pfjob->tasks[0];
 
   while (seq_prefetch_cfra(pfjob) <= pfjob->scene->r.efra) {
-    pfjob->scene_eval->ed->prefetch_job = nullptr;
-
-    seq_prefetch_update_depsgraph(pfjob);
-    AnimData *adt = BKE_animdata_from_id(&pfjob->context_cpy.scene->id);
-    AnimationEvalContext anim_eval_context = seq_prefetch_anim_eval_context(pfjob);
-    BKE_animsys_evaluate_animdata(
-        &pfjob->context_cpy.scene->id, adt, &anim_eval_context, ADT_RECALC_ALL, false);
-
-    /* This is quite hacky solution:
-     * We need cross-reference original scene with copy for cache.
-     * However depsgraph must not have this data, because it will try to kill this job.
-     * Scene copy don't reference original scene. Perhaps, this could be done by depsgraph.
-     * Set to nullptr before return!
-     */
-    pfjob->scene_eval->ed->prefetch_job = pfjob;
-
-    ListBase *seqbase = SEQ_active_seqbase_get(SEQ_editing_get(pfjob->scene_eval));
-    ListBase *channels = SEQ_channels_displayed_get(SEQ_editing_get(pfjob->scene_eval));
-    if (seq_prefetch_must_skip_frame(pfjob, channels, seqbase)) {
-      pfjob->num_frames_prefetched++;
-      /* Break instead of keep looping if the job should be terminated. */
-      if (!(pfjob->scene->ed->cache_flag & SEQ_CACHE_PREFETCH_ENABLE) || pfjob->stop) {
-        break;
-      }
-      continue;
+    const int frames_num = std::min(pfjob->tasks_num,
+                                    int(pfjob->scene->r.efra - seq_prefetch_cfra(pfjob)) + 1);
+    if (frames_num > 1) {
+      /* Strips that could require skipping frames never use more than one task. */
+      pfjob->num_frames_rendering = frames_num;
+      seq_prefetch_render_frames_parallel(pfjob, frames_num);
+      pfjob->num_frames_prefetched += frames_num - 1;
+      pfjob->num_frames_rendering = 1;
     }
+    else {
+      seq_prefetch_update_task(pfjob, first_task, seq_prefetch_cfra(pfjob));
+
+      ListBase *seqbase = SEQ_active_seqbase_get(SEQ_editing_get(first_task->scene_eval));
+      ListBase *channels = SEQ_channels_displayed_get(SEQ_editing_get(first_task->scene_eval));
+      if (seq_prefetch_must_skip_frame(pfjob, channels, seqbase)) {
+        pfjob->num_frames_prefetched++;
+        /* Break instead of keep looping if the job should be terminated. */
+        if (!(pfjob->scene->ed->cache_flag & SEQ_CACHE_PREFETCH_ENABLE) || pfjob->stop) {
+          break;
+        }
+        continue;
+      }
 
-    ImBuf *ibuf = SEQ_render_give_ibuf(&pfjob->context_cpy, seq_prefetch_cfra(pfjob), 0);
-    seq_cache_free_temp_cache(pfjob->scene, pfjob->context.task_id, seq_prefetch_cfra(pfjob));
-    IMB_freeImBuf(ibuf);
+      ImBuf *ibuf = SEQ_render_give_ibuf(&first_task->context_cpy, seq_prefetch_cfra(pfjob), 0);
+      seq_cache_free_temp_cache(
+          pfjob->scene, first_task->context.task_id, seq_prefetch_cfra(pfjob));
+      IMB_freeImBuf(ibuf);
+    }
 
     /* Suspend thread if there is nothing to be prefetched. */
     seq_prefetch_do_suspend(pfjob);
@@ -521,13 +584,49 @@ static void *seq_prefetch_frames(void *job)
     pfjob->num_frames_prefetched++;
   }
 
-  seq_cache_free_temp_cache(pfjob->scene, pfjob->context.task_id, seq_prefetch_cfra(pfjob));
+  for (PrefetchTask &task : blender::MutableSpan(pfjob->tasks, pfjob->tasks_num)) {
+    seq_cache_free_temp_cache(pfjob->scene, task.context.task_id, seq_prefetch_cfra(pfjob));
+    task.scene_eval->ed->prefetch_job = nullptr;
+  }
   pfjob->running = false;
-  pfjob->scene_eval->ed->prefetch_job = nullptr;
 
   return nullptr;
 }
 
+/**
+ * Frames can only be rendered at the same time when the strips don't depend on state that is
+ * shared between the evaluated scenes or between frames. Movie strips decode frames in order,
+ * scene and clip strips use data outside of the sequencer and text strips share fonts.
+ */
+static bool seq_prefetch_can_render_frames_parallel(ListBase *seqbase)
+{
+  LISTBASE_FOREACH (Sequence *, seq, seqbase) {
+    if (seq->type == SEQ_TYPE_META) {
+      if (!seq_prefetch_can_render_frames_parallel(&seq->seqbase)) {
+        return false;
+      }
+    }
+    else if (seq->type & SEQ_TYPE_EFFECT) {
+      if (seq->type == SEQ_TYPE_TEXT) {
+        return false;
+      }
+    }
+    else if (!ELEM(seq->type, SEQ_TYPE_IMAGE, SEQ_TYPE_SOUND_RAM, SEQ_TYPE_SOUND_HD)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static int seq_prefetch_tasks_num_get(Scene *scene)
+{
+  if (!seq_prefetch_can_render_frames_parallel(&scene->ed->seqbase)) {
+    return 1;
+  }
+  /* Rendering a single frame is multi-threaded already, keep some threads for that. */
+  return std::clamp(BLI_system_thread_count() / 2, 1, SEQ_PREFETCH_TASKS_NUM);
+}
+
 static PrefetchJob *seq_prefetch_start_ex(const SeqRenderData *context, float cfra)
 {
   PrefetchJob *pfjob = seq_prefetch_job_get(context->scene);
@@ -541,15 +640,17 @@ static PrefetchJob *seq_prefetch_start_ex(const SeqRenderData *context, float cf
       BLI_mutex_init(&pfjob->prefetch_suspend_mutex);
       BLI_condition_init(&pfjob->prefetch_suspend_cond);
 
-      pfjob->bmain_eval = BKE_main_new();
       pfjob->scene = context->scene;
-      seq_prefetch_init_depsgraph(pfjob);
+      pfjob->tasks_num = 1;
+      seq_prefetch_init_depsgraph(pfjob, &pfjob->tasks[0]);
     }
   }
   pfjob->bmain = context->bmain;
+  pfjob->tasks_num = seq_prefetch_tasks_num_get(context->scene);
 
   pfjob->cfra = cfra;
   pfjob->num_frames_prefetched = 1;
+  pfjob->num_frames_rendering = 1;
 
   pfjob->waiting = false;
   pfjob->stop = false;
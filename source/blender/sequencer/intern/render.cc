@@ -25,6 +25,8 @@
 #include "BLI_math_vector_types.hh"
 #include "BLI_path_util.h"
 #include "BLI_rect.h"
+#include "BLI_task.hh"
+#include "BLI_threads.h"
 
 #include "BKE_anim_data.hh"
 #include "BKE_animsys.h"
@@ -1970,6 +1972,68 @@ static ImBuf *seq_render_strip_stack_apply_effect(
   return out;
 }
 
+/**
+ * Image and movie strips only read their own data when rendered, so several of them can be
+ * rendered at the same time. Other strip types render other strips or go through the render
+ * pipeline, as do modifiers that use a strip as mask.
+ */
+static bool seq_can_render_in_parallel(const Sequence *seq)
+{
+  if (!ELEM(seq->type, SEQ_TYPE_IMAGE, SEQ_TYPE_MOVIE)) {
+    return false;
+  }
+  LISTBASE_FOREACH (const SequenceModifierData *, smd, &seq->modifiers) {
+    if (smd->mask_input_type == SEQUENCE_MASK_INPUT_STRIP && smd->mask_sequence != nullptr) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Render a batch of the strips above the first (bottom) strip of the stack that are blended on
+ * top of it. Every strip is rendered independently of the result below it, so the strips that
+ * can be are rendered in parallel, the blending itself is still done in order. The stack is
+ * rendered in batches of at most the number of threads, so that only the images of one batch
+ * are kept in memory until they are blended.
+ *
+ * \param r_ibufs: Rendered image of every strip in \a range, or null when it is not blended.
+ */
+static void seq_render_strip_stack_inputs(const SeqRenderData *context,
+                                          SeqRenderState *state,
+                                          const Span<Sequence *> strips,
+                                          const IndexRange range,
+                                          const OpaqueQuadTracker &opaques,
+                                          float timeline_frame,
+                                          MutableSpan<ImBuf *> r_ibufs)
+{
+  const int64_t start = range.start();
+  r_ibufs.fill(nullptr);
+
+  Vector<int64_t> parallel_indices;
+  for (const int64_t i : range) {
+    Sequence *seq = strips[i];
+    if (opaques.is_occluded(context, seq, i)) {
+      continue;
+    }
+    if (seq_get_early_out_for_blend_mode(seq) != StripEarlyOut::DoEffect) {
+      continue;
+    }
+    if (seq_can_render_in_parallel(seq)) {
+      parallel_indices.append(i);
+    }
+    else {
+      r_ibufs[i - start] = seq_render_strip(context, state, seq, timeline_frame);
+    }
+  }
+
+  threading::parallel_for(parallel_indices.index_range(), 1, [&](const IndexRange sub_range) {
+    for (const int64_t i : parallel_indices.as_span().slice(sub_range)) {
+      r_ibufs[i - start] = seq_render_strip(context, state, strips[i], timeline_frame);
+    }
+  });
+}
+
 static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
                                      SeqRenderState *state,
                                      ListBase *channels,
@@ -2064,6 +2128,9 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
   }
 
   i++;
+  const int64_t batch_size = std::min<int64_t>(BLI_system_thread_count(), strips.size() - i);
+  Array<ImBuf *> inputs(batch_size);
+  IndexRange batch(i, 0);
   for (; i < strips.size(); i++) {
     Sequence *seq = strips[i];
 
@@ -2071,9 +2138,19 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
       continue;
     }
 
-    if (seq_get_early_out_for_blend_mode(seq) == StripEarlyOut::DoEffect) {
+    if (!batch.contains(i)) {
+      batch = IndexRange(i, std::min<int64_t>(batch_size, strips.size() - i));
+      seq_render_strip_stack_inputs(context,
+                                    state,
+                                    strips,
+                                    batch,
+                                    opaques,
+                                    timeline_frame,
+                                    inputs.as_mutable_span().take_front(batch.size()));
+    }
+
+    if (ImBuf *ibuf2 = inputs[i - batch.start()]) {
       ImBuf *ibuf1 = out;
-      ImBuf *ibuf2 = seq_render_strip(context, state, seq, timeline_frame);
 
       out = seq_render_strip_stack_apply_effect(context, seq, timeline_frame, ibuf1, ibuf2);
 
@@ -2087,7 +2164,10 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
   return out;
 }
 
-ImBuf *SEQ_render_give_ibuf(const SeqRenderData *context, float timeline_frame, int chanshown)
+static ImBuf *seq_render_give_ibuf_ex(const SeqRenderData *context,
+                                      float timeline_frame,
+                                      int chanshown,
+                                      const bool use_render_lock)
 {
   Scene *scene = context->scene;
   Editing *ed = SEQ_editing_get(scene);
@@ -2124,7 +2204,9 @@ ImBuf *SEQ_render_give_ibuf(const SeqRenderData *context, float timeline_frame,
   SEQ_relations_free_all_anim_ibufs(context->scene, timeline_frame);
 
   if (!strips.is_empty() && !out) {
-    BLI_mutex_lock(&seq_render_mutex);
+    if (use_render_lock) {
+      BLI_mutex_lock(&seq_render_mutex);
+    }
     out = seq_render_strip_stack(context, &state, channels, seqbasep, timeline_frame, chanshown);
 
     if (context->is_prefetch_render) {
@@ -2134,14 +2216,44 @@ ImBuf *SEQ_render_give_ibuf(const SeqRenderData *context, float timeline_frame,
       seq_cache_put_if_possible(
           context, strips.last(), timeline_frame, SEQ_CACHE_STORE_FINAL_OUT, out);
     }
-    BLI_mutex_unlock(&seq_render_mutex);
+    if (use_render_lock) {
+      BLI_mutex_unlock(&seq_render_mutex);
+    }
   }
 
+  return out;
+}
+
+ImBuf *SEQ_render_give_ibuf(const SeqRenderData *context, float timeline_frame, int chanshown)
+{
+  if (SEQ_editing_get(context->scene) == nullptr) {
+    return nullptr;
+  }
+
+  ImBuf *out = seq_render_give_ibuf_ex(context, timeline_frame, chanshown, true);
+
   seq_prefetch_start(context, timeline_frame);
 
   return out;
 }
 
+void seq_render_lock()
+{
+  BLI_mutex_lock(&seq_render_mutex);
+}
+
+void seq_render_unlock()
+{
+  BLI_mutex_unlock(&seq_render_mutex);
+}
+
+ImBuf *seq_render_give_ibuf_no_lock(const SeqRenderData *context,
+                                    float timeline_frame,
+                                    int chanshown)
+{
+  return seq_render_give_ibuf_ex(context, timeline_frame, chanshown, false);
+}
+
 ImBuf *seq_render_give_ibuf_seqbase(const SeqRenderData *context,
                                     float timeline_frame,
                                     int chan_shown,
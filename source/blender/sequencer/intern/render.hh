@@ -23,6 +23,20 @@ struct SeqRenderState {
   LinkNode *scene_parents = nullptr;
 };
 
+/**
+ * Lock used by #SEQ_render_give_ibuf while rendering a frame. Holding it allows rendering several
+ * frames at the same time with #seq_render_give_ibuf_no_lock, as long as every one of them uses
+ * its own evaluated scene.
+ */
+void seq_render_lock();
+void seq_render_unlock();
+/**
+ * Same as #SEQ_render_give_ibuf, but for a caller that holds the render lock already. Doesn't
+ * start prefetching.
+ */
+ImBuf *seq_render_give_ibuf_no_lock(const SeqRenderData *context,
+                                    float timeline_frame,
+                                    int chanshown);
 ImBuf *seq_render_give_ibuf_seqbase(const SeqRenderData *context,
                                     float timeline_frame,
                                     int chan_shown,
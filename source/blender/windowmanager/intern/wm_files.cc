@@ -109,6 +109,8 @@
 #include "GHOST_C-api.h"
 #include "GHOST_Path-api.hh"
 
+#include "COM_compositor.hh"
+
 #include "GPU_context.hh"
 
 #include "UI_interface.hh"
@@ -655,6 +657,13 @@ static void wm_file_read_pre(bool use_data, bool /*use_userdef*/)
   UI_view2d_zoom_cache_reset();
 
   ED_preview_restart_queue_free();
+
+#ifdef WITH_COMPOSITOR_CPU
+  /* Free results of the compositor node trees of the previous file. */
+  if (use_data) {
+    COM_clear_caches();
+  }
+#endif
 }
 
 /**
@@ -0,0 +1,216 @@
+# SPDX-FileCopyrightText: 2024 Blender Authors
+#
+# SPDX-License-Identifier: Apache-2.0
+
+# Replay recorded sculpt strokes through the brush stroke operator.
+#
+# Every .blend file in the `sculpt` benchmark directory should contain a mesh object in sculpt
+# mode and a 3D viewport showing it. A recorded stroke can be stored next to the file with the
+# same name and a `.json` extension:
+#
+#   {
+#     "brushes": ["Draw", "Clay Strips"],
+#     "dabs": [{"mouse": [x, y], "pressure": 1.0, "size": 50.0}, ...]
+#   }
+#
+# Mouse coordinates are relative to the largest 3D viewport region. When there is no recorded
+# stroke, a circle around the region center is used, and when no brushes are listed, the active
+# brush is used. The file is reverted before every measured stroke so each one starts from the same
+# mesh.
+#
+# When a stroke is executed rather than run interactively, the brush is placed at the stored
+# location of every dab instead of the mouse position. The locations are found by casting a ray
+# from the mouse position onto the mesh, like the interactive stroke does. Dabs that miss the
+# mesh are skipped.
+
+import json
+import math
+import time
+
+LOG_KEY = "SCULPT_PERFORMANCE: "
+
+# Number of times the full stroke is replayed for every brush.
+STROKE_REPEAT = 3
+
+
+def _view3d_context(bpy):
+    window = bpy.context.window_manager.windows[0]
+    areas = [area for area in window.screen.areas if area.type == 'VIEW_3D']
+    area = max(areas, key=lambda area: area.width * area.height)
+    region = next(region for region in area.regions if region.type == 'WINDOW')
+    return {'window': window, 'area': area, 'region': region}
+
+
+def _synthetic_dabs(region, num_dabs=200):
+    center_x = region.width / 2
+    center_y = region.height / 2
+    radius = min(region.width, region.height) / 4
+    dabs = []
+    for i in range(num_dabs):
+        angle = 2.0 * math.pi * i / num_dabs
+        dabs.append({
+            'mouse': [center_x + radius * math.cos(angle), center_y + radius * math.sin(angle)],
+            'pressure': 1.0,
+            'size': 50.0,
+        })
+    return dabs
+
+
+def _surface_location(bpy, override, mouse):
+    """
+    Return the object space location on the surface of the active object under the mouse, or
+    None when the mouse is not over the mesh.
+    """
+    from bpy_extras import view3d_utils
+
+    region = override['region']
+    region_3d = override['area'].spaces.active.region_3d
+    ob = bpy.context.active_object
+    origin = view3d_utils.region_2d_to_origin_3d(region, region_3d, mouse)
+    direction = view3d_utils.region_2d_to_vector_3d(region, region_3d, mouse)
+
+    world_to_object = ob.matrix_world.inverted()
+    origin = world_to_object @ origin
+    direction = (world_to_object.to_3x3() @ direction).normalized()
+    hit, location, _normal, _index = ob.ray_cast(
+        origin, direction, depsgraph=bpy.context.evaluated_depsgraph_get())
+    return location if hit else None
+
+
+def _stroke_elements(bpy, override, dabs):
+    elements = []
+    for dab in dabs:
+        location = _surface_location(bpy, override, dab['mouse'])
+        if location is None:
+            continue
+        i = len(elements)
+        elements.append({
+            'name': "",
+            'location': location[:],
+            'mouse': dab['mouse'],
+            'mouse_event': dab['mouse'],
+            'pressure': dab.get('pressure', 1.0),
+            'size': dab.get('size', 50.0),
+            'x_tilt': 0.0,
+            'y_tilt': 0.0,
+            'time': float(i),
+            'is_start': i == 0,
+            'pen_flip': False,
+        })
+    return elements
+
+
+def _percentile(sorted_values, fraction):
+    index = min(len(sorted_values) - 1, int(round(fraction * (len(sorted_values) - 1))))
+    return sorted_values[index]
+
+
+def _revert(bpy, brush_name):
+    """
+    Reload the file so a stroke starts from the original mesh, and return the viewport context.
+    """
+    bpy.ops.wm.revert_mainfile()
+    if brush_name:
+        bpy.context.scene.tool_settings.sculpt.brush = bpy.data.brushes[brush_name]
+    return _view3d_context(bpy)
+
+
+def _timed_strokes(bpy, override, strokes):
+    times = []
+    with bpy.context.temp_override(**override):
+        # Warm up caches like the PBVH and the GPU buffers before measuring.
+        bpy.ops.sculpt.brush_stroke(stroke=strokes[0][:1], mode='NORMAL')
+
+        for stroke in strokes:
+            start_time = time.perf_counter()
+            bpy.ops.sculpt.brush_stroke(stroke=stroke, mode='NORMAL')
+            times.append(time.perf_counter() - start_time)
+    return times
+
+
+def _replay_brush(bpy, brush_name, dabs):
+    override = _revert(bpy, brush_name)
+    if not dabs:
+        dabs = _synthetic_dabs(override['region'])
+    elements = _stroke_elements(bpy, override, dabs)
+    if not elements:
+        raise Exception("No stroke dab is over the mesh.")
+
+    # Every run starts from the original mesh, otherwise later runs sculpt on the result of the
+    # previous ones and deform it further.
+    stroke_times = []
+    for _ in range(STROKE_REPEAT):
+        stroke_times += _timed_strokes(bpy, override, [elements])
+        override = _revert(bpy, brush_name)
+
+    # Latency of a single dab, including the stroke setup that is done on every mouse press. Dabs
+    # are spread over the mesh, so they barely overlap.
+    dab_times = _timed_strokes(bpy, override, [[dict(element, is_start=True)]
+                                               for element in elements])
+
+    return stroke_times, dab_times
+
+
+def _run(args):
+    import bpy
+
+    recorded = {}
+    if args['stroke_filepath']:
+        with open(args['stroke_filepath']) as f:
+            recorded = json.load(f)
+    brush_names = recorded.get('brushes', [None])
+    dabs = recorded.get('dabs', [])
+
+    result = {}
+    all_dab_times = []
+    total_time = 0.0
+    for brush_name in brush_names:
+        stroke_times, dab_times = _replay_brush(bpy, brush_name, dabs)
+        stroke_time = sum(stroke_times) / len(stroke_times)
+        total_time += stroke_time
+        all_dab_times += dab_times
+        if brush_name:
+            result['time_' + brush_name.lower().replace(' ', '_')] = stroke_time
+
+    all_dab_times.sort()
+    result['time'] = total_time
+    result['dab_p50'] = _percentile(all_dab_times, 0.5)
+    result['dab_p90'] = _percentile(all_dab_times, 0.9)
+    result['dab_p99'] = _percentile(all_dab_times, 0.99)
+
+    print(f"{LOG_KEY}{result}")
+    bpy.ops.wm.quit_blender()
+
+
+if __name__ != '__main__':
+    import api
+
+    class SculptTest(api.Test):
+        def __init__(self, filepath):
+            self.filepath = filepath
+
+        def name(self):
+            return self.filepath.stem
+
+        def category(self):
+            return "sculpt"
+
+        def use_background(self):
+            # Strokes are projected onto the mesh through a 3D viewport.
+            return False
+
+        def run(self, env, device_id):
+            stroke_filepath = self.filepath.with_suffix('.json')
+            args = {'stroke_filepath': str(stroke_filepath) if stroke_filepath.exists() else None}
+            _, log = env.run_in_blender(_run, args, [self.filepath], foreground=True)
+            for line in log:
+                if line.startswith(LOG_KEY):
+                    result_str = line[len(LOG_KEY):]
+                    result = eval(result_str)
+                    return result
+
+            raise Exception("No sculpt performance result found in log.")
+
+    def generate(env):
+        filepaths = env.find_blend_files('sculpt/*')
+        return [SculptTest(filepath) for filepath in filepaths]